@@ -27,12 +27,29 @@ static const std::chrono::milliseconds kCheckConnectivityPeriod(100);
 // Conectivity - GSM
 extern const char* kGsmApn;
 
+// Max time to wait for a USB serial monitor on boot in ENABLE_TRACE builds
+static const std::chrono::seconds kSerialConnectTimeout(2);
+
 // Connection Timeouts
 static const std::chrono::seconds kWifiConnectTimeout(30);
 static const std::chrono::seconds kGsmConnectTimeout(180);
 static const std::chrono::seconds kWebSocketConnectTimeout(30);
 static const std::chrono::minutes kProvisionTimeout(10);
 
+// Telemetry budgets per link type. Readings exceeding them are coalesced
+struct TelemetryBudget {
+  /// Average serialized telemetry bytes per second
+  float bytes_per_second;
+  /// Maximum bytes sent in a burst
+  float byte_burst;
+  /// Average telemetry messages per second
+  float messages_per_second;
+  /// Maximum messages sent in a burst
+  float message_burst;
+};
+static const TelemetryBudget kWifiTelemetryBudget{8192, 32768, 20, 60};
+static const TelemetryBudget kGsmTelemetryBudget{1024, 4096, 2, 10};
+
 #if defined(DEVICE_TYPE_VOC_SENSOR_MK1) ||    \
     defined(DEVICE_TYPE_TIAKI_CO2_MONITOR) || \
     defined(DEVICE_TYPE_FIRE_DATA_LOGGER)
@@ -1,5 +1,7 @@
 #include "managers/action_controller.h"
 
+#include "utils/chrono.h"
+
 namespace inamata {
 
 void ActionController::setServices(ServiceGetters services) {
@@ -10,6 +12,11 @@ void ActionController::handleCallback(const JsonObjectConst& message) {
   JsonVariantConst action = message[WebSocket::action_key_];
   if (!action.isNull()) {
     if (action == action_restart_) {
+#ifdef RTC_MANAGER
+      if (auto logging_manager = services_.getLoggingManager()) {
+        logging_manager->flush();
+      }
+#endif
       services_.getWebSocket()->disconnect();
       delay(500);
       ESP.restart();
@@ -27,11 +34,29 @@ void ActionController::handleCallback(const JsonObjectConst& message) {
   }
 
   JsonVariantConst actions = message[WebSocket::actions_key_];
-#ifdef GSM_NETWORK
   if (!actions.isNull()) {
+    handleSetTimeFormat(actions);
+#ifdef GSM_NETWORK
     handleSetAllowedMnos(actions);
-  }
 #endif
+  }
+}
+
+void ActionController::handleSetTimeFormat(JsonObjectConst actions) {
+  JsonObjectConst set_time_format =
+      actions[set_time_format_key_].as<JsonObjectConst>();
+  if (set_time_format.isNull()) {
+    return;
+  }
+
+  JsonVariantConst format = set_time_format["format"];
+  if (format == time_format_epoch_ms_) {
+    utils::setTimestampFormat(utils::TimestampFormat::kEpochMs);
+  } else if (format == time_format_iso_) {
+    utils::setTimestampFormat(utils::TimestampFormat::kIso);
+  } else {
+    TRACELN("Unknown time format");
+  }
 }
 
 #ifdef GSM_NETWORK
@@ -80,5 +105,8 @@ const char* ActionController::action_clear_stored_resources_ = "clrStrdRes";
 const char* ActionController::action_factory_reset_ = "factoryReset";
 const char* ActionController::action_identify_ = "ident";
 const char* ActionController::set_allowed_mnos_key_ = "setAllowedMnos";
+const char* ActionController::set_time_format_key_ = "setTimeFormat";
+const char* ActionController::time_format_iso_ = "iso";
+const char* ActionController::time_format_epoch_ms_ = "epoch_ms";
 
 }  // namespace inamata
\ No newline at end of file
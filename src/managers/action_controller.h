@@ -17,6 +17,13 @@ class ActionController {
    * \param message Command with the controller action
    */
   void handleCallback(const JsonObjectConst& message);
+
+  /**
+   * Select ISO-8601 or epoch millisecond timestamps for outgoing messages
+   *
+   * \param actions Actions object with the setTimeFormat action
+   */
+  void handleSetTimeFormat(JsonObjectConst actions);
 #ifdef GSM_NETWORK
   void handleSetAllowedMnos(JsonObjectConst actions);
 #endif
@@ -35,6 +42,9 @@ class ActionController {
   static const char* action_factory_reset_;
   static const char* action_identify_;
   static const char* set_allowed_mnos_key_;
+  static const char* set_time_format_key_;
+  static const char* time_format_iso_;
+  static const char* time_format_epoch_ms_;
 };
 
 }  // namespace inamata
\ No newline at end of file
@@ -54,7 +54,9 @@ void BehaviorController::setRegisterData(JsonObject msg) {
     peripheral::fixed::setRegisterFixedPeripherals(msg);
   }
 #ifdef GSM_NETWORK
-  if (!sent_gsm_details && services_.getGsmNetwork()->isEnabled()) {
+  // Skip while sending an SMS, they are added to the next register message
+  if (!sent_gsm_details && services_.getGsmNetwork()->isEnabled() &&
+      !services_.getGsmNetwork()->isSendingSms()) {
     sent_gsm_details = true;
     JsonObject sim_obj = msg["sim"].to<JsonObject>();
     String id = services_.getGsmNetwork()->modem_.getSimCCID();
@@ -552,7 +552,9 @@ void BleImprov::sendMobileStateResponse() {
     return;
   }
   const auto gsm_network = services_.getGsmNetwork();
-  if (gsm_network->cops_scan_ && gsm_network->cops_scan_->active) {
+  // The modem is busy with a scan or an SMS
+  if ((gsm_network->cops_scan_ && gsm_network->cops_scan_->active) ||
+      gsm_network->isSendingSms()) {
     setError(improv::Error::X_ERROR_ALREADY_SCANNING);
     return;
   }
@@ -580,7 +582,8 @@ void BleImprov::sendMobileStateResponse() {
 
 void BleImprov::startGetMobileNetworks(const improv::ImprovCommand& command) {
   const auto gsm_network = services_.getGsmNetwork();
-  if (gsm_network->cops_scan_ && gsm_network->cops_scan_->active) {
+  if ((gsm_network->cops_scan_ && gsm_network->cops_scan_->active) ||
+      gsm_network->isSendingSms()) {
     setError(improv::Error::X_ERROR_ALREADY_SCANNING);
     return;
   }
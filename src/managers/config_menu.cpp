@@ -1143,6 +1143,7 @@ void ConfigManager::handleInput(char input) {
       break;
 #endif
     case '6':
+      logging_manager_->flush();
       LoggingManager::showAllLogs();
       break;
     case '7':
@@ -2,6 +2,8 @@
 
 #include "gsm_network.h"
 
+#include <algorithm>
+
 #include "configuration.h"
 #include "logging.h"
 #include "managers/services.h"
@@ -64,13 +66,25 @@ void GsmNetwork::enable() {
   enterModemConnectMode();
 
   is_enabled_ = true;
+  is_switched_off_ = false;
 }
 
 void GsmNetwork::disable() {
   digitalWrite(peripheral::fixed::gsm_enable_pin, LOW);
 
+  // SMS are only sent over GSM, so drop them instead of holding them until
+  // GSM is enabled again
+  sms_state_ = SmsState::kIdle;
+  sms_job_.active = false;
+  if (!sms_outbox_.empty()) {
+    TRACEF("GSM disabled, dropped %d SMS\r\n", sms_outbox_.size());
+    sms_stats_.failed += sms_outbox_.size();
+    sms_outbox_.clear();
+  }
+
   disconnectModem();
   is_enabled_ = false;
+  is_switched_off_ = true;
 }
 
 bool GsmNetwork::isEnabled() const { return is_enabled_; }
@@ -150,6 +164,10 @@ void GsmNetwork::handleConnection() {
     pollCopsScan();
     return;
   }
+  // Checking the network would read the responses for the SMS
+  if (isSendingSms()) {
+    return;
+  }
 
   const auto now = std::chrono::steady_clock::now();
   if (utils::chrono_abs(now - last_network_check_) > check_period_) {
@@ -241,6 +259,155 @@ String GsmNetwork::encodeSms(const char* text) {
   return gsm7;
 }
 
+bool GsmNetwork::queueSms(const String& number, const String& text) {
+  if (is_switched_off_) {
+    TRACEF("GSM disabled, dropped SMS to %s\r\n", number.c_str());
+    sms_stats_.failed++;
+    return false;
+  }
+  if (sms_outbox_.size() >= kMaxQueuedSms) {
+    TRACEF("SMS outbox full, dropped SMS to %s\r\n", number.c_str());
+    sms_stats_.failed++;
+    return false;
+  }
+  sms_outbox_.push_back({number, text});
+  return true;
+}
+
+void GsmNetwork::handleSmsOutbox() {
+  if (sms_state_ == SmsState::kIdle) {
+    if (sms_outbox_.empty() || !network_connected_ ||
+        (cops_scan_ && cops_scan_->active)) {
+      return;
+    }
+    // Send the first SMS that is not waiting for a retry
+    const auto now = std::chrono::steady_clock::now();
+    auto it = std::find_if(
+        sms_outbox_.begin(), sms_outbox_.end(),
+        [now](const Sms& sms) { return sms.send_after <= now; });
+    if (it == sms_outbox_.end()) {
+      return;
+    }
+    if (it != sms_outbox_.begin()) {
+      Sms sms = std::move(*it);
+      sms_outbox_.erase(it);
+      sms_outbox_.push_front(std::move(sms));
+    }
+    enterSmsState(SmsState::kTextMode, kSmsCommandTimeoutMs);
+    return;
+  }
+
+  if (millis() - sms_job_.started_ms > sms_job_.timeout_ms) {
+    TRACEF("SMS timed out in state: %d\r\n", sms_state_);
+    if (sms_state_ == SmsState::kPrompt) {
+      // Cancel the text input in case the prompt was missed
+      modem_.stream.write(0x1B);
+    }
+    finishSms(false);
+    return;
+  }
+
+  // Let TinyGSM read the responses, so it handles the URCs of the GSM client
+  // that arrive in between. Only wait once the response started arriving
+  if (!modem_.stream.available()) {
+    return;
+  }
+  int8_t response;
+  if (sms_state_ == SmsState::kPrompt) {
+    // The text prompt is not followed by a new line
+    response = modem_.waitResponse(kSmsResponseWaitMs, GF(">"));
+  } else {
+    response = modem_.waitResponse(kSmsResponseWaitMs);
+  }
+  if (response == 0) {
+    // Only URCs or the +CMGS reference, keep waiting
+    return;
+  }
+  if (response != 1) {
+    TRACEF("SMS failed in state: %d\r\n", sms_state_);
+    finishSms(false);
+    return;
+  }
+
+  switch (sms_state_) {
+    case SmsState::kTextMode:
+      enterSmsState(SmsState::kCharacterSet, kSmsCommandTimeoutMs);
+      break;
+    case SmsState::kCharacterSet:
+      enterSmsState(SmsState::kPrompt, kSmsCommandTimeoutMs);
+      break;
+    case SmsState::kPrompt:
+      enterSmsState(SmsState::kResult, kSmsResultTimeoutMs);
+      break;
+    case SmsState::kResult:
+      finishSms(true);
+      break;
+    case SmsState::kIdle:
+      break;
+  }
+}
+
+bool GsmNetwork::isSendingSms() const {
+  return sms_state_ != SmsState::kIdle;
+}
+
+size_t GsmNetwork::getQueuedSmsCount() const { return sms_outbox_.size(); }
+
+void GsmNetwork::enterSmsState(SmsState state, uint32_t timeout_ms) {
+  sms_state_ = state;
+  sms_job_.active = true;
+  sms_job_.started_ms = millis();
+  sms_job_.timeout_ms = timeout_ms;
+  sms_job_.buffer = "";
+
+  const Sms& sms = sms_outbox_.front();
+  switch (state) {
+    case SmsState::kTextMode:
+      modem_.sendAT(GF("+CMGF=1"));
+      break;
+    case SmsState::kCharacterSet:
+      modem_.sendAT(GF("+CSCS=\"GSM\""));
+      break;
+    case SmsState::kPrompt:
+      modem_.sendAT(GF("+CMGS=\""), sms.number, GF("\""));
+      break;
+    case SmsState::kResult:
+      // Send the text and end it with Ctrl+Z
+      modem_.stream.print(sms.text);
+      modem_.stream.write(0x1A);
+      break;
+    case SmsState::kIdle:
+      break;
+  }
+}
+
+void GsmNetwork::finishSms(bool success) {
+  sms_state_ = SmsState::kIdle;
+  sms_job_.active = false;
+  sms_job_.success = success;
+  if (sms_outbox_.empty()) {
+    return;
+  }
+
+  if (success) {
+    sms_stats_.sent++;
+    sms_outbox_.pop_front();
+    return;
+  }
+
+  Sms sms = std::move(sms_outbox_.front());
+  sms_outbox_.pop_front();
+  sms.tries++;
+  if (sms.tries >= kMaxSmsTries) {
+    TRACEF("Dropped SMS to %s\r\n", sms.number.c_str());
+    sms_stats_.failed++;
+    return;
+  }
+  sms_stats_.retries++;
+  sms.send_after = std::chrono::steady_clock::now() + kSmsRetryDelay;
+  sms_outbox_.push_back(std::move(sms));
+}
+
 void GsmNetwork::startCopsScan(CopsScanType scan_type) {
   if (cops_scan_ && cops_scan_->active) {
     return;
@@ -3,6 +3,7 @@
 #include <Arduino.h>
 
 #include <chrono>
+#include <deque>
 #include <memory>
 
 #include "managers/storage.h"
@@ -43,6 +44,13 @@ class GsmNetwork {
 
   enum class CopsScanType { kDefault, kAuto, kGsm, kLte };
 
+  /// Sent, failed and retried SMS since boot
+  struct SmsStats {
+    uint32_t sent = 0;
+    uint32_t failed = 0;
+    uint32_t retries = 0;
+  };
+
   GsmNetwork(std::shared_ptr<Storage> storage);
   ~GsmNetwork() = default;
 
@@ -55,6 +63,8 @@ class GsmNetwork {
 
   /**
    * Disable GSM modem
+   *
+   * Queued SMS are dropped and counted as failed.
    */
   void disable();
 
@@ -93,6 +103,40 @@ class GsmNetwork {
    */
   static String encodeSms(const char* text);
 
+  /**
+   * Queue an SMS to be sent by handleSmsOutbox
+   *
+   * \param number The phone number to send the SMS to
+   * \param text The GSM-7 encoded text
+   * SMS queued before GSM is first enabled wait for it. Once disabled, e.g.
+   * by switching to WiFi, they are dropped.
+   *
+   * \return False if GSM was disabled or the outbox is full and the SMS was
+   *   dropped
+   */
+  bool queueSms(const String& number, const String& text);
+
+  /**
+   * Advance sending the queued SMS without blocking
+   *
+   * Runs the AT+CMGS sequence as a state machine that only reads the modem's
+   * responses once they arrive. The responses are read with TinyGSM, so it
+   * still handles the URCs, such as received data of the GSM client. Failed
+   * SMS are retried after kSmsRetryDelay up to kMaxSmsTries times.
+   */
+  void handleSmsOutbox();
+
+  /**
+   * Whether an SMS is being sent and the modem is busy
+   *
+   * Other AT commands and the GSM client would read the SMS responses, so
+   * all other users of modem_ have to wait until it is done.
+   */
+  bool isSendingSms() const;
+
+  /// Number of SMS waiting to be sent
+  size_t getQueuedSmsCount() const;
+
   void startCopsScan(CopsScanType scan_type = CopsScanType::kDefault);
   void pollCopsScan();
   void clearCopsScan();
@@ -113,6 +157,8 @@ class GsmNetwork {
   std::unique_ptr<AtJob> cops_scan_;
   String cops_result_;
 
+  SmsStats sms_stats_;
+
   bool network_connected_ = false;
   bool gprs_connected_ = false;
   int16_t signal_quality_ = 0;
@@ -134,6 +180,39 @@ class GsmNetwork {
     kDisconnected,
   };
 
+  /// Steps of sending an SMS in text mode
+  enum class SmsState {
+    kIdle,
+    kTextMode,
+    kCharacterSet,
+    kPrompt,
+    kResult,
+  };
+
+  struct Sms {
+    String number;
+    String text;
+    uint8_t tries = 0;
+    /// Earliest time to send the SMS, set after a failed attempt
+    std::chrono::steady_clock::time_point send_after =
+        std::chrono::steady_clock::time_point::min();
+  };
+
+  /**
+   * Send the AT command for the next step and wait for its response
+   *
+   * \param state The step to enter
+   * \param timeout_ms Max time to wait for the response
+   */
+  void enterSmsState(SmsState state, uint32_t timeout_ms);
+
+  /**
+   * Finish the current SMS and retry it later if it failed
+   *
+   * \param success Whether the modem confirmed the SMS
+   */
+  void finishSms(bool success);
+
   /**
    * Attempt to connect to MNO in the allowed list
    *
@@ -174,6 +253,22 @@ class GsmNetwork {
   std::shared_ptr<Storage> storage_;
 
   bool is_enabled_ = false;
+  /// Whether disable was called, unlike is_enabled_ not set before booting it
+  bool is_switched_off_ = false;
+
+  /// SMS waiting to be sent. The front is sent first
+  std::deque<Sms> sms_outbox_;
+  SmsState sms_state_ = SmsState::kIdle;
+  /// The response of the current SMS step
+  AtJob sms_job_;
+  static constexpr size_t kMaxQueuedSms = 32;
+  static constexpr uint8_t kMaxSmsTries = 3;
+  static constexpr std::chrono::seconds kSmsRetryDelay{30};
+  static constexpr uint32_t kSmsCommandTimeoutMs = 5000;
+  /// The network may take up to a minute to accept the SMS
+  static constexpr uint32_t kSmsResultTimeoutMs = 60000;
+  /// Max time to wait for the rest of a response once it started arriving
+  static constexpr uint32_t kSmsResponseWaitMs = 20;
 
   ConnectionState connection_state_ = ConnectionState::kIdle;
   /// List of Mobile Network Operators it's allowed to connect to (MCC/MNC)
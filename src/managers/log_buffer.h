@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace inamata {
+
+/**
+ * RAM buffer of log entries that are written to flash in batches
+ *
+ * The buffer is due once it holds max_size entries or its oldest entry is
+ * older than max_age. Consecutive entries of the same log file are passed to
+ * the writer together, so each file is only opened once per batch.
+ *
+ * \tparam Entry A buffered log entry
+ */
+template <typename Entry>
+class LogBuffer {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Iterator = typename std::vector<Entry>::const_iterator;
+
+  /**
+   * \param max_size Number of entries that fill the buffer
+   * \param max_age Time after which the oldest entry is due to be written
+   */
+  LogBuffer(size_t max_size, Clock::duration max_age)
+      : max_size_(max_size), max_age_(max_age) {}
+
+  /**
+   * Add an entry to the buffer
+   *
+   * \param entry The entry to add
+   * \param now Time the entry is added at
+   * \return True if the buffer is full and should be flushed
+   */
+  bool add(Entry entry, Clock::time_point now) {
+    if (entries_.empty()) {
+      entries_.reserve(max_size_);
+      oldest_at_ = now;
+    }
+    entries_.push_back(std::move(entry));
+    return entries_.size() >= max_size_;
+  }
+
+  /**
+   * Whether the oldest entry is older than the max age
+   *
+   * \param now Current time
+   * \return True if the buffer should be flushed
+   */
+  bool isExpired(Clock::time_point now) const {
+    return !entries_.empty() && now - oldest_at_ > max_age_;
+  }
+
+  /**
+   * Pass the runs of entries of the same file to a writer and clear the buffer
+   *
+   * \param is_same_file Whether two entries belong to the same log file
+   * \param write Called with the first and past-the-end entry of each run
+   */
+  template <typename SameFile, typename Write>
+  void flush(SameFile is_same_file, Write write) {
+    Iterator run_start = entries_.cbegin();
+    while (run_start != entries_.cend()) {
+      Iterator run_end = run_start;
+      while (run_end != entries_.cend() && is_same_file(*run_start, *run_end)) {
+        run_end++;
+      }
+      write(run_start, run_end);
+      run_start = run_end;
+    }
+    entries_.clear();
+  }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  size_t max_size_;
+  Clock::duration max_age_;
+  std::vector<Entry> entries_;
+  /// When the oldest entry in the buffer was added
+  Clock::time_point oldest_at_;
+};
+
+}  // namespace inamata
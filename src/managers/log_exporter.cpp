@@ -0,0 +1,205 @@
+#ifdef RTC_MANAGER
+
+#include "log_exporter.h"
+
+namespace inamata {
+
+LogExporter::LogExporter(Scheduler& scheduler)
+    : BaseTask(scheduler, Input(nullptr, true)) {}
+
+const String& LogExporter::getType() const { return type(); }
+
+const String& LogExporter::type() {
+  static const String name{"LogExporter"};
+  return name;
+}
+
+void LogExporter::setServices(ServiceGetters services) { services_ = services; }
+
+void LogExporter::handleCallback(const JsonObjectConst& message) {
+  JsonVariantConst logs_command = message[logs_command_key_];
+  if (!logs_command) {
+    return;
+  }
+
+  // Continue with the next chunk once the last sent one was acknowledged
+  JsonVariantConst ack = logs_command[ack_key_];
+  if (!ack.isNull()) {
+    if (is_waiting_for_ack_ && ack.as<uint32_t>() == sequence_) {
+      is_waiting_for_ack_ = false;
+      forceNextIteration();
+    }
+    return;
+  }
+
+  const char* request_id =
+      message[WebSocket::request_id_key_].as<const char*>();
+  if (is_exporting_) {
+    sendResult(status_fail_, export_in_progress_error_, request_id);
+    return;
+  }
+
+  JsonVariantConst start = logs_command[start_key_];
+  if (!start.is<uint32_t>()) {
+    sendResult(status_fail_,
+               ErrorStore::genMissingProperty(start_key_,
+                                              ErrorStore::KeyType::kUint32t),
+               request_id);
+    return;
+  }
+  JsonVariantConst end = logs_command[end_key_];
+  if (!end.is<uint32_t>()) {
+    sendResult(status_fail_,
+               ErrorStore::genMissingProperty(end_key_,
+                                              ErrorStore::KeyType::kUint32t),
+               request_id);
+    return;
+  }
+  std::shared_ptr<LoggingManager> logging_manager =
+      services_.getLoggingManager();
+  if (logging_manager == nullptr) {
+    sendResult(status_fail_, ServiceGetters::log_manager_nullptr_error_,
+               request_id);
+    return;
+  }
+
+  request_id_ = request_id;
+  start_ = start;
+  end_ = end;
+  cursor_ = logging_manager->seekLogs(start_);
+  sequence_ = 0;
+  is_waiting_for_ack_ = false;
+  is_exporting_ = true;
+  chunk_.reserve(kMaxChunkRecords);
+
+  setIterations(TASK_FOREVER);
+  enable();
+}
+
+bool LogExporter::TaskCallback() {
+  Task::delay(std::chrono::milliseconds(default_interval_).count());
+
+  std::shared_ptr<WebSocket> web_socket = services_.getWebSocket();
+  if (web_socket == nullptr || !web_socket->isConnected()) {
+    TRACELN(connection_lost_error_);
+    return false;
+  }
+
+  if (is_waiting_for_ack_) {
+    if (std::chrono::steady_clock::now() - chunk_sent_at_ > kAckTimeout) {
+      sendResult(status_fail_, ack_timeout_error_);
+      return false;
+    }
+    return true;
+  }
+
+  // Stop after the last chunk without waiting for its acknowledgement
+  const bool is_last = readChunk();
+  sendChunk(is_last);
+  return !is_last;
+}
+
+void LogExporter::OnTaskDisable() {
+  chunk_.clear();
+  chunk_.shrink_to_fit();
+
+  request_id_.clear();
+  cursor_.date.clear();
+  is_waiting_for_ack_ = false;
+  is_exporting_ = false;
+}
+
+bool LogExporter::readChunk() {
+  chunk_.clear();
+  std::shared_ptr<LoggingManager> logging_manager =
+      services_.getLoggingManager();
+  if (logging_manager == nullptr) {
+    return true;
+  }
+
+  // Continue after the last read record instead of searching it by time
+  return logging_manager->readLogs(
+      cursor_, start_, end_, [this](const LoggingManager::LogRecord& record) {
+        chunk_.push_back(record);
+        return chunk_.size() < kMaxChunkRecords;
+      });
+}
+
+void LogExporter::sendChunk(bool is_last) {
+  std::shared_ptr<WebSocket> web_socket = services_.getWebSocket();
+  if (web_socket == nullptr) {
+    TRACELN(ErrorResult(type(), ServiceGetters::web_socket_nullptr_error_)
+                .toString());
+    return;
+  }
+
+  JsonDocument doc_out;
+  doc_out[WebSocket::type_key_] = WebSocket::result_type_;
+  if (!request_id_.isEmpty()) {
+    doc_out[WebSocket::request_id_key_] = request_id_.c_str();
+  }
+
+  JsonObject logs_result = doc_out[logs_command_key_].to<JsonObject>();
+  logs_result[status_key_] = is_last ? status_finish_ : status_chunk_;
+  logs_result[sequence_key_] = ++sequence_;
+
+  // Each record as [time, input, state, type]
+  JsonArray records = logs_result[records_key_].to<JsonArray>();
+  for (const LoggingManager::LogRecord& record : chunk_) {
+    JsonArray record_array = records.add<JsonArray>();
+    record_array.add(uint32_t(record.time));
+    record_array.add(record.input);
+    record_array.add(record.state);
+    record_array.add(uint8_t(record.type));
+  }
+
+  web_socket->sendResults(doc_out.as<JsonObject>());
+  is_waiting_for_ack_ = true;
+  chunk_sent_at_ = std::chrono::steady_clock::now();
+}
+
+void LogExporter::sendResult(const char* status, const String& detail,
+                             const char* request_id) {
+  std::shared_ptr<WebSocket> web_socket = services_.getWebSocket();
+  if (web_socket == nullptr) {
+    TRACELN(ErrorResult(type(), ServiceGetters::web_socket_nullptr_error_)
+                .toString());
+    return;
+  }
+
+  JsonDocument doc_out;
+  doc_out[WebSocket::type_key_] = WebSocket::result_type_;
+  // Favor request ID from parameters over class member. Ignore if none given
+  if (request_id != nullptr) {
+    doc_out[WebSocket::request_id_key_] = request_id;
+  } else if (!request_id_.isEmpty()) {
+    doc_out[WebSocket::request_id_key_] = request_id_.c_str();
+  }
+
+  JsonObject logs_result = doc_out[logs_command_key_].to<JsonObject>();
+  logs_result[status_key_] = status;
+  if (!detail.isEmpty()) {
+    logs_result[detail_key_] = detail.c_str();
+  }
+  web_socket->sendResults(doc_out.as<JsonObject>());
+}
+
+const char* LogExporter::logs_command_key_ = "logs";
+const char* LogExporter::start_key_ = "start";
+const char* LogExporter::end_key_ = "end";
+const char* LogExporter::ack_key_ = "ack";
+const char* LogExporter::sequence_key_ = "seq";
+const char* LogExporter::records_key_ = "records";
+
+const char* LogExporter::status_key_ = "status";
+const char* LogExporter::status_chunk_ = "chunk";
+const char* LogExporter::status_finish_ = "finish";
+const char* LogExporter::status_fail_ = "fail";
+const char* LogExporter::detail_key_ = "detail";
+const char* LogExporter::export_in_progress_error_ = "Export in progress";
+const char* LogExporter::ack_timeout_error_ = "Ack timeout";
+const char* LogExporter::connection_lost_error_ = "Connection lost";
+
+}  // namespace inamata
+
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include <chrono>
+#include <vector>
+
+#include "managers/log_manager.h"
+#include "managers/service_getters.h"
+#include "tasks/base_task.h"
+#include "utils/error_store.h"
+
+namespace inamata {
+
+/**
+ * Service to stream log records to the server
+ *
+ * The records of the requested time range are sent in chunks of up to
+ * kMaxChunkRecords. The next chunk is only read and sent after the server
+ * acknowledged the previous one, so only one chunk is held in memory and the
+ * export shares the scheduler with the telemetry and alarm tasks.
+ *
+ * Start: {"logs": {"start": <epoch s>, "end": <epoch s>}, "request_id": "..."}
+ * Ack:   {"logs": {"ack": <seq>}}
+ */
+class LogExporter : public tasks::BaseTask {
+ public:
+  LogExporter(Scheduler& scheduler);
+  virtual ~LogExporter() = default;
+
+  const String& getType() const final;
+  static const String& type();
+
+  void setServices(ServiceGetters services);
+
+  /**
+   * Handle the commands to start an export and acknowledge chunks
+   *
+   * \param message Command with the time range or acknowledged chunk
+   */
+  void handleCallback(const JsonObjectConst& message);
+
+  /**
+   * Send the next chunk once the previous one was acknowledged
+   */
+  bool TaskCallback();
+
+  /**
+   * Free the chunk buffer and allow the next export
+   */
+  void OnTaskDisable();
+
+  /// Max records per chunk (~2 kB serialized)
+  static constexpr uint8_t kMaxChunkRecords = 64;
+
+ private:
+  /**
+   * Read the next records from the cursor on into the chunk buffer
+   *
+   * \return True if all records of the range have been read
+   */
+  bool readChunk();
+
+  void sendChunk(bool is_last);
+
+  void sendResult(const char* status, const String& detail = "",
+                  const char* request_id = nullptr);
+
+  ServiceGetters services_;
+
+  /// The request ID used by the export command
+  String request_id_;
+
+  /// A lock when an export is in progress
+  bool is_exporting_ = false;
+
+  /// The requested time range in seconds since the Unix epoch
+  uint32_t start_ = 0;
+  uint32_t end_ = 0;
+
+  /// Position of the record after the last read one
+  LoggingManager::LogCursor cursor_;
+
+  /// Sequence number of the last sent chunk
+  uint32_t sequence_ = 0;
+  bool is_waiting_for_ack_ = false;
+  std::chrono::steady_clock::time_point chunk_sent_at_;
+
+  std::vector<LoggingManager::LogRecord> chunk_;
+
+  static constexpr std::chrono::seconds kAckTimeout{30};
+  static constexpr std::chrono::milliseconds default_interval_{50};
+
+  static const char* logs_command_key_;
+  static const char* start_key_;
+  static const char* end_key_;
+  static const char* ack_key_;
+  static const char* sequence_key_;
+  static const char* records_key_;
+
+  static const char* status_key_;
+  static const char* status_chunk_;
+  static const char* status_finish_;
+  static const char* status_fail_;
+  static const char* detail_key_;
+  static const char* export_in_progress_error_;
+  static const char* ack_timeout_error_;
+  static const char* connection_lost_error_;
+};
+
+}  // namespace inamata
@@ -3,9 +3,12 @@
 #include "log_manager.h"
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
 #include <LittleFS.h>
 
 #include <algorithm>
+#include <chrono>
+#include <iterator>
 #include <vector>
 
 #include "managers/logging.h"
@@ -14,6 +17,22 @@
 
 namespace inamata {
 
+namespace {
+
+/**
+ * @brief Check if a directory is a daily log directory.
+ *
+ * @param name The directory name.
+ * @return True if the name is a YYYYMMDD date.
+ */
+bool isLogDirName(const char* name) {
+  char* endptr;
+  strtoul(name, &endptr, 10);
+  return *endptr == '\0';
+}
+
+}  // namespace
+
 /**
  * @brief LoggingManager constructor
  *
@@ -28,7 +47,7 @@ namespace inamata {
  * @note The log directory name is based on the current date in the format
  * YYYYMMDD.
  *
- * @note The log file name format is /logs/fdl/YYYYMMDD/N.log, where N is the
+ * @note The log file name format is /logs/fdl/YYYYMMDD/N.bin, where N is the
  * next available file number.
  */
 LoggingManager::LoggingManager() : file_number_(0), log_count_(0) {
@@ -55,9 +74,11 @@ LoggingManager::LoggingManager() : file_number_(0), log_count_(0) {
   // Find the log file name to start from the next available number.
   do {
     file_number_++;
-    snprintf(buffer, sizeof(buffer), "%s/%s/%d.log", LoggingManager::root_path_,
+    snprintf(buffer, sizeof(buffer), "%s/%s/%d.bin", LoggingManager::root_path_,
              TimeManager::getCurrentDate().c_str(), file_number_);
   } while (LittleFS.exists(buffer));
+
+  loadLogIndex();
 }
 
 /**
@@ -77,75 +98,212 @@ void LoggingManager::rotateLogFile() {
  * Deletes log files if the total storage exceeds kMaxTotalLogBytes. All log
  * files for the oldest day will deleted if the size is exceeded.
  *
- * The log file name format is /logs/fdl/YYYYMMDD/N.log, where N is the next
- * available file number.
+ * The sizes are taken from the per-day log index instead of walking all log
+ * files, so the cost does not grow with the retained history.
  *
  * @note The log directory name is based on the current date in the format
  * YYYYMMDD.
  */
 void LoggingManager::deleteOldLogs() {
+  size_t total_log_size = 0;
+  for (const auto& day_log_bytes : day_log_bytes_) {
+    total_log_size += day_log_bytes.second;
+  }
+  TRACEF("Total log size: %u\r\n", total_log_size);
+
+  if (total_log_size > kMaxTotalLogBytes && !day_log_bytes_.empty()) {
+    // Dates in the YYYYMMDD format sort chronologically
+    auto oldest_day = day_log_bytes_.begin();
+    String delete_path =
+        String(LoggingManager::root_path_) + '/' + oldest_day->first;
+    TRACEF("Deleting %s\r\n", delete_path.c_str());
+    Storage::recursiveRm(delete_path.c_str());
+    day_log_bytes_.erase(oldest_day);
+    is_log_index_dirty_ = true;
+  }
+
+  // Persist the sizes of the flushes since the last save
+  if (is_log_index_dirty_) {
+    saveLogIndex();
+  }
+}
+
+/**
+ * @brief Load the per-day log size index.
+ *
+ * Rebuilds the index by walking the log directories if it is missing, can't
+ * be parsed or doesn't list the same days as the log directory. As the index
+ * isn't saved on every flush, the size of the newest day is recounted.
+ */
+void LoggingManager::loadLogIndex() {
+  day_log_bytes_.clear();
+
+  fs::File file = LittleFS.open(LoggingManager::index_path_, FILE_READ);
+  if (!file) {
+    rebuildLogIndex();
+    return;
+  }
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  if (error || !doc.is<JsonObjectConst>()) {
+    TRACEF("Invalid log index: %s\r\n", error.c_str());
+    rebuildLogIndex();
+    return;
+  }
+  for (JsonPairConst day : doc.as<JsonObjectConst>()) {
+    day_log_bytes_[day.key().c_str()] = day.value().as<uint32_t>();
+  }
+
+  // Compare the indexed days with the daily log directories
+  size_t log_dir_count = 0;
+  File root = LittleFS.open(LoggingManager::root_path_);
+  if (root && root.isDirectory()) {
+    for (File log_dir = root.openNextFile(); log_dir;
+         log_dir = root.openNextFile()) {
+      if (!log_dir.isDirectory() || !isLogDirName(log_dir.name())) {
+        continue;
+      }
+      if (!day_log_bytes_.count(log_dir.name())) {
+        TRACEF("Log dir not indexed: %s\r\n", log_dir.name());
+        root.close();
+        rebuildLogIndex();
+        return;
+      }
+      log_dir_count++;
+    }
+  }
+  root.close();
+  if (log_dir_count != day_log_bytes_.size()) {
+    TRACELN("Indexed log dirs missing");
+    rebuildLogIndex();
+    return;
+  }
+
+  if (!day_log_bytes_.empty()) {
+    auto newest_day = std::prev(day_log_bytes_.end());
+    const uint32_t day_size = sumDayLogBytes(newest_day->first);
+    if (day_size != newest_day->second) {
+      newest_day->second = day_size;
+      is_log_index_dirty_ = true;
+    }
+  }
+}
+
+/**
+ * @brief Rebuild the per-day log size index.
+ *
+ * Sums the size of all log files per daily log directory and saves the
+ * result. Only required if the index is missing or inconsistent.
+ */
+void LoggingManager::rebuildLogIndex() {
+  day_log_bytes_.clear();
+
   File root = LittleFS.open(LoggingManager::root_path_, "r+");
   if (!root || !root.isDirectory()) {
     TRACEF("Can't open dir %s\r\n", LoggingManager::root_path_);
     root.close();
     return;
   }
-  long oldest_date = 0;
-  size_t total_log_size = 0;
 
-  // Calculate the total log file sizes, keep track of the oldest directory
   for (File log_dir = root.openNextFile(); log_dir;
        log_dir = root.openNextFile()) {
     if (!log_dir.isDirectory()) {
       continue;
     }
-    char* endptr;
-    const long date_int = strtoul(log_dir.name(), &endptr, 10);
-    if (*endptr != '\0') {
+    if (!isLogDirName(log_dir.name())) {
       TRACEF("Parsing date to int failed for %s\r\n", log_dir.name());
       continue;
     }
-    if (oldest_date == 0) {
-      oldest_date = date_int;
-      TRACEF("Init oldest_date: %lu\r\n", oldest_date);
-    } else if (oldest_date > date_int) {
-      TRACEF("Update oldest_date %lu -> %lu\r\n", oldest_date, date_int);
-      oldest_date = date_int;
-    }
+    day_log_bytes_[log_dir.name()] = sumDayLogBytes(log_dir.name());
+  }
+  root.close();
 
-    // Sum the size of all logs for a given day
-    for (File log_file = log_dir.openNextFile(); log_file;
-         log_file = log_dir.openNextFile()) {
-      if (log_file.isDirectory()) {
-        TRACEF("Unexpected dir: %s\r\n", log_file.path());
-        continue;
-      }
-      total_log_size += log_file.size();
+  saveLogIndex();
+}
+
+/**
+ * @brief Sum the size of all log files of a day.
+ *
+ * @param date The YYYYMMDD log directory.
+ * @return The size of all log files in bytes.
+ */
+uint32_t LoggingManager::sumDayLogBytes(const String& date) {
+  const String dir_path = String(LoggingManager::root_path_) + '/' + date;
+  File log_dir = LittleFS.open(dir_path);
+  if (!log_dir || !log_dir.isDirectory()) {
+    return 0;
+  }
+
+  uint32_t day_size = 0;
+  for (File log_file = log_dir.openNextFile(); log_file;
+       log_file = log_dir.openNextFile()) {
+    if (log_file.isDirectory()) {
+      TRACEF("Unexpected dir: %s\r\n", log_file.path());
+      continue;
     }
-    TRACEF("Total log size: %lu\r\n", total_log_size);
+    day_size += log_file.size();
   }
+  log_dir.close();
+  return day_size;
+}
 
-  if (total_log_size > kMaxTotalLogBytes) {
-    String delete_path =
-        String(LoggingManager::root_path_) + '/' + String(oldest_date);
-    TRACEF("Deleting %s\r\n", delete_path.c_str());
-    Storage::recursiveRm(delete_path.c_str());
+/**
+ * @brief Save the per-day log size index.
+ */
+void LoggingManager::saveLogIndex() {
+  JsonDocument doc;
+  for (const auto& day_log_bytes : day_log_bytes_) {
+    doc[day_log_bytes.first] = day_log_bytes.second;
   }
-  root.close();
+
+  fs::File file = LittleFS.open(LoggingManager::index_path_, FILE_WRITE);
+  if (!file) {
+    Serial.println("Failed to open log index");
+    return;
+  }
+  serializeJson(doc, file);
+  file.close();
+  is_log_index_dirty_ = false;
 }
 
 /**
- * @brief Add a log entry.
+ * @brief Render a log record as text.
  *
- * Adds a log entry to the log file. The log entry format is
- * YYYY-MM-DDTHH:MM:SS,Input,State
+ * Creates the same lines as the former text log files.
  *
+ * @param record The record to render.
+ * @return The log line in the format YYYY-MM-DDTHH:MM:SS,Input,State
+ */
+String LoggingManager::toString(const LogRecord& record) {
+  String line = TimeManager::getFormattedTime(DateTime(record.time));
+  switch (record.type) {
+    case LogRecord::Type::kPowerOn:
+      line += ",Power on";
+      break;
+    case LogRecord::Type::kInput:
+      line += ",I";
+      line += record.input;
+      line += record.state ? ",ON" : ",OFF";
+      break;
+  }
+  return line;
+}
+
+/**
+ * @brief Add a log record.
  *
+ * Adds a log record to the RAM log buffer. The target log file is determined
+ * when the record is added, so the rotation after kMaxLogEntries is
+ * independent of when the buffer is flushed.
  *
- * @param event The event to log.
+ * @param type The type of the logged event.
+ * @param input The input number for input events.
+ * @param state The input state for input events.
+ * @param flush Whether to immediately write all buffered entries.
  */
-void LoggingManager::addLog(const String& event) {
-  char buffer[128];
+void LoggingManager::addLog(LogRecord::Type type, uint8_t input, bool state,
+                            bool flush) {
   DateTime now;
   if (TimeManager::lostPower()) {
     now = millis() / 1000 + SECONDS_FROM_1970_TO_2000;
@@ -153,65 +311,221 @@ void LoggingManager::addLog(const String& event) {
     now = TimeManager::systemTime();
   }
 
-  // Create the daily log directory if it doesn't exist
-  snprintf(buffer, sizeof(buffer), "%s/%s", LoggingManager::root_path_,
-           TimeManager::getCurrentDate(now).c_str());
-  if (!LittleFS.exists(buffer)) {
-    if (!LittleFS.mkdir(buffer)) {
+  const LogRecord record{now.unixtime(), input, state, type, 0};
+  if (enable_real_time_logs) {
+    Serial.println(toString(record));
+  }
+
+#ifdef ENABLE_TRACE
+  Serial.print("Log Entry: ");
+  Serial.println(toString(record));
+#endif
+
+  const bool is_full = log_buffer_.add(
+      {TimeManager::getCurrentDate(now), file_number_, now.hour(), record},
+      std::chrono::steady_clock::now());
+
+  log_count_++;
+  if (log_count_ >= kMaxLogEntries) {
+    rotateLogFile();
+  }
+
+  if (flush || is_full) {
+    this->flush();
+  }
+}
+
+/**
+ * @brief Flush the log buffer if the oldest entry is too old.
+ */
+void LoggingManager::handle() {
+  if (log_buffer_.isExpired(std::chrono::steady_clock::now())) {
+    flush();
+  }
+}
+
+/**
+ * @brief Write all buffered log entries.
+ *
+ * Consecutive entries for the same daily directory and file number are
+ * written with a single open and close of the log file. The hour index of the
+ * day is updated with the position of the first record in each hour. The log
+ * size index is only saved when a new day is started.
+ */
+void LoggingManager::flush() {
+  char buffer[128];
+  bool is_new_day = false;
+
+  using Iterator = LogBuffer<BufferedLog>::Iterator;
+  const auto is_same_file = [](const BufferedLog& a, const BufferedLog& b) {
+    return a.date == b.date && a.file_num == b.file_num;
+  };
+  log_buffer_.flush(is_same_file, [&](Iterator first, Iterator last) {
+    // Create the daily log directory if it doesn't exist
+    snprintf(buffer, sizeof(buffer), "%s/%s", LoggingManager::root_path_,
+             first->date.c_str());
+    if (!LittleFS.exists(buffer) && !LittleFS.mkdir(buffer)) {
       Serial.println("Failed to create daily log directory:");
       Serial.println(buffer);
       return;
     }
-  }
 
-  // Open or create file to write log into
-  snprintf(buffer, sizeof(buffer), "%s/%s/%d.log", LoggingManager::root_path_,
-           TimeManager::getCurrentDate(now).c_str(), file_number_);
-  fs::File file = LittleFS.open(buffer, FILE_APPEND);
-  if (!file) {
-    file = LittleFS.open(buffer, FILE_WRITE);
+    // Open or create file to write logs into
+    snprintf(buffer, sizeof(buffer), "%s/%s/%d.bin", LoggingManager::root_path_,
+             first->date.c_str(), first->file_num);
+    fs::File file = LittleFS.open(buffer, FILE_APPEND);
+    if (!file) {
+      file = LittleFS.open(buffer, FILE_WRITE);
+    }
     if (!file) {
       Serial.println("Failed to open log file");
       Serial.println(buffer);
       return;
     }
-  }
 
 #ifdef ENABLE_TRACE
-  Serial.print("Current Log File: ");
-  Serial.println(buffer);
+    Serial.print("Current Log File: ");
+    Serial.println(buffer);
 #endif
 
-  String logEntry = TimeManager::getFormattedTime(now) + "," + event;
-  file.println(logEntry.c_str());
-  if (enable_real_time_logs) {
-    Serial.println(logEntry);
+    if (hour_index_date_ != first->date) {
+      hour_index_ = loadHourIndex(first->date);
+      hour_index_date_ = first->date;
+    }
+
+    bool hour_index_changed = false;
+    uint16_t record_num = file.size() / sizeof(LogRecord);
+    size_t bytes_written = 0;
+    for (auto it = first; it != last; it++) {
+      LogPosition& hour_entry = hour_index_[it->hour];
+      if (hour_entry.file_num == kNoRecord) {
+        hour_entry = {uint16_t(it->file_num), record_num};
+        hour_index_changed = true;
+      }
+      bytes_written += file.write(reinterpret_cast<const uint8_t*>(&it->record),
+                                  sizeof(LogRecord));
+      record_num++;
+    }
+    file.close();
+    // Save the index on day rollovers. Else it's saved by deleteOldLogs
+    if (!day_log_bytes_.count(first->date)) {
+      is_new_day = true;
+    }
+    day_log_bytes_[first->date] += bytes_written;
+    is_log_index_dirty_ = true;
+    if (hour_index_changed) {
+      saveHourIndex(first->date, hour_index_);
+    }
+  });
+
+  if (is_new_day) {
+    saveLogIndex();
   }
+}
 
-#ifdef ENABLE_TRACE
-  Serial.print("Log Entry: ");
-  Serial.println(logEntry);
-#endif
+/**
+ * @brief Get log records within a time range.
+ *
+ * Only the daily log directories within the range are read. For the first
+ * day, reading starts at the lowest indexed record of the start hour and the
+ * later hours.
+ *
+ * @param start Start of the range in seconds since the Unix epoch.
+ * @param end Inclusive end of the range in seconds since the Unix epoch.
+ * @param callback Called for each record. Return false to stop.
+ */
+void LoggingManager::queryLogs(uint32_t start, uint32_t end,
+                               LogRecordCallback callback) {
+  if (start > end) {
+    return;
+  }
+  LogCursor cursor = seekLogs(start);
+  readLogs(cursor, start, end, callback);
+}
 
-  file.close();
+/**
+ * @brief Get a cursor to the first record of a query.
+ *
+ * Starts at the lowest indexed record of the start hour and the later hours
+ * of the start day, else at the first record of the next day with records.
+ *
+ * @param start Start of the range in seconds since the Unix epoch.
+ * @return The cursor for readLogs.
+ */
+LoggingManager::LogCursor LoggingManager::seekLogs(uint32_t start) {
+  // Include the buffered entries in the hour index
+  flush();
+
+  const DateTime start_time(start);
+  const String start_date = TimeManager::getCurrentDate(start_time);
+  if (day_log_bytes_.count(start_date)) {
+    const LogPosition position =
+        firstLogPosition(loadHourIndex(start_date), start_time.hour());
+    if (position.file_num != kNoRecord) {
+      return {start_date, position};
+    }
+  }
+  return seekNextDay(start_date);
+}
 
-  log_count_++;
-  if (log_count_ >= kMaxLogEntries) {
-    rotateLogFile();
+/**
+ * @brief Continue a query at a cursor.
+ *
+ * Reads the daily log directories from the cursor on until the end date or
+ * until the callback stops the query.
+ *
+ * @param cursor The position to continue at. Advanced past every read record.
+ * @param start Start of the range in seconds since the Unix epoch.
+ * @param end Inclusive end of the range in seconds since the Unix epoch.
+ * @param callback Called for each record. Return false to stop.
+ * @return True if all records of the range have been read.
+ */
+bool LoggingManager::readLogs(LogCursor& cursor, uint32_t start, uint32_t end,
+                              LogRecordCallback callback) {
+  flush();
+
+  const String end_date = TimeManager::getCurrentDate(DateTime(end));
+  while (!cursor.date.isEmpty() && cursor.date <= end_date) {
+    if (!readDayLogs(cursor.date, cursor.position, start, end, callback)) {
+      return false;
+    }
+    cursor = seekNextDay(cursor.date);
   }
+  return true;
+}
+
+/**
+ * @brief Get a cursor to the first record after a day.
+ *
+ * Daily log directories are listed in the size index in date order.
+ *
+ * @param date The YYYYMMDD log directory to skip.
+ * @return The cursor or an empty date if there are no later records.
+ */
+LoggingManager::LogCursor LoggingManager::seekNextDay(const String& date) {
+  for (auto day = day_log_bytes_.upper_bound(date); day != day_log_bytes_.end();
+       day++) {
+    const LogPosition position = firstLogPosition(loadHourIndex(day->first), 0);
+    if (position.file_num != kNoRecord) {
+      return {day->first, position};
+    }
+  }
+  return {String(), {kNoRecord, kNoRecord}};
 }
 
 /**
  * @brief Show the logs.
  *
  * Reads and prints the log file to the serial console. The log file name
- * format is /logs/fdl/YYYYMMDD/N.log, where N is the next available file
+ * format is /logs/fdl/YYYYMMDD/N.bin, where N is the next available file
  * number.
  */
 void LoggingManager::showCurrentLog() {
   char buffer[96];
 
-  snprintf(buffer, sizeof(buffer), "%s/%s/%d.log", LoggingManager::root_path_,
+  flush();
+
+  snprintf(buffer, sizeof(buffer), "%s/%s/%d.bin", LoggingManager::root_path_,
            TimeManager::getCurrentDate().c_str(), file_number_);
 
   fs::File file = LittleFS.open(buffer, FILE_READ);
@@ -220,8 +534,10 @@ void LoggingManager::showCurrentLog() {
     return;
   }
 
-  while (file.available()) {
-    Serial.println(file.readStringUntil('\n'));
+  LogRecord record;
+  while (file.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) ==
+         sizeof(record)) {
+    Serial.println(toString(record));
   }
 
   file.close();
@@ -276,11 +592,13 @@ std::vector<LoggingManager::LogPath> LoggingManager::getAllLogPaths() {
     while ((log_file = date_dir.openNextFile())) {
       String name = log_file.name();
 
-      if (name.endsWith(".log")) {
-        int file_num = name.substring(0, name.indexOf(".log")).toInt();
+      const bool is_binary = name.endsWith(".bin");
+      if (is_binary || name.endsWith(".log")) {
+        int file_num = name.substring(0, name.indexOf('.')).toInt();
         LogPath lp;
         lp.date_time = date_dir.name();
         lp.file_num = file_num;
+        lp.is_binary = is_binary;
         paths.push_back(lp);
       }
 
@@ -303,7 +621,8 @@ std::vector<LoggingManager::LogPath> LoggingManager::getAllLogPaths() {
  * @brief Show all logs.
  *
  * Reads and prints all log files in the log directory to the serial
- * console.
+ * console. Binary log files are rendered as text lines and legacy text log
+ * files are printed as is.
  */
 void LoggingManager::showAllLogs() {
   auto logPaths = getAllLogPaths();
@@ -317,16 +636,131 @@ void LoggingManager::showAllLogs() {
       continue;
     }
 
-    while (f.available()) {
-      String line = f.readStringUntil('\n');
-      Serial.println(line);
+    if (log.is_binary) {
+      LogRecord record;
+      while (f.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) ==
+             sizeof(record)) {
+        Serial.println(toString(record));
+      }
+    } else {
+      while (f.available()) {
+        String line = f.readStringUntil('\n');
+        Serial.println(line);
+      }
     }
 
     f.close();
   }
 }
 
+/**
+ * @brief Load the hour index of a day.
+ *
+ * @param date The YYYYMMDD log directory.
+ * @return The hour index. Hours without records are set to kNoRecord.
+ */
+HourIndex LoggingManager::loadHourIndex(const String& date) {
+  HourIndex hour_index;
+  hour_index.fill({kNoRecord, kNoRecord});
+
+  const String path = String(LoggingManager::root_path_) + '/' + date + '/' +
+                      LoggingManager::hour_index_name_;
+  fs::File file = LittleFS.open(path, FILE_READ);
+  if (!file) {
+    return hour_index;
+  }
+  HourIndex stored;
+  if (file.read(reinterpret_cast<uint8_t*>(stored.data()), sizeof(stored)) ==
+      sizeof(stored)) {
+    hour_index = stored;
+  }
+  file.close();
+  return hour_index;
+}
+
+/**
+ * @brief Save the hour index of a day.
+ *
+ * @param date The YYYYMMDD log directory.
+ * @param hour_index The hour index to save.
+ */
+void LoggingManager::saveHourIndex(const String& date,
+                                   const HourIndex& hour_index) {
+  const String path = String(LoggingManager::root_path_) + '/' + date + '/' +
+                      LoggingManager::hour_index_name_;
+  fs::File file = LittleFS.open(path, FILE_WRITE);
+  if (!file) {
+    Serial.println("Failed to open hour index");
+    return;
+  }
+  file.write(reinterpret_cast<const uint8_t*>(hour_index.data()),
+             sizeof(hour_index));
+  file.close();
+}
+
+/**
+ * @brief Read the binary log files of a day from a position.
+ *
+ * @param date The YYYYMMDD log directory.
+ * @param position The first record to read. Advanced past every read record.
+ * @param start Records before this time are skipped.
+ * @param end Records after this time are skipped.
+ * @param callback Called for each record within the range.
+ * @return False if the query should stop.
+ */
+bool LoggingManager::readDayLogs(const String& date, LogPosition& position,
+                                 uint32_t start, uint32_t end,
+                                 const LogRecordCallback& callback) {
+  const String dir_path = String(LoggingManager::root_path_) + '/' + date;
+  File dir = LittleFS.open(dir_path);
+  if (!dir || !dir.isDirectory()) {
+    return true;
+  }
+
+  // Collect the day's log files starting with the current file
+  std::vector<int> file_nums;
+  for (File log_file = dir.openNextFile(); log_file;
+       log_file = dir.openNextFile()) {
+    String name = log_file.name();
+    if (name.endsWith(".bin")) {
+      const int file_num = name.substring(0, name.indexOf('.')).toInt();
+      if (file_num >= position.file_num) {
+        file_nums.push_back(file_num);
+      }
+    }
+  }
+  dir.close();
+  std::sort(file_nums.begin(), file_nums.end());
+
+  std::array<LogRecord, 32> records;
+  for (const int file_num : file_nums) {
+    if (file_num != position.file_num) {
+      position = {uint16_t(file_num), 0};
+    }
+    fs::File file =
+        LittleFS.open(dir_path + '/' + file_num + ".bin", FILE_READ);
+    if (!file) {
+      continue;
+    }
+    file.seek(position.record * sizeof(LogRecord));
+
+    size_t bytes_read;
+    while ((bytes_read = file.read(reinterpret_cast<uint8_t*>(records.data()),
+                                   sizeof(records))) >= sizeof(LogRecord)) {
+      if (!filterLogRecords(records.data(), bytes_read / sizeof(LogRecord),
+                            start, end, callback, position)) {
+        file.close();
+        return false;
+      }
+    }
+    file.close();
+  }
+  return true;
+}
+
 const char* LoggingManager::root_path_ = "/logs/fdl";
+const char* LoggingManager::index_path_ = "/logs/fdl_index.json";
+const char* LoggingManager::hour_index_name_ = "hours.idx";
 
 }  // namespace inamata
 
@@ -2,8 +2,15 @@
 
 #include <Arduino.h>
 
+#include <array>
+#include <chrono>
+#include <functional>
+#include <map>
 #include <vector>
 
+#include "managers/log_buffer.h"
+#include "managers/log_record.h"
+
 namespace inamata {
 
 /**
@@ -13,46 +20,192 @@ namespace inamata {
  */
 class LoggingManager {
  public:
+  using LogRecord = inamata::LogRecord;
+  using LogRecordCallback = inamata::LogRecordCallback;
+
+  /**
+   * Render a record as a text log line
+   *
+   * Format: YYYY-MM-DDTHH:MM:SS,Input,State or YYYY-MM-DDTHH:MM:SS,Power on
+   *
+   * \param record The record to render
+   * \return The text log line
+   */
+  static String toString(const LogRecord& record);
+
   /// Max size for all log files (~270 kB)
   static constexpr size_t kMaxTotalLogBytes = 27 * 10000;
   /// Max log entries per file
   static constexpr uint16_t kMaxLogEntries = 500;
+  /// Max log entries kept in RAM before they are written to flash
+  static constexpr uint8_t kMaxBufferedLogs = 32;
+  /// Max time a log entry is kept in RAM before it is written to flash
+  static constexpr std::chrono::seconds kMaxBufferedLogAge{10};
 
   /**
    * Recursively prints all logs from all log files
    */
   static void showAllLogs();
 
+  LoggingManager();
+
+  /**
+   * Add a log record to the RAM buffer
+   *
+   * The buffer is written to flash once it is full, the oldest entry exceeds
+   * kMaxBufferedLogAge or if a flush is requested.
+   *
+   * \param type The type of the logged event
+   * \param input The input number for input events
+   * \param state The input state for input events
+   * \param flush Whether to immediately write all buffered entries
+   */
+  void addLog(LogRecord::Type type, uint8_t input = 0, bool state = false,
+              bool flush = false);
+
+  /**
+   * Write the buffered log entries if the oldest one is too old
+   */
+  void handle();
+
+  /**
+   * Write all buffered log entries to flash
+   *
+   * Consecutive entries for the same log file are written in a single append.
+   * Call before restarting to not lose entries.
+   */
+  void flush();
+
   /**
    * Check if log storage exceeds max size. Delete oldest day if exceeds.
+   *
+   * Uses the per-day log size index that is updated on every flush. The
+   * index is saved here and on day rollovers instead of on every flush.
    */
-  static void deleteOldLogs();
+  void deleteOldLogs();
+
+  /**
+   * Get all log records within a time range in chronological order
+   *
+   * Uses the per-day hour index to seek to the lowest indexed record from the
+   * start hour on instead of scanning all log files. Flushes the RAM buffer
+   * first.
+   *
+   * \param start Start of the range in seconds since the Unix epoch
+   * \param end Inclusive end of the range in seconds since the Unix epoch
+   * \param callback Called for each record. Return false to stop
+   */
+  void queryLogs(uint32_t start, uint32_t end, LogRecordCallback callback);
+
+  /// Position of the next record to read in a log query
+  struct LogCursor {
+    /// The YYYYMMDD log directory. Empty once all days were read
+    String date;
+    LogPosition position;
+  };
+
+  /**
+   * Get a cursor to the first record to read for a query
+   *
+   * \param start Start of the range in seconds since the Unix epoch
+   * \return The cursor for readLogs
+   */
+  LogCursor seekLogs(uint32_t start);
+
+  /**
+   * Continue a query at a cursor
+   *
+   * The cursor is advanced past every read record, so a query stopped by the
+   * callback continues with the next record, even while new records are
+   * appended. Flushes the RAM buffer first.
+   *
+   * \param cursor The position to continue reading at
+   * \param start Start of the range in seconds since the Unix epoch
+   * \param end Inclusive end of the range in seconds since the Unix epoch
+   * \param callback Called for each record. Return false to stop
+   * \return True if all records of the range have been read
+   */
+  bool readLogs(LogCursor& cursor, uint32_t start, uint32_t end,
+                LogRecordCallback callback);
 
-  LoggingManager();
-  void addLog(const String& event);
   void showCurrentLog();
   bool toggleRealTimeLogs();
   bool getRealTimeLogsState();
 
   static const char* root_path_;
+  /// Persisted byte count of the log files per day
+  static const char* index_path_;
+  /// Name of the hour index in each daily log directory
+  static const char* hour_index_name_;
 
  private:
   struct LogPath {
     String date_time;
     int file_num;
+    /// Binary log file, else a legacy text log file
+    bool is_binary;
     const String fullPath() const {
       return String(LoggingManager::root_path_) + '/' + date_time + '/' +
-             file_num + ".log";
+             file_num + (is_binary ? ".bin" : ".log");
     }
   };
 
+  /// Log record waiting to be written into its log file
+  struct BufferedLog {
+    String date;
+    int file_num;
+    uint8_t hour;
+    LogRecord record;
+  };
+
   int file_number_;
   int log_count_;
 
+  LogBuffer<BufferedLog> log_buffer_{kMaxBufferedLogs, kMaxBufferedLogAge};
+
+  /// Bytes of all log files per day, keyed by the YYYYMMDD directory name
+  std::map<String, uint32_t> day_log_bytes_;
+  /// Whether day_log_bytes_ changed since it was last saved
+  bool is_log_index_dirty_ = false;
+
+  /// Hour index of the day currently being written to
+  HourIndex hour_index_;
+  String hour_index_date_;
+
   bool enable_real_time_logs = false;
 
   static std::vector<LoggingManager::LogPath> getAllLogPaths();
 
   void rotateLogFile();
+
+  void loadLogIndex();
+  void rebuildLogIndex();
+  void saveLogIndex();
+  static uint32_t sumDayLogBytes(const String& date);
+
+  /**
+   * Get a cursor to the first indexed record of the days after a date
+   *
+   * \param date The YYYYMMDD log directory to skip
+   * \return The cursor or an empty date if there are no later records
+   */
+  LogCursor seekNextDay(const String& date);
+
+  static HourIndex loadHourIndex(const String& date);
+  static void saveHourIndex(const String& date, const HourIndex& hour_index);
+
+  /**
+   * Read the records of a day's binary log files starting at a position
+   *
+   * \param date The YYYYMMDD log directory
+   * \param position First record to read. Advanced past every read record
+   * \param start Skip records before this time
+   * \param end Skip records after this time
+   * \param callback Called for each record in range
+   * \return False if the query should stop
+   */
+  static bool readDayLogs(const String& date, LogPosition& position,
+                          uint32_t start, uint32_t end,
+                          const LogRecordCallback& callback);
 };
 }  // namespace inamata
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "log_record.h"
+
+namespace inamata {
+
+LogPosition firstLogPosition(const HourIndex& hour_index, uint8_t first_hour) {
+  LogPosition first{kNoRecord, kNoRecord};
+  for (size_t hour = first_hour; hour < hour_index.size(); hour++) {
+    const LogPosition& position = hour_index[hour];
+    if (position.file_num == kNoRecord) {
+      continue;
+    }
+    if (position.file_num < first.file_num ||
+        (position.file_num == first.file_num &&
+         position.record < first.record)) {
+      first = position;
+    }
+  }
+  return first;
+}
+
+bool filterLogRecords(const LogRecord* records, size_t count, uint32_t start,
+                      uint32_t end, const LogRecordCallback& callback,
+                      LogPosition& position) {
+  for (size_t i = 0; i < count; i++) {
+    const LogRecord& record = records[i];
+    position.record++;
+    if (record.time < start || record.time > end) {
+      continue;
+    }
+    if (!callback(record)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace inamata
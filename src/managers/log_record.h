@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace inamata {
+
+/**
+ * Fixed-size log record as stored in the binary log files
+ *
+ * Records are appended to /logs/fdl/YYYYMMDD/N.bin as is, in little endian.
+ * Records logged on the millis fallback after a power loss are not in time
+ * order.
+ */
+struct LogRecord {
+  enum class Type : uint8_t { kPowerOn = 0, kInput = 1 };
+
+  /// Seconds since the Unix epoch
+  uint32_t time;
+  /// Number of the input that changed (I1 to I48)
+  uint8_t input;
+  /// Whether the input turned on
+  uint8_t state;
+  Type type;
+  uint8_t reserved;
+} __attribute__((packed));
+static_assert(sizeof(LogRecord) == 8, "LogRecord must be 8 bytes");
+
+/// Called for every record of a query. Return false to stop the query
+using LogRecordCallback = std::function<bool(const LogRecord& record)>;
+
+/// Position of a record within the log files of a day
+struct LogPosition {
+  uint16_t file_num;
+  uint16_t record;
+} __attribute__((packed));
+
+/// Position of the first record within each hour of a day
+using HourIndex = std::array<LogPosition, 24>;
+static constexpr uint16_t kNoRecord = 0xFFFF;
+
+/**
+ * Get the position to start reading the records of a day from
+ *
+ * The positions of later hours may be lower than the ones of earlier hours if
+ * the clock jumped back, so the lowest position of all hours from first_hour
+ * on is used.
+ *
+ * \param hour_index The hour index of the day
+ * \param first_hour The first hour of interest
+ * \return The lowest indexed position or kNoRecord if no hour is indexed
+ */
+LogPosition firstLogPosition(const HourIndex& hour_index, uint8_t first_hour);
+
+/**
+ * Pass the records within a time range to a callback
+ *
+ * All records are checked as later records may be in range even if earlier
+ * ones are out of range. The position is advanced past every checked record,
+ * so a stopped query continues after the last passed record.
+ *
+ * \param records The records to filter, starting at the position
+ * \param count Number of records
+ * \param start Records before this time are skipped
+ * \param end Records after this time are skipped
+ * \param callback Called for each record within the range
+ * \param position Position of the first record. Advanced per checked record
+ * \return False if the callback stopped the query
+ */
+bool filterLogRecords(const LogRecord* records, size_t count, uint32_t start,
+                      uint32_t end, const LogRecordCallback& callback,
+                      LogPosition& position);
+
+}  // namespace inamata
@@ -243,6 +243,10 @@ bool OtaUpdater::TaskCallback() {
     }
   } else {
 #ifdef GSM_NETWORK
+    // Reading would consume the modem's SMS responses
+    if (services_.getGsmNetwork()->isSendingSms()) {
+      return true;
+    }
     if (gsm_https_client_->http_client_->available()) {
       bytes_read = gsm_https_client_->http_client_->readBytes(buffer_.data(),
                                                               buffer_.size());
@@ -302,6 +306,11 @@ void OtaUpdater::OnTaskDisable() {
   clearClients();
 
   if (restart_) {
+#ifdef RTC_MANAGER
+    if (auto logging_manager = services_.getLoggingManager()) {
+      logging_manager->flush();
+    }
+#endif
     // Sleep to allow remaining packets to be sent
     ::delay(1500);
     esp_restart();
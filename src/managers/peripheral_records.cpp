@@ -0,0 +1,91 @@
+#include "peripheral_records.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <utility>
+
+namespace inamata {
+
+std::string getPeripheralRecordName(const PeripheralRecord& record) {
+  // Short names as LittleFS paths incl. mount point are limited to 64 chars
+  char sequence[6];
+  snprintf(sequence, sizeof(sequence), "%04x_", record.sequence);
+  return sequence + record.id;
+}
+
+bool parsePeripheralRecordName(const char* name, PeripheralRecord& record) {
+  char* id_start;
+  const unsigned long sequence = strtoul(name, &id_start, 16);
+  if (id_start == name || *id_start != '_' || sequence > UINT16_MAX) {
+    return false;
+  }
+  record = {static_cast<uint16_t>(sequence), id_start + 1};
+  return true;
+}
+
+void sortPeripheralRecords(std::vector<PeripheralRecord>& records,
+                           const PeripheralRecordFiles& files) {
+  std::sort(records.begin(), records.end(),
+            [](const PeripheralRecord& a, const PeripheralRecord& b) {
+              return a.sequence < b.sequence;
+            });
+
+  for (auto record = records.begin(); record != records.end();) {
+    const bool is_replaced =
+        std::any_of(std::next(record), records.end(),
+                    [&record](const PeripheralRecord& r) {
+                      return r.id == record->id;
+                    });
+    if (is_replaced) {
+      files.remove(*record);
+      record = records.erase(record);
+    } else {
+      record++;
+    }
+  }
+}
+
+uint16_t nextPeripheralSequence(std::vector<PeripheralRecord>& records,
+                                size_t count,
+                                const PeripheralRecordFiles& files) {
+  if (records.empty()) {
+    return 0;
+  }
+  if (records.back().sequence + count >= UINT16_MAX) {
+    uint16_t sequence = 0;
+    for (PeripheralRecord& record : records) {
+      const PeripheralRecord old_record = record;
+      record.sequence = sequence++;
+      files.rename(old_record, record);
+    }
+  }
+  return records.back().sequence + 1;
+}
+
+bool replacePeripheralRecords(std::vector<PeripheralRecord>& records,
+                              const std::vector<std::string>& ids,
+                              const PeripheralRecordFiles& files) {
+  uint16_t sequence = nextPeripheralSequence(records, ids.size(), files);
+
+  std::vector<PeripheralRecord> new_records;
+  new_records.reserve(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    new_records.push_back({sequence++, ids[i]});
+    if (!files.write(new_records.back(), i)) {
+      for (const PeripheralRecord& record : new_records) {
+        files.remove(record);
+      }
+      return false;
+    }
+  }
+
+  for (const PeripheralRecord& record : records) {
+    files.remove(record);
+  }
+  records = std::move(new_records);
+  return true;
+}
+
+}  // namespace inamata
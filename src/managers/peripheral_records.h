@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace inamata {
+
+/// A peripheral's record file, named <sequence>_<peripheral ID>
+struct PeripheralRecord {
+  /// Order in which the peripheral was first saved
+  uint16_t sequence;
+  std::string id;
+};
+
+/// File system operations on the record files, done with LittleFS by Storage
+struct PeripheralRecordFiles {
+  /// Write the peripheral at the index of the passed ones. False on an error
+  std::function<bool(const PeripheralRecord& record, size_t index)> write;
+  std::function<void(const PeripheralRecord& record)> remove;
+  std::function<void(const PeripheralRecord& from, const PeripheralRecord& to)>
+      rename;
+};
+
+/**
+ * Get the file name of a record
+ *
+ * \param record The record to name
+ * \return The sequence as 4 hex digits, an underscore and the peripheral ID
+ */
+std::string getPeripheralRecordName(const PeripheralRecord& record);
+
+/**
+ * Parse the file name of a record
+ *
+ * \param name The file name without the directory
+ * \param record Set to the parsed record
+ * \return False if the name is not one of a record
+ */
+bool parsePeripheralRecordName(const char* name, PeripheralRecord& record);
+
+/**
+ * Sort the listed records and remove older records of the same peripheral
+ *
+ * A power loss while storing peripherals can leave an older record of a
+ * peripheral. Only the newest one is valid.
+ *
+ * \param records The listed records. Sorted by their sequence
+ * \param files Removes the older records
+ */
+void sortPeripheralRecords(std::vector<PeripheralRecord>& records,
+                           const PeripheralRecordFiles& files);
+
+/**
+ * Get the sequence of the next new record
+ *
+ * Renumbers the records from zero if the sequence would overflow.
+ *
+ * \param records The stored records sorted by their sequence
+ * \param count Number of records to be added
+ * \param files Renames the renumbered records
+ * \return The sequence of the first new record
+ */
+uint16_t nextPeripheralSequence(std::vector<PeripheralRecord>& records,
+                                size_t count,
+                                const PeripheralRecordFiles& files);
+
+/**
+ * Replace the stored records with ones of the passed peripherals
+ *
+ * All new records are written before the old ones are removed, so a power
+ * loss does not leave the device without peripherals. On a failed write, the
+ * written new records are removed and the old ones are kept.
+ *
+ * \param records The stored records sorted by their sequence. Replaced by
+ *                the new records on success
+ * \param ids The IDs of the peripherals in the order to load them in
+ * \param files Writes and removes the records
+ * \return False if a write failed
+ */
+bool replacePeripheralRecords(std::vector<PeripheralRecord>& records,
+                              const std::vector<std::string>& ids,
+                              const PeripheralRecordFiles& files);
+
+}  // namespace inamata
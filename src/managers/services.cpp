@@ -14,6 +14,9 @@ Services::Services() {
   task_removal_task_.setServices(getters);
   lac_controller_.setServices(getters);
   ota_updater_.setServices(getters);
+#ifdef RTC_MANAGER
+  log_exporter_.setServices(getters);
+#endif
 }
 
 std::shared_ptr<WiFiNetwork> Services::getWifiNetwork() {
@@ -82,6 +85,10 @@ lac::LacController& Services::getLacController() { return lac_controller_; }
 
 OtaUpdater& Services::getOtaUpdater() { return ota_updater_; }
 
+#ifdef RTC_MANAGER
+LogExporter& Services::getLogExporter() { return log_exporter_; }
+#endif
+
 Scheduler& Services::getScheduler() { return scheduler_; }
 
 ServiceGetters Services::getGetters() {
@@ -120,6 +127,10 @@ lac::LacController Services::lac_controller_{scheduler_};
 
 OtaUpdater Services::ota_updater_{scheduler_};
 
+#ifdef RTC_MANAGER
+LogExporter Services::log_exporter_{scheduler_};
+#endif
+
 // UiController Services::ui_controller_{scheduler_};
 
 }  // namespace inamata
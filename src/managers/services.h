@@ -6,6 +6,7 @@
 #include "lac/lac_controller.h"
 #include "managers/action_controller.h"
 #include "managers/behavior_controller.h"
+#include "managers/log_exporter.h"
 #include "managers/ota_updater.h"
 #include "managers/service_getters.h"
 #include "managers/web_socket.h"
@@ -61,6 +62,9 @@ class Services {
   static tasks::TaskController& getTaskController();
   static lac::LacController& getLacController();
   static OtaUpdater& getOtaUpdater();
+#ifdef RTC_MANAGER
+  static LogExporter& getLogExporter();
+#endif
 
   static Scheduler& getScheduler();
 
@@ -112,6 +116,10 @@ class Services {
   // static UiController ui_controller_;
   /// Singleton to perform OTA updates
   static OtaUpdater ota_updater_;
+#ifdef RTC_MANAGER
+  /// Singleton to stream logs to the server
+  static LogExporter log_exporter_;
+#endif
 };
 
 }  // namespace inamata
@@ -1,5 +1,11 @@
 #include "storage.h"
 
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+
+#include <algorithm>
+
+#include "peripheral/fixed.h"
 #include "peripheral/peripheral.h"
 
 namespace inamata {
@@ -64,14 +70,25 @@ void Storage::openFS() {
 #ifdef ENABLE_TRACE
   listDir(LittleFS, "/", 1);
 #endif
+
+  // Write changed secrets on every restart, independent of its caller
+  shutdown_instance_ = this;
+  esp_register_shutdown_handler(handleShutdown);
 }
 
-void Storage::closeFS() { LittleFS.end(); }
+void Storage::closeFS() {
+  handleSecretsWriteBack(true);
+  LittleFS.end();
+}
 
 void Storage::recursiveRm(const char* path) {
   if (strlen(path) == 0) {
     return;
   }
+  // A factory reset must not write the cached secrets back on restart
+  if (strcmp(path, "/") == 0 && shutdown_instance_) {
+    shutdown_instance_->secrets_write_back_.discard();
+  }
   fs::File root = LittleFS.open(path, "r");
   if (!root) {
     TRACEF("Can't open: %s\r\n", path);
@@ -100,26 +117,58 @@ void Storage::recursiveRm(const char* path) {
   }
 }
 
+void Storage::handleShutdown() {
+  if (shutdown_instance_) {
+    shutdown_instance_->handleSecretsWriteBack(true);
+  }
+}
+
 ErrorResult Storage::loadSecrets(JsonDocument& secrets_doc) {
-  return loadJsonFile(secrets_doc, secrets_path_);
+  ErrorResult error = loadSecretsCache();
+  if (error.isError()) {
+    return error;
+  }
+  secrets_doc.set(secrets_cache_);
+  return ErrorResult();
 }
 
 ErrorResult Storage::storeSecrets(JsonVariantConst secrets) {
-  return storeJsonFile(secrets, secrets_path_);
+  secrets_cache_.set(secrets);
+  secrets_loaded_ = true;
+  markSecretsDirty();
+  return ErrorResult();
+}
+
+ErrorResult Storage::handleSecretsWriteBack(bool force) {
+  // Write to a temporary file first to not lose the secrets on power loss
+  ErrorResult error;
+  secrets_write_back_.handle(
+      std::chrono::steady_clock::now(), force,
+      [this, &error]() {
+        error = storeJsonFile(secrets_cache_, secrets_tmp_path_);
+        return !error.isError();
+      },
+      [&error]() {
+        if (!LittleFS.rename(secrets_tmp_path_, secrets_path_)) {
+          error = ErrorResult(type_,
+                              String("Failed renaming ") + secrets_tmp_path_);
+        }
+        return !error.isError();
+      });
+  return error;
 }
 
 ErrorResult Storage::saveWiFiAP(const WiFiAP& wifi_ap) {
-  JsonDocument doc;
-  ErrorResult error = loadSecrets(doc);
+  ErrorResult error = loadSecretsCache();
   if (error.isError()) {
     return error;
   }
 
   // Save WiFi credentials to list of known APs
-  JsonVariant wifi_aps_value = doc[wifi_aps_key_];
+  JsonVariant wifi_aps_value = secrets_cache_[wifi_aps_key_];
   JsonArray wifi_aps;
   if (wifi_aps_value.isNull()) {
-    wifi_aps = doc[wifi_aps_key_].to<JsonArray>();
+    wifi_aps = secrets_cache_[wifi_aps_key_].to<JsonArray>();
   } else {
     wifi_aps = wifi_aps_value.as<JsonArray>();
   }
@@ -139,120 +188,328 @@ ErrorResult Storage::saveWiFiAP(const WiFiAP& wifi_ap) {
   wifi_ap_obj[wifi_ap_ssid_key_] = wifi_ap.ssid;
   wifi_ap_obj[wifi_ap_password_key_] = wifi_ap.password;
 
-  error = storeSecrets(doc);
-  return error;
+  markSecretsDirty();
+  return ErrorResult();
 }
 
 ErrorResult Storage::saveWsUrl(const char* domain, const char* path,
                                bool secure_url) {
-  JsonDocument doc;
-  ErrorResult error = loadSecrets(doc);
+  ErrorResult error = loadSecretsCache();
   if (error.isError()) {
     return error;
   }
 
   if (domain && strlen(path) >= 1) {
-    doc[core_domain_key_] = domain;
+    secrets_cache_[core_domain_key_] = domain;
   } else {
-    doc.remove(core_domain_key_);
+    secrets_cache_.remove(core_domain_key_);
   }
   if (path && strlen(path) >= 1) {
-    doc[ws_url_path_key_] = path;
+    secrets_cache_[ws_url_path_key_] = path;
   } else {
-    doc.remove(ws_url_path_key_);
+    secrets_cache_.remove(ws_url_path_key_);
   }
-  doc[secure_url_key_] = secure_url;
+  secrets_cache_[secure_url_key_] = secure_url;
 
-  error = storeSecrets(doc);
-  return error;
+  markSecretsDirty();
+  return ErrorResult();
 }
 
 ErrorResult Storage::deleteWsUrl() {
-  JsonDocument doc;
-  ErrorResult error = loadSecrets(doc);
+  ErrorResult error = loadSecretsCache();
   if (error.isError()) {
     return error;
   }
 
-  doc.remove(core_domain_key_);
-  doc.remove(ws_url_path_key_);
-  doc.remove(secure_url_key_);
+  secrets_cache_.remove(core_domain_key_);
+  secrets_cache_.remove(ws_url_path_key_);
+  secrets_cache_.remove(secure_url_key_);
 
-  error = storeSecrets(doc);
-  return error;
+  markSecretsDirty();
+  return ErrorResult();
 }
 
 ErrorResult Storage::saveAuthToken(const char* token) {
-  JsonDocument doc;
-  ErrorResult error = loadSecrets(doc);
+  ErrorResult error = loadSecretsCache();
   if (error.isError()) {
     return error;
   }
 
-  doc[ws_token_key_] = token;
+  secrets_cache_[ws_token_key_] = token;
 
-  error = storeSecrets(doc);
-  return error;
+  markSecretsDirty();
+  return ErrorResult();
 }
 
-ErrorResult Storage::savePeripheral(const JsonObjectConst& peripheral) {
-  JsonDocument peripherals_doc;
-  ErrorResult error = loadPeripherals(peripherals_doc);
+ErrorResult Storage::loadSecretsCache() {
+  if (secrets_loaded_) {
+    return ErrorResult();
+  }
+  ErrorResult error = loadJsonFile(secrets_cache_, secrets_path_);
   if (error.isError()) {
     return error;
   }
+  if (secrets_cache_.isNull()) {
+    secrets_cache_.to<JsonObject>();
+  }
+  secrets_loaded_ = true;
+  return ErrorResult();
+}
 
-  // Check if the peripheral already exists
-  uint8_t i = 0;
-  bool found = false;
-  const char* peripheral_id =
-      peripheral[peripheral::Peripheral::uuid_key_].as<const char*>();
-  JsonArray peripherals = peripherals_doc.as<JsonArray>();
-  for (JsonObject local_peri : peripherals) {
-    if (strcmp(local_peri[peripheral::Peripheral::uuid_key_].as<const char*>(),
-               peripheral_id) == 0) {
-      found = true;
-      break;
+void Storage::markSecretsDirty() {
+  secrets_write_back_.markDirty(std::chrono::steady_clock::now());
+}
+
+ErrorResult Storage::savePeripheral(const JsonObjectConst& peripheral) {
+  JsonDocument peripherals_doc;
+  peripherals_doc.add(peripheral);
+  return savePeripherals(peripherals_doc.as<JsonArrayConst>());
+}
+
+ErrorResult Storage::savePeripherals(JsonArrayConst peripherals) {
+  std::vector<PeripheralRecord> records = listPeripheralRecords();
+  uint16_t next_sequence = nextPeripheralSequence(
+      records, peripherals.size(), getPeripheralRecordFiles());
+
+  deletePeripheralSnapshot();
+  LittleFS.mkdir(peripherals_dir_);
+  for (JsonObjectConst peripheral : peripherals) {
+    const char* peripheral_id =
+        peripheral[peripheral::Peripheral::uuid_key_].as<const char*>();
+    if (!peripheral_id) {
+      return ErrorResult(type_, peripheral::Peripheral::uuid_key_error_);
     }
-    i++;
-  }
 
-  if (found) {
-    // Yes: Replace item in array
-    peripherals[i] = peripheral;
-  } else {
-    // No: Append to array
-    peripherals.add(peripheral);
+    // Overwrite the existing record or append a new one
+    auto record = std::find_if(records.begin(), records.end(),
+                               [peripheral_id](const PeripheralRecord& r) {
+                                 return r.id == peripheral_id;
+                               });
+    if (record == records.end()) {
+      records.push_back({next_sequence++, peripheral_id});
+      record = std::prev(records.end());
+    }
+    ErrorResult error = storeJsonFile(
+        peripheral, getPeripheralRecordPath(*record).c_str());
+    if (error.isError()) {
+      return error;
+    }
   }
-
-  return storePeripherals(peripherals);
+  return ErrorResult();
 }
 
 ErrorResult Storage::loadPeripherals(JsonDocument& peripherals_doc) {
-  return loadJsonFile(peripherals_doc, peripherals_path_);
+  // Migrate peripherals from the legacy single file to record files
+  if (LittleFS.exists(peripherals_path_)) {
+    ErrorResult error = loadJsonFile(peripherals_doc, peripherals_path_);
+    if (error.isError()) {
+      return error;
+    }
+    recursiveRm(peripherals_dir_);
+    error = savePeripherals(peripherals_doc.as<JsonArrayConst>());
+    if (error.isError()) {
+      return error;
+    }
+    LittleFS.remove(peripherals_path_);
+    return ErrorResult();
+  }
+
+  JsonArray peripherals = peripherals_doc.to<JsonArray>();
+  JsonDocument record_doc;
+  for (const PeripheralRecord& record : listPeripheralRecords()) {
+    ErrorResult error =
+        loadJsonFile(record_doc, getPeripheralRecordPath(record).c_str());
+    if (error.isError()) {
+      return error;
+    }
+    peripherals.add(record_doc.as<JsonObjectConst>());
+  }
+  return ErrorResult();
 }
 
 ErrorResult Storage::storePeripherals(JsonArrayConst peripherals) {
-  return storeJsonFile(peripherals, peripherals_path_);
+  std::vector<JsonObjectConst> objects;
+  std::vector<std::string> ids;
+  objects.reserve(peripherals.size());
+  ids.reserve(peripherals.size());
+  for (JsonObjectConst peripheral : peripherals) {
+    const char* peripheral_id =
+        peripheral[peripheral::Peripheral::uuid_key_].as<const char*>();
+    if (!peripheral_id) {
+      return ErrorResult(type_, peripheral::Peripheral::uuid_key_error_);
+    }
+    objects.push_back(peripheral);
+    ids.push_back(peripheral_id);
+  }
+
+  // Write all new records before removing the old ones, so that a failed
+  // write or power loss does not leave the device without peripherals
+  deletePeripheralSnapshot();
+  LittleFS.mkdir(peripherals_dir_);
+  std::vector<PeripheralRecord> records = listPeripheralRecords();
+  ErrorResult error;
+  PeripheralRecordFiles files = getPeripheralRecordFiles();
+  files.write = [this, &objects, &error](const PeripheralRecord& record,
+                                         size_t index) {
+    error = storeJsonFile(objects[index],
+                          getPeripheralRecordPath(record).c_str());
+    return !error.isError();
+  };
+  if (!replacePeripheralRecords(records, ids, files)) {
+    return error;
+  }
+
+  LittleFS.remove(peripherals_path_);
+  pruneEnergyCounters();
+  return ErrorResult();
 }
 
-void Storage::deletePeripherals() { LittleFS.remove(peripherals_path_); }
+bool Storage::loadPeripheralSnapshot(JsonDocument& peripherals_doc) {
+  if (!LittleFS.exists(peripheral_snapshot_path_)) {
+    return false;
+  }
+  fs::File file = LittleFS.open(peripheral_snapshot_path_, "r");
+  if (!file) {
+    return false;
+  }
+
+  // Check the header before reading the payload
+  PeripheralSnapshotHeader header;
+  const size_t header_size =
+      file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header));
+  if (header_size != sizeof(header) ||
+      header.version != kPeripheralSnapshotVersion_ ||
+      header.size != file.size() - sizeof(header)) {
+    TRACELN("Invalid peripheral snapshot header");
+    file.close();
+    return false;
+  }
+  std::vector<uint8_t> payload(header.size);
+  const size_t payload_size = file.read(payload.data(), payload.size());
+  file.close();
+  if (payload_size != header.size ||
+      getPeripheralSnapshotCrc(payload.data(), payload.size()) != header.crc) {
+    TRACELN("Peripheral snapshot mismatch");
+    return false;
+  }
+
+  DeserializationError error =
+      deserializeMsgPack(peripherals_doc, payload.data(), payload.size());
+  if (error || !peripherals_doc.is<JsonArray>()) {
+    TRACEF("Peripheral snapshot invalid: %s\r\n", error.c_str());
+    return false;
+  }
+  return true;
+}
+
+ErrorResult Storage::storePeripheralSnapshot(JsonArrayConst peripherals) {
+  std::vector<uint8_t> payload(measureMsgPack(peripherals));
+  serializeMsgPack(peripherals, payload.data(), payload.size());
+  PeripheralSnapshotHeader header{
+      .version = kPeripheralSnapshotVersion_,
+      .crc = getPeripheralSnapshotCrc(payload.data(), payload.size()),
+      .size = static_cast<uint32_t>(payload.size())};
+
+  // Write to a temporary file first to never leave a partial snapshot
+  fs::File file = LittleFS.open(peripheral_snapshot_tmp_path_, "w");
+  if (!file) {
+    return ErrorResult(type_,
+                       String("Failed opening ") + peripheral_snapshot_path_);
+  }
+  size_t bytes_written =
+      file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+  bytes_written += file.write(payload.data(), payload.size());
+  file.close();
+  if (bytes_written != sizeof(header) + payload.size() ||
+      !LittleFS.rename(peripheral_snapshot_tmp_path_,
+                       peripheral_snapshot_path_)) {
+    LittleFS.remove(peripheral_snapshot_tmp_path_);
+    return ErrorResult(type_,
+                       String("Failed to write ") + peripheral_snapshot_path_);
+  }
+  return ErrorResult();
+}
+
+void Storage::deletePeripheralSnapshot() {
+  if (LittleFS.exists(peripheral_snapshot_path_)) {
+    LittleFS.remove(peripheral_snapshot_path_);
+  }
+}
+
+uint32_t Storage::getPeripheralSnapshotCrc(const uint8_t* payload,
+                                           size_t size) {
+  // Include the firmware version as parsing rules may change between versions
+  const char* firmware_version = FIRMWARE_VERSION;
+  uint32_t crc = esp_rom_crc32_le(
+      0, reinterpret_cast<const uint8_t*>(firmware_version),
+      strlen(firmware_version));
+  // Include the fixed configs to not load a stale snapshot when a build
+  // changes them without a new firmware version
+  for (const char* config : peripheral::fixed::configs) {
+    if (config) {
+      crc = esp_rom_crc32_le(crc, reinterpret_cast<const uint8_t*>(config),
+                             strlen(config));
+    }
+  }
+  return esp_rom_crc32_le(crc, payload, size);
+}
+
+void Storage::deletePeripherals() {
+  deletePeripheralSnapshot();
+  if (LittleFS.exists(peripherals_dir_)) {
+    recursiveRm(peripherals_dir_);
+  }
+  LittleFS.remove(peripherals_path_);
+}
 
 void Storage::deletePeripheral(const char* peripheral_id) {
-  JsonDocument peripherals_doc;
-  ErrorResult error = loadPeripherals(peripherals_doc);
-  if (error.isError()) {
-    return;
+  deletePeripheralSnapshot();
+  for (const PeripheralRecord& record : listPeripheralRecords()) {
+    if (record.id == peripheral_id) {
+      LittleFS.remove(getPeripheralRecordPath(record));
+    }
+  }
+  pruneEnergyCounters();
+}
+
+std::vector<PeripheralRecord> Storage::listPeripheralRecords() {
+  std::vector<PeripheralRecord> records;
+  if (!LittleFS.exists(peripherals_dir_)) {
+    return records;
+  }
+  fs::File dir = LittleFS.open(peripherals_dir_, "r");
+  if (!dir || !dir.isDirectory()) {
+    return records;
   }
-  JsonArray peripherals = peripherals_doc.as<JsonArray>();
-  for (JsonObject i : peripherals) {
-    if (strcmp(i[peripheral::Peripheral::uuid_key_].as<const char*>(),
-               peripheral_id) == 0) {
-      peripherals.remove(i);
+  PeripheralRecord record;
+  for (fs::File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    if (!parsePeripheralRecordName(file.name(), record)) {
+      TRACEF("Invalid record: %s\r\n", file.name());
+      continue;
     }
+    records.push_back(record);
   }
+  sortPeripheralRecords(records, getPeripheralRecordFiles());
+  return records;
+}
+
+PeripheralRecordFiles Storage::getPeripheralRecordFiles() {
+  return {
+      .remove =
+          [](const PeripheralRecord& record) {
+            LittleFS.remove(getPeripheralRecordPath(record));
+          },
+      .rename =
+          [](const PeripheralRecord& from, const PeripheralRecord& to) {
+            LittleFS.rename(getPeripheralRecordPath(from),
+                            getPeripheralRecordPath(to));
+          },
+  };
+}
 
-  storePeripherals(peripherals_doc.as<JsonArrayConst>());
+String Storage::getPeripheralRecordPath(const PeripheralRecord& record) {
+  return String(peripherals_dir_) + "/" +
+         getPeripheralRecordName(record).c_str();
 }
 
 ErrorResult Storage::loadBehavior(JsonDocument& behavior_doc) {
@@ -285,6 +542,55 @@ ErrorResult Storage::storeMobileConfig(const JsonObjectConst& config) {
 
 void Storage::deleteMobileConfig() { LittleFS.remove(mobile_config_path_); }
 
+ErrorResult Storage::loadEnergyCounters(JsonDocument& counters) {
+  return loadJsonFile(counters, energy_counters_path_);
+}
+
+ErrorResult Storage::storeEnergyCounter(const String& peripheral_id,
+                                        uint64_t energy_mj) {
+  JsonDocument counters;
+  ErrorResult error = loadEnergyCounters(counters);
+  if (error.isError()) {
+    // Start over, else a corrupt file would never be saved again
+    Serial.printf("Resetting energy counters: %s\r\n",
+                  error.toString().c_str());
+    counters.clear();
+  }
+  counters[peripheral_id] = energy_mj;
+  return storeJsonFile(counters, energy_counters_path_);
+}
+
+void Storage::pruneEnergyCounters() {
+  JsonDocument counters;
+  ErrorResult error = loadEnergyCounters(counters);
+  if (error.isError() || counters.isNull()) {
+    return;
+  }
+
+  const std::vector<PeripheralRecord> records = listPeripheralRecords();
+  std::vector<String> stale_ids;
+  for (JsonPairConst counter : counters.as<JsonObjectConst>()) {
+    const bool is_stored =
+        std::any_of(records.begin(), records.end(),
+                    [&counter](const PeripheralRecord& record) {
+                      return record.id == counter.key().c_str();
+                    });
+    if (!is_stored) {
+      stale_ids.push_back(counter.key().c_str());
+    }
+  }
+  if (stale_ids.empty()) {
+    return;
+  }
+  for (const String& stale_id : stale_ids) {
+    counters.remove(stale_id);
+  }
+  error = storeJsonFile(counters, energy_counters_path_);
+  if (error.isError()) {
+    TRACELN(error.toString());
+  }
+}
+
 ErrorResult Storage::loadJsonFile(JsonDocument& config, const char* path) {
   fs::File file = LittleFS.open(path, "r+");
   if (file) {
@@ -328,11 +634,17 @@ const char* Storage::wifi_aps_key_ = "wifi_aps";
 const char* Storage::wifi_ap_ssid_key_ = "ssid";
 const char* Storage::wifi_ap_password_key_ = "password";
 
+Storage* Storage::shutdown_instance_ = nullptr;
 const char* Storage::secrets_path_ = "/secrets.json";
+const char* Storage::secrets_tmp_path_ = "/secrets.json.tmp";
 const char* Storage::peripherals_path_ = "/peripherals.json";
+const char* Storage::peripherals_dir_ = "/peris";
+const char* Storage::peripheral_snapshot_path_ = "/peris.msgpack";
+const char* Storage::peripheral_snapshot_tmp_path_ = "/peris.msgpack.tmp";
 const char* Storage::behavior_path_ = "/behavior.json";
 const char* Storage::custom_config_path_ = "/custom_config.json";
 const char* Storage::mobile_config_path_ = "/mobile_config.json";
+const char* Storage::energy_counters_path_ = "/energy.json";
 const char* Storage::type_ = "storage";
 
 }  // namespace inamata
\ No newline at end of file
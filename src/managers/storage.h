@@ -3,8 +3,13 @@
 #include <ArduinoJson.h>
 #include <LittleFS.h>
 
+#include <chrono>
+#include <vector>
+
 #include "managers/logging.h"
+#include "managers/peripheral_records.h"
 #include "managers/types.h"
+#include "managers/write_back.h"
 
 namespace inamata {
 
@@ -20,21 +25,43 @@ class Storage {
    */
   static void recursiveRm(const char* path);
 
+  /**
+   * Write changed secrets before the device restarts
+   *
+   * Registered by openFS as an ESP-IDF shutdown handler, so it runs on every
+   * ESP.restart() and esp_restart() call.
+   */
+  static void handleShutdown();
+
   /**
    * Load stored secrets into passed JSON doc
    *
+   * The secrets file is only read on the first call. Afterwards the cached
+   * secrets are returned.
+   *
    * \param secrets_doc The JSON doc to load secrets into
    * \return If an error occured during deserialization. No error if no file
    */
   ErrorResult loadSecrets(JsonDocument& secrets_doc);
 
   /**
-   * Store secrets JSON doc on the file system
+   * Replace the cached secrets and schedule writing them to the file system
    *
    * \param secrets_doc JSON doc with the secrets to be stored
    */
   ErrorResult storeSecrets(JsonVariantConst secrets);
 
+  /**
+   * Write changed secrets once no changes occured for the debounce period
+   *
+   * Writes to a temporary file and renames it to avoid corrupt secrets on
+   * power loss.
+   *
+   * \param force Write changed secrets without waiting for the debounce
+   * \return If an error occured while writing
+   */
+  ErrorResult handleSecretsWriteBack(bool force = false);
+
   /**
    * Save WiFi AP credentials to secret store
    *
@@ -69,12 +96,19 @@ class Storage {
   /**
    * Load saved peripherals to JSON doc
    *
+   * Each peripheral is stored in its own record file. They are returned in the
+   * order they were first saved in. Peripherals in the legacy single file are
+   * migrated to record files.
+   *
    * \return Error if one occured
    */
   ErrorResult loadPeripherals(JsonDocument& peripheral_doc);
 
   /**
-   * Store passed peripherals or private JSON doc on flash storage
+   * Replace all stored peripherals with the passed ones
+   *
+   * The new records are written before the old ones are removed. On an error,
+   * the old records are kept.
    *
    * \return Error if one occured
    */
@@ -88,6 +122,40 @@ class Storage {
    */
   ErrorResult savePeripheral(const JsonObjectConst& peripheral);
 
+  /**
+   * Saves multiple peripherals with a single scan of the stored records
+   *
+   * Only the records of the passed peripherals are written.
+   *
+   * \param peripherals The peripherals to be saved. Overwrites old versions
+   * \return If an error occured
+   */
+  ErrorResult savePeripherals(JsonArrayConst peripherals);
+
+  /**
+   * Load the validated peripheral configs saved after the last boot
+   *
+   * The snapshot is bound to the firmware version and the fixed configs and
+   * checksummed. Any change to the stored peripherals deletes it.
+   *
+   * \param peripherals_doc The JSON doc to load the peripheral array into
+   * \return True if a valid snapshot was loaded
+   */
+  bool loadPeripheralSnapshot(JsonDocument& peripherals_doc);
+
+  /**
+   * Save the validated peripheral configs as a MessagePack snapshot
+   *
+   * \param peripherals The peripherals that were added successfully
+   * \return If an error occured
+   */
+  ErrorResult storePeripheralSnapshot(JsonArrayConst peripherals);
+
+  /**
+   * Delete the peripheral snapshot to fall back to the JSON configs
+   */
+  void deletePeripheralSnapshot();
+
   /**
    * Deletes stored peripherals
    */
@@ -112,6 +180,26 @@ class Storage {
   ErrorResult storeMobileConfig(const JsonObjectConst& config);
   void deleteMobileConfig();
 
+  /**
+   * Load the energy counters of all power meters
+   *
+   * \param counters Object with the peripheral IDs and their counters
+   * \return If an error occured during deserialization
+   */
+  ErrorResult loadEnergyCounters(JsonDocument& counters);
+
+  /**
+   * Save the energy counter of a power meter, keeping the other counters
+   *
+   * A corrupt counters file is replaced by one with only this counter.
+   *
+   * \param peripheral_id The ID of the power meter
+   * \param energy_mj The accumulated energy in millijoules
+   * \return If an error occured while storing the counters
+   */
+  ErrorResult storeEnergyCounter(const String& peripheral_id,
+                                 uint64_t energy_mj);
+
   static const char* arduino_board_;
   static const char* device_type_name_;
   static const char* device_type_id_;
@@ -126,14 +214,72 @@ class Storage {
   static const char* wifi_ap_password_key_;
 
  private:
+  /**
+   * Read the secrets file into the cache if not done yet
+   *
+   * \return If an error occured during deserialization
+   */
+  ErrorResult loadSecretsCache();
+
+  /// Mark the cached secrets as changed to write them after the debounce
+  void markSecretsDirty();
+
   ErrorResult loadJsonFile(JsonDocument& config, const char* path);
   ErrorResult storeJsonFile(const JsonVariantConst& config, const char* path);
 
+  /**
+   * List the stored peripheral records without opening them
+   *
+   * Older records of the same peripheral are removed.
+   *
+   * \return Records sorted by their sequence
+   */
+  std::vector<PeripheralRecord> listPeripheralRecords();
+
+  /**
+   * Remove and rename operations on the record files in LittleFS
+   *
+   * \return The operations without a write, which depends on the caller
+   */
+  static PeripheralRecordFiles getPeripheralRecordFiles();
+
+  static String getPeripheralRecordPath(const PeripheralRecord& record);
+
+  /**
+   * Remove the energy counters of peripherals that are no longer stored
+   */
+  void pruneEnergyCounters();
+
+  /// Prepended to the MessagePack payload of the peripheral snapshot
+  struct PeripheralSnapshotHeader {
+    uint32_t version;
+    /// CRC32 of the firmware version, the fixed configs and the payload
+    uint32_t crc;
+    uint32_t size;
+  };
+
+  static uint32_t getPeripheralSnapshotCrc(const uint8_t* payload,
+                                           size_t size);
+  static constexpr uint32_t kPeripheralSnapshotVersion_ = 1;
+
+  /// Parsed secrets file, written back with a debounce when dirty
+  JsonDocument secrets_cache_;
+  bool secrets_loaded_ = false;
+  static constexpr std::chrono::seconds kSecretsWriteDelay_{2};
+  WriteBack secrets_write_back_{kSecretsWriteDelay_};
+  /// The storage whose secrets are written by handleShutdown
+  static Storage* shutdown_instance_;
+
   static const char* secrets_path_;
+  static const char* secrets_tmp_path_;
   static const char* peripherals_path_;
+  static const char* peripherals_dir_;
+  static const char* peripheral_snapshot_path_;
+  static const char* peripheral_snapshot_tmp_path_;
   static const char* behavior_path_;
   static const char* custom_config_path_;
   static const char* mobile_config_path_;
+  static const char* energy_counters_path_;
   static const char* type_;
 };
 
@@ -4,6 +4,7 @@
 #include <esp_tls.h>
 
 #include "managers/services.h"
+#include "utils/boot_profiler.h"
 #include "utils/chrono.h"
 
 namespace inamata {
@@ -23,7 +24,8 @@ WebSocket::WebSocket(const WebSocket::Config& config)
       get_task_ids_(config.get_task_ids),
       task_controller_callback_(config.task_controller_callback),
       lac_controller_callback_(config.lac_controller_callback),
-      ota_update_callback_(config.ota_update_callback) {
+      ota_update_callback_(config.ota_update_callback),
+      log_export_callback_(config.log_export_callback) {
   if (core_domain_.isEmpty()) {
     core_domain_ = default_core_domain_;
     secure_url_ = true;
@@ -34,6 +36,7 @@ WebSocket::WebSocket(const WebSocket::Config& config)
   if (config.ws_token) {
     setWsToken(config.ws_token);
   }
+  applyTelemetryBudget();
 }
 
 const String& WebSocket::type() {
@@ -47,6 +50,10 @@ void WebSocket::setSentMessageCallback(std::function<void()> callback) {
 
 void WebSocket::clearSentMessageCallback() { sent_message_callback_ = nullptr; }
 
+void WebSocket::setCanSendCallback(std::function<bool()> callback) {
+  can_send_callback_ = callback;
+}
+
 bool WebSocket::isConnected() {
   const bool is_connected = websocket_client.isConnected();
   updateUpDownTime(is_connected);
@@ -102,10 +109,12 @@ WebSocket::ConnectState WebSocket::handle() {
       TRACELN("Reconnected to server");
       send_on_connect_messages_ = false;
       sendRegister();
+      sendBootProfile();
       sendUpDownTimeData();
     }
     websocket_client.loop();
     handleRetryBuffer();
+    handleCoalescedTelemetry();
     return ConnectState::kConnected;
   }
 
@@ -135,7 +144,107 @@ void WebSocket::sendTelemetry(JsonObject data, const utils::UUID* task_id,
   if (lac_id && lac_id->isValid()) {
     data[WebSocket::lac_key_] = lac_id->toString();
   }
-  sendJson(data, retry);
+
+  // Alerts do not contain data points and can not be coalesced
+  if (data[utils::ValueUnit::data_points_key].isNull()) {
+    sendJson(data, retry);
+    return;
+  }
+
+  // Coalesce while older readings are pending to keep the order per peripheral
+  // and while the link is busy, instead of filling the retry buffer
+  if (coalesced_telemetry_.empty() && canSend() &&
+      consumeTelemetryBudget(measureJson(data))) {
+    sendJson(data, retry);
+  } else {
+    coalesceTelemetry(data);
+  }
+}
+
+void WebSocket::setLinkType(LinkType link_type) {
+  if (link_type == link_type_) {
+    return;
+  }
+  link_type_ = link_type;
+  applyTelemetryBudget();
+}
+
+void WebSocket::applyTelemetryBudget() {
+  const TelemetryBudget& budget = link_type_ == LinkType::kGsm
+                                      ? kGsmTelemetryBudget
+                                      : kWifiTelemetryBudget;
+  telemetry_byte_bucket_.configure(budget.bytes_per_second, budget.byte_burst);
+  telemetry_message_bucket_.configure(budget.messages_per_second,
+                                      budget.message_burst);
+}
+
+bool WebSocket::consumeTelemetryBudget(const size_t size) {
+  const auto now = utils::TokenBucket::Clock::now();
+  if (!telemetry_message_bucket_.hasTokens(1, now) ||
+      !telemetry_byte_bucket_.hasTokens(size, now)) {
+    return false;
+  }
+  telemetry_message_bucket_.consume(1);
+  telemetry_byte_bucket_.consume(size);
+  return true;
+}
+
+void WebSocket::coalesceTelemetry(JsonObjectConst data) {
+  JsonVariantConst peripheral_id = data[telemetry_peripheral_key_];
+  if (peripheral_id.isNull()) {
+    peripheral_id = data[fixed_peripheral_key_];
+  }
+  if (!peripheral_id.is<const char*>()) {
+    TRACELN("Dropping telemetry without peripheral");
+    return;
+  }
+
+  // Only replace readings of the same peripheral, initiator and data point
+  // types, so that each reading is sent with its own time
+  String key = peripheral_id.as<const char*>();
+  key += '|';
+  key += data[task_key_] | "";
+  key += '|';
+  key += data[lac_key_] | "";
+  for (JsonObjectConst point :
+       data[utils::ValueUnit::data_points_key].as<JsonArrayConst>()) {
+    key += '|';
+    key += point[utils::ValueUnit::data_point_type_key] |
+           point[utils::ValueUnit::fixed_data_point_type_key] | "";
+  }
+
+  auto pending = coalesced_telemetry_.find(key);
+  if (pending == coalesced_telemetry_.end() &&
+      coalesced_telemetry_.size() >= kMaxCoalescedTelemetry_) {
+    TRACELN("Coalesced telemetry full");
+    stats_.dropped_telemetry++;
+    return;
+  }
+#ifdef ENABLE_WS_STATS
+  stats_.coalesced_telemetry++;
+#endif
+  // A replaced reading keeps the position of the first pending one
+  if (pending == coalesced_telemetry_.end()) {
+    coalesced_telemetry_order_.push_back(key);
+  }
+  coalesced_telemetry_[key].set(data);
+}
+
+void WebSocket::handleCoalescedTelemetry() {
+  if (!canSend()) {
+    return;
+  }
+  while (!coalesced_telemetry_order_.empty()) {
+    auto pending =
+        coalesced_telemetry_.find(coalesced_telemetry_order_.front());
+    if (!consumeTelemetryBudget(measureJson(pending->second))) {
+      return;
+    }
+    const bool retry = !pending->second[time_key_].isNull();
+    sendJson(pending->second, retry);
+    coalesced_telemetry_.erase(pending);
+    coalesced_telemetry_order_.pop_front();
+  }
 }
 
 void WebSocket::packageTelemetry(const std::vector<utils::ValueUnit>& values,
@@ -162,7 +271,7 @@ void WebSocket::packageTelemetry(const std::vector<utils::ValueUnit>& values,
 
   // Set the time
   if (Services::is_time_synced_) {
-    telemetry[time_key_] = utils::getIsoTimestamp();
+    utils::setTimestamp(telemetry[time_key_]);
   }
 }
 
@@ -300,6 +409,32 @@ void WebSocket::sendSystem(JsonObject data) {
   sendJson(data);
 }
 
+void WebSocket::addStats(JsonObject data) {
+  if (stats_.dropped_telemetry) {
+    data[F("ws_dropped_tel")] = stats_.dropped_telemetry;
+  }
+#ifdef ENABLE_WS_STATS
+  const auto now = std::chrono::steady_clock::now();
+  const float period_s =
+      std::chrono::duration<float>(now - stats_.since).count();
+  if (period_s > 0) {
+    data[F("ws_msgs_per_s")] = stats_.sent_messages / period_s;
+    data[F("ws_bytes_per_s")] = stats_.sent_bytes / period_s;
+  }
+  data[F("ws_failed_msgs")] = stats_.failed_messages;
+  data[F("ws_received_msgs")] = stats_.received_messages;
+  data[F("ws_coalesced_tel")] = stats_.coalesced_telemetry;
+  if (stats_.dispatch_duration.getCount()) {
+    data[F("ws_dispatch_p50_ms")] =
+        stats_.dispatch_duration.getPercentile(50).count();
+    data[F("ws_dispatch_p99_ms")] =
+        stats_.dispatch_duration.getPercentile(99).count();
+    data[F("ws_dispatch_max_us")] = stats_.dispatch_duration.getMax().count();
+  }
+#endif
+  stats_ = Stats();
+}
+
 void WebSocket::resetUrl() {
   is_setup_ = false;
   core_domain_ = default_core_domain_;
@@ -362,6 +497,11 @@ void WebSocket::handleEvent(WStype_t type, uint8_t* payload, size_t length) {
 }
 
 void WebSocket::handleData(const uint8_t* payload, size_t length) {
+#ifdef ENABLE_WS_STATS
+  const auto received_at = std::chrono::steady_clock::now();
+  stats_.received_messages++;
+#endif
+
   // Deserialize the JSON object into allocated memory
   JsonDocument doc_in;
   const DeserializationError error = deserializeJson(doc_in, payload, length);
@@ -382,6 +522,12 @@ void WebSocket::handleData(const uint8_t* payload, size_t length) {
   if (ota_update_callback_) {
     ota_update_callback_(message);
   }
+  if (log_export_callback_) {
+    log_export_callback_(message);
+  }
+#ifdef ENABLE_WS_STATS
+  stats_.dispatch_duration.add(std::chrono::steady_clock::now() - received_at);
+#endif
 }
 
 void WebSocket::updateUpDownTime(const bool is_connected) {
@@ -430,6 +576,16 @@ void WebSocket::sendUpDownTimeData() {
   }
 }
 
+void WebSocket::sendBootProfile() {
+  if (sent_boot_profile_) {
+    return;
+  }
+  JsonDocument doc_out;
+  utils::BootProfiler::addProfile(doc_out.to<JsonObject>());
+  sendSystem(doc_out.as<JsonObject>());
+  sent_boot_profile_ = true;
+}
+
 void WebSocket::setResetReason(JsonObject& register_obj) {
   const esp_reset_reason_t reset_reason = esp_reset_reason();
   const char* reset_reason_str;
@@ -490,22 +646,38 @@ void WebSocket::sendJson(JsonVariantConst doc, const bool retry) {
   std::vector<char> buffer = std::vector<char>(measureJson(doc) + 1);
   size_t n = serializeJson(doc, buffer.data(), buffer.size());
   TRACELN(buffer.data());
+  // Defer the message until the link is free again
+  if (!canSend()) {
+    saveToRetryBuffer(buffer);
+    return;
+  }
   const bool success = websocket_client.sendTXT(buffer.data(), n);
   if (!success) {
+#ifdef ENABLE_WS_STATS
+    stats_.failed_messages++;
+#endif
     if (retry) {
       saveToRetryBuffer(buffer);
     } else {
       TRACELN("Failed sending");
     }
   } else {
+#ifdef ENABLE_WS_STATS
+    stats_.sent_messages++;
+    stats_.sent_bytes += n;
+#endif
     if (sent_message_callback_) {
       sent_message_callback_();
     }
   }
 }
 
+bool WebSocket::canSend() const {
+  return !can_send_callback_ || can_send_callback_();
+}
+
 void WebSocket::handleRetryBuffer() {
-  if (retry_queue_.empty()) {
+  if (retry_queue_.empty() || !canSend()) {
     return;
   }
 
@@ -520,6 +692,10 @@ void WebSocket::handleRetryBuffer() {
   const bool success = websocket_client.sendTXT(
       retry_message.message.data(), retry_message.message.size() - 1);
   if (success) {
+#ifdef ENABLE_WS_STATS
+    stats_.sent_messages++;
+    stats_.sent_bytes += retry_message.message.size() - 1;
+#endif
     Serial.println("Sent retry message");
     retry_queue_.pop_back();
     return;
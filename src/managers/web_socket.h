@@ -13,6 +13,10 @@
 #include "configuration.h"
 #include "managers/logging.h"
 #include "managers/types.h"
+#ifdef ENABLE_WS_STATS
+#include "utils/latency_histogram.h"
+#endif
+#include "utils/token_bucket.h"
 #include "utils/uuid.h"
 #include "utils/value_unit.h"
 
@@ -28,6 +32,7 @@ namespace inamata {
 class WebSocket {
  public:
   enum class ConnectState { kConnected, kConnecting, kFailed };
+  enum class LinkType { kWifi, kGsm };
 
   using Callback = std::function<void(const JsonObjectConst& message)>;
   using CallbackMap = std::map<String, Callback>;
@@ -42,6 +47,7 @@ class WebSocket {
     Callback task_controller_callback;
     Callback lac_controller_callback;
     Callback ota_update_callback;
+    Callback log_export_callback;
     const char* core_domain;
     const char* ws_url_path;
     const char* ws_token;
@@ -59,6 +65,26 @@ class WebSocket {
         : message(std::move(message)), created_at(created_at), tries(tries) {}
   };
 
+  /// Message counters since the last report. The throughput and dispatch
+  /// counters are only collected with ENABLE_WS_STATS
+  struct Stats {
+    /// Telemetry dropped as the coalescing buffer was full
+    uint32_t dropped_telemetry = 0;
+#ifdef ENABLE_WS_STATS
+    uint32_t sent_messages = 0;
+    uint32_t sent_bytes = 0;
+    uint32_t failed_messages = 0;
+    uint32_t received_messages = 0;
+    /// Telemetry held back over budget, replaced or sent later
+    uint32_t coalesced_telemetry = 0;
+    /// Time the message handlers take to return. Does not include work they
+    /// defer to other tasks
+    utils::LatencyHistogram dispatch_duration;
+    std::chrono::steady_clock::time_point since =
+        std::chrono::steady_clock::now();
+#endif
+  };
+
   /**
    * Connection to the Inamata server over websockets.
    *
@@ -79,8 +105,27 @@ class WebSocket {
    */
   void resetConnectAttempt();
 
+  /**
+   * Send telemetry if the link's budget allows it, else coalesce it
+   *
+   * Coalesced telemetry keeps the latest reading per peripheral, initiator
+   * and set of data point types and is sent once the budget has recovered.
+   * Telemetry without data points (alerts) is always sent.
+   *
+   * \param data The telemetry message
+   * \param task_id The task that created the telemetry
+   * \param lac_id The LAC that created the telemetry
+   */
   void sendTelemetry(JsonObject data, const utils::UUID* task_id = nullptr,
                      const utils::UUID* lac_id = nullptr);
+
+  /**
+   * Select the telemetry budget of the link used to connect to the server
+   *
+   * \param link_type WiFi or GSM
+   */
+  void setLinkType(LinkType link_type);
+
   /**
    * Make a JSON object with the value units and UUID from the peripheral
    *
@@ -131,6 +176,17 @@ class WebSocket {
 
   void sendSystem(JsonObject data);
 
+  /**
+   * Add the message stats to a system message and reset them
+   *
+   * Adds the dropped telemetry. With ENABLE_WS_STATS also adds messages and
+   * bytes per second, failed sends, coalesced telemetry and the p50/p99/max
+   * durations to dispatch received messages to their handlers.
+   *
+   * \param data The system message to add the stats to
+   */
+  void addStats(JsonObject data);
+
   /**
    * Send or expire buffered retry messages
    */
@@ -164,6 +220,17 @@ class WebSocket {
   void setSentMessageCallback(std::function<void()> callback);
   void clearSentMessageCallback();
 
+  /**
+   * Set the check whether the link may be used to send messages
+   *
+   * While it returns false, telemetry is coalesced and other messages are
+   * deferred to the retry buffer. Used to keep the GSM client off the modem
+   * while it sends an SMS.
+   *
+   * \param callback Returns true if messages can be sent
+   */
+  void setCanSendCallback(std::function<bool()> callback);
+
   /**
    * Checks if the WebSocket connected to the server
    *
@@ -231,6 +298,9 @@ class WebSocket {
   void updateUpDownTime(const bool is_connected);
   void sendUpDownTimeData();
 
+  /// Send the duration of each boot stage once after the first connect
+  void sendBootProfile();
+
   void setResetReason(JsonObject& register_obj);
 
   /**
@@ -246,8 +316,50 @@ class WebSocket {
    */
   void sendJson(JsonVariantConst doc, const bool retry = false);
 
+  /**
+   * Consume a message and its bytes from the telemetry budget
+   *
+   * \param size Serialized size of the telemetry message
+   * \return True if the budget allowed it and was consumed
+   */
+  bool consumeTelemetryBudget(const size_t size);
+
+  /**
+   * Whether the link may be used according to the can send callback
+   *
+   * \return True if no callback is set or it allows sending
+   */
+  bool canSend() const;
+
+  /**
+   * Replace the pending reading of the same peripheral, initiator and data
+   * point types, or add it if there is none
+   *
+   * \param data Telemetry message with peripheral ID and data points
+   */
+  void coalesceTelemetry(JsonObjectConst data);
+
+  /**
+   * Send coalesced telemetry in FIFO order while the budget allows it
+   */
+  void handleCoalescedTelemetry();
+
+  /// Apply the budget of the currently used link to the token buckets
+  void applyTelemetryBudget();
+
   bool is_setup_ = false;
 
+  Stats stats_;
+
+  LinkType link_type_ = LinkType::kWifi;
+  utils::TokenBucket telemetry_byte_bucket_;
+  utils::TokenBucket telemetry_message_bucket_;
+  /// Latest pending reading per peripheral, initiator and data point types
+  std::map<String, JsonDocument> coalesced_telemetry_;
+  /// Keys of the pending readings in the order they were first coalesced
+  std::deque<String> coalesced_telemetry_order_;
+  static constexpr uint8_t kMaxCoalescedTelemetry_ = 32;
+
   std::deque<RetryMessage> retry_queue_;
   static constexpr uint8_t kMaxRetryMessages_ = 10;
   static constexpr uint8_t kMaxRetrySendAttempts_ = 5;
@@ -258,6 +370,7 @@ class WebSocket {
   bool was_connected_ = false;
   bool send_on_connect_messages_ = false;
   bool sent_register_message_ = false;
+  bool sent_boot_profile_ = false;
   /// The timepoint when the last connect attempt started
   std::chrono::steady_clock::time_point last_connect_start_ =
       std::chrono::steady_clock::time_point::min();
@@ -283,8 +396,10 @@ class WebSocket {
   Callback task_controller_callback_;
   Callback lac_controller_callback_;
   Callback ota_update_callback_;
+  Callback log_export_callback_;
 
   std::function<void()> sent_message_callback_;
+  std::function<bool()> can_send_callback_;
 
   String ws_token_;
   static const char* default_core_domain_;
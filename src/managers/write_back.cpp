@@ -0,0 +1,28 @@
+#include "write_back.h"
+
+namespace inamata {
+
+WriteBack::WriteBack(Clock::duration delay) : delay_(delay) {}
+
+void WriteBack::markDirty(Clock::time_point now) {
+  is_dirty_ = true;
+  changed_at_ = now;
+}
+
+void WriteBack::discard() { is_dirty_ = false; }
+
+bool WriteBack::isDirty() const { return is_dirty_; }
+
+bool WriteBack::handle(Clock::time_point now, bool force, const Step& write_tmp,
+                       const Step& replace) {
+  if (!is_dirty_ || (!force && now - changed_at_ < delay_)) {
+    return true;
+  }
+  if (!write_tmp() || !replace()) {
+    return false;
+  }
+  is_dirty_ = false;
+  return true;
+}
+
+}  // namespace inamata
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+namespace inamata {
+
+/**
+ * Writes cached data back to a file once it stopped changing
+ *
+ * The data is written to a temporary file that then replaces the file, so a
+ * power loss during the write keeps the previous file intact. The data stays
+ * dirty until both steps succeeded and is written again on the next call.
+ */
+class WriteBack {
+ public:
+  using Clock = std::chrono::steady_clock;
+  /// A step of the write. Returns false on an error
+  using Step = std::function<bool()>;
+
+  /**
+   * \param delay Time without changes before the data is written
+   */
+  WriteBack(Clock::duration delay);
+
+  /**
+   * Mark the cached data as changed
+   *
+   * \param now Time of the change
+   */
+  void markDirty(Clock::time_point now);
+
+  /**
+   * Drop the pending write, e.g. after the file system was wiped
+   */
+  void discard();
+
+  bool isDirty() const;
+
+  /**
+   * Write the dirty data if it did not change for the delay
+   *
+   * \param now Current time
+   * \param force Write without waiting for the delay
+   * \param write_tmp Writes the data to the temporary file
+   * \param replace Replaces the file with the temporary one
+   * \return False if a step failed
+   */
+  bool handle(Clock::time_point now, bool force, const Step& write_tmp,
+              const Step& replace);
+
+ private:
+  Clock::duration delay_;
+  bool is_dirty_ = false;
+  Clock::time_point changed_at_;
+};
+
+}  // namespace inamata
@@ -113,7 +113,7 @@ const char* config_1 =
 const char* config_2 =
     R"([
 {"rx":18,"tx":17,"dere":21,"baud_rate":9600,"uuid":"d4a92657-d4bc-490a-95e6-2ff9113c4852","type":"ModbusClientAdapter"},
-{"server":5,"address":1,"size":4,"inputs":[{"dpt":"2c87f3d4-9150-4582-a14e-4630b0779f5d","offset":0,"m":0.1},{"dpt":"8843470c-79aa-4db9-944c-d02b3b6f8c35","offset":1},{"dpt":"e22b2ea8-dd1c-4830-a6bd-b8dcfa1ba2cf","offset":2},{"dpt":"7f5db806-c165-48d9-b55b-176149db95d6","offset":3}],"uuid":"42bf607e-8079-4683-981c-1748acd4f703","adapter":"d4a92657-d4bc-490a-95e6-2ff9113c4852","type":"ModbusClientInput"},
+{"server":5,"address":1,"size":4,"max_age_ms":4000,"inputs":[{"dpt":"2c87f3d4-9150-4582-a14e-4630b0779f5d","offset":0,"m":0.1},{"dpt":"8843470c-79aa-4db9-944c-d02b3b6f8c35","offset":1},{"dpt":"e22b2ea8-dd1c-4830-a6bd-b8dcfa1ba2cf","offset":2},{"dpt":"7f5db806-c165-48d9-b55b-176149db95d6","offset":3}],"uuid":"42bf607e-8079-4683-981c-1748acd4f703","adapter":"d4a92657-d4bc-490a-95e6-2ff9113c4852","type":"ModbusClientInput"},
 {"server":5,"outputs":[{"dpt":"43b8759b-2f34-46b3-b47d-a59a68296517","address":2}],"uuid":"9499bab8-9809-431d-927f-fe42b94aa5dd","adapter":"d4a92657-d4bc-490a-95e6-2ff9113c4852","type":"ModbusClientOutput"}
 ])";
 
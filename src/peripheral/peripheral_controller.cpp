@@ -53,17 +53,23 @@ void PeripheralController::handleCallback(const JsonObjectConst& message) {
   if (add_commands) {
     JsonArray add_results =
         peripheral_results[add_command_key_].to<JsonArray>();
+    // Collect the added peripherals to save them in one pass
+    JsonDocument added_doc;
+    JsonArray added = added_doc.to<JsonArray>();
     for (JsonVariantConst add_command : add_commands) {
       ErrorResult error = add(add_command);
       if (!error.isError()) {
-        ErrorResult error = services_.getStorage()->savePeripheral(add_command);
-        if (error.isError()) {
-          Serial.printf("Saving err: %s\r\n", error.toString().c_str());
-        }
+        added.add(add_command);
       }
       WebSocket::addResultEntry(add_command[Peripheral::uuid_key_], error,
                                 add_results);
     }
+    if (added.size()) {
+      ErrorResult error = services_.getStorage()->savePeripherals(added);
+      if (error.isError()) {
+        Serial.printf("Saving err: %s\r\n", error.toString().c_str());
+      }
+    }
   }
 
   // Remove a peripheral for each command and store the result
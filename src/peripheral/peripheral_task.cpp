@@ -0,0 +1,16 @@
+#include "peripheral_task.h"
+
+namespace inamata {
+namespace peripheral {
+
+PeripheralTask::PeripheralTask(Scheduler& scheduler,
+                               std::function<void()> callback)
+    : Task(&scheduler), callback_(std::move(callback)) {}
+
+bool PeripheralTask::Callback() {
+  callback_();
+  return true;
+}
+
+}  // namespace peripheral
+}  // namespace inamata
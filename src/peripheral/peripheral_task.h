@@ -0,0 +1,34 @@
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+
+#include <functional>
+
+namespace inamata {
+namespace peripheral {
+
+/**
+ * Runs the background work of a peripheral from the scheduler
+ *
+ * Used by peripherals that sample, scan or flush buffered requests between
+ * the calls of their tasks. The interval, iterations and enabling are set by
+ * the peripheral. The peripheral has to own the task so that it is destroyed
+ * before the callback's captures.
+ */
+class PeripheralTask : public Task {
+ public:
+  /**
+   * \param scheduler The scheduler to run the task in
+   * \param callback Called on each run of the task
+   */
+  PeripheralTask(Scheduler& scheduler, std::function<void()> callback);
+  virtual ~PeripheralTask() = default;
+
+ private:
+  bool Callback() final;
+
+  std::function<void()> callback_;
+};
+
+}  // namespace peripheral
+}  // namespace inamata
@@ -1,5 +1,6 @@
 #include "ads1x15_adapter.h"
 
+#include "managers/services.h"
 #include "peripheral/peripheral_factory.h"
 
 namespace inamata {
@@ -27,10 +28,14 @@ ADS1X15Adapter::ADS1X15Adapter(const JsonObjectConst& parameters)
     setInvalid(variant_key_error_);
     return;
   }
+  // The scan period leaves a margin over the default data rate's conversion
+  // time of 0.625 ms (1600 SPS) and 7.8 ms (128 SPS) respectively
   if (input_type == "ads1015") {
     driver_ = std::unique_ptr<Adafruit_ADS1X15>(new Adafruit_ADS1015());
+    scan_period_ = std::chrono::milliseconds(2);
   } else if (input_type == "ads1115") {
     driver_ = std::unique_ptr<Adafruit_ADS1X15>(new Adafruit_ADS1115());
+    scan_period_ = std::chrono::milliseconds(10);
   } else {
     setInvalid(variant_key_error_);
     return;
@@ -48,6 +53,15 @@ ADS1X15Adapter::ADS1X15Adapter(const JsonObjectConst& parameters)
     setInvalid(invalid_chip_type_error_);
     return;
   }
+
+  // Optionally convert the inputs' channels continuously in the background
+  if (parameters[scan_key_].as<bool>()) {
+    scan_task_ = std::unique_ptr<PeripheralTask>(new PeripheralTask(
+        Services::getScheduler(),
+        std::bind(&ADS1X15Adapter::scanNextChannel, this)));
+    scan_task_->setInterval(std::chrono::milliseconds(scan_period_).count());
+    scan_task_->setIterations(TASK_FOREVER);
+  }
 }
 
 const String& ADS1X15Adapter::getType() const { return type(); }
@@ -125,6 +139,52 @@ void ADS1X15Adapter::startNextReading() {
   driver_->startADCReading(config.channel, false);
 }
 
+bool ADS1X15Adapter::isScanning() const { return scan_task_ != nullptr; }
+
+void ADS1X15Adapter::addScanChannel(uint16_t channel, adsGain_t gain) {
+  if (scan_schedule_.add(channel, gain)) {
+    scan_task_->enableIfNot();
+  }
+}
+
+void ADS1X15Adapter::removeScanChannel(uint16_t channel, adsGain_t gain) {
+  if (scan_schedule_.remove(channel, gain)) {
+    scan_task_->disable();
+  }
+}
+
+ADS1X15Adapter::Result ADS1X15Adapter::getScanReading(uint16_t channel,
+                                                      adsGain_t gain) const {
+  const ScanSchedule::Reading* reading = scan_schedule_.get(channel, gain);
+  if (!reading) {
+    return {.voltage = NAN,
+            .error = ErrorResult(type(), "Channel not scanned")};
+  }
+  if (std::isnan(reading->voltage)) {
+    return {.voltage = NAN,
+            .error = ErrorResult(type(), "No scan reading yet")};
+  }
+  if (std::chrono::steady_clock::now() - reading->read_at > kMaxScanAge) {
+    return {.voltage = NAN,
+            .error = ErrorResult(type(), "Stale scan reading")};
+  }
+  return {.voltage = reading->voltage};
+}
+
+void ADS1X15Adapter::scanNextChannel() {
+  // Convert the counts while the driver still has the channel's gain
+  scan_schedule_.step(
+      [this]() {
+        const int16_t adc_reading = driver_->getLastConversionResults();
+        return driver_->computeVolts(adc_reading);
+      },
+      [this](uint16_t channel, uint16_t gain) {
+        driver_->setGain(adsGain_t(gain));
+        driver_->startADCReading(channel, true);
+      },
+      std::chrono::steady_clock::now());
+}
+
 std::shared_ptr<Peripheral> ADS1X15Adapter::factory(
     const ServiceGetters& services, const JsonObjectConst& parameters) {
   return std::make_shared<ADS1X15Adapter>(parameters);
@@ -135,6 +195,7 @@ bool ADS1X15Adapter::registered_ =
 
 const __FlashStringHelper* ADS1X15Adapter::invalid_chip_type_error_ =
     FPSTR("Failed ADS1x15 setup");
+const __FlashStringHelper* ADS1X15Adapter::scan_key_ = FPSTR("scan");
 
 }  // namespace ads1x15
 }  // namespace peripherals
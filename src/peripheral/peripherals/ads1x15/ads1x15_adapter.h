@@ -3,10 +3,14 @@
 #include <Adafruit_ADS1X15.h>
 #include <ArduinoJson.h>
 
+#include <chrono>
 #include <deque>
+#include <memory>
 
 #include "peripheral/capabilities/start_measurement.h"
 #include "peripheral/peripheral.h"
+#include "peripheral/peripheral_task.h"
+#include "peripheral/peripherals/ads1x15/scan_schedule.h"
 #include "peripheral/peripherals/i2c/i2c_abstract_peripheral.h"
 
 namespace inamata {
@@ -63,7 +67,51 @@ class ADS1X15Adapter : public peripherals::i2c::I2CAbstractPeripheral {
    */
   Result completeReading(void* caller);
 
+  /**
+   * Whether the channels are scanned in continuous conversion mode
+   *
+   * In scan mode the single-shot readings must not be used. Inputs instead
+   * add their channel and gain to the scan and read the latest value.
+   */
+  bool isScanning() const;
+
+  /**
+   * Add a channel and gain pair to the scanned channels
+   *
+   * Pairs that are already scanned are shared by counting their users.
+   *
+   * \param channel A single ended or differential channel
+   * \param gain The gain to be used x2/3 to x16
+   */
+  void addScanChannel(uint16_t channel, adsGain_t gain);
+
+  /**
+   * Remove a user of a channel and gain pair from the scan
+   *
+   * \param channel A single ended or differential channel
+   * \param gain The gain to be used x2/3 to x16
+   */
+  void removeScanChannel(uint16_t channel, adsGain_t gain);
+
+  /**
+   * Get the latest value of a scanned channel and gain pair
+   *
+   * \param channel A single ended or differential channel
+   * \param gain The gain to be used x2/3 to x16
+   * \return The voltage. Error if none or too old
+   */
+  Result getScanReading(uint16_t channel, adsGain_t gain) const;
+
  private:
+  /**
+   * Store the conversion of the active channel and start the next one
+   *
+   * The ADC converts continuously and the task period is longer than a
+   * conversion, so the conversion register holds a result with the active
+   * channel's settings.
+   */
+  void scanNextChannel();
+
   /**
    * Start the next reading if any in the queued readings queue
    */
@@ -82,9 +130,19 @@ class ADS1X15Adapter : public peripherals::i2c::I2CAbstractPeripheral {
   const std::chrono::milliseconds default_wait_time_{10};
   /// List of all queued readings
   std::deque<ReadingConfig> queued_readings_;
+
+  /// Channel and gain pairs converted round-robin in scan mode
+  ScanSchedule scan_schedule_;
+  /// Reads the finished conversion and switches to the next scanned channel
+  std::unique_ptr<PeripheralTask> scan_task_;
+  /// Time between reading a scan channel and starting the next one
+  std::chrono::milliseconds scan_period_;
+  /// Values older than this indicate a stalled scan
+  static constexpr std::chrono::seconds kMaxScanAge{2};
+
   /// The error if the chip type does not match the expected values
   static const __FlashStringHelper* invalid_chip_type_error_;
-  /// If it is an ADS1015 or ADS1115
+  static const __FlashStringHelper* scan_key_;
 };
 
 }  // namespace ads1x15
@@ -76,6 +76,17 @@ ADS1X15Input::ADS1X15Input(const JsonObjectConst& parameters) {
       setInvalid(gain_key_error_);
     }
   }
+
+  if (isValid() && ads1x15_adapter_->isScanning()) {
+    ads1x15_adapter_->addScanChannel(channel_, gain_);
+    is_scanned_ = true;
+  }
+}
+
+ADS1X15Input::~ADS1X15Input() {
+  if (is_scanned_) {
+    ads1x15_adapter_->removeScanChannel(channel_, gain_);
+  }
 }
 
 const String& ADS1X15Input::getType() const { return type(); }
@@ -87,11 +98,17 @@ const String& ADS1X15Input::type() {
 
 capabilities::StartMeasurement::Result ADS1X15Input::startMeasurement(
     const JsonVariantConst& parameters) {
+  if (is_scanned_) {
+    return {};
+  }
   return ads1x15_adapter_->startADCReading(
       {.channel = channel_, .gain = gain_, .caller = static_cast<void*>(this)});
 }
 
 capabilities::StartMeasurement::Result ADS1X15Input::handleMeasurement() {
+  if (is_scanned_) {
+    return {};
+  }
   const auto wait = ads1x15_adapter_->isFinished(static_cast<void*>(this));
   if (wait < std::chrono::nanoseconds::zero()) {
     return ads1x15_adapter_->startADCReading(
@@ -105,8 +122,12 @@ capabilities::StartMeasurement::Result ADS1X15Input::handleMeasurement() {
 capabilities::GetValues::Result ADS1X15Input::getValues() {
   std::vector<utils::ValueUnit> values;
 
-  ADS1X15Adapter::Result result =
-      ads1x15_adapter_->completeReading(static_cast<void*>(this));
+  ADS1X15Adapter::Result result;
+  if (is_scanned_) {
+    result = ads1x15_adapter_->getScanReading(channel_, gain_);
+  } else {
+    result = ads1x15_adapter_->completeReading(static_cast<void*>(this));
+  }
   if (result.error.isError()) {
     return {.values = {}, .error = result.error};
   }
@@ -16,7 +16,7 @@ class ADS1X15Input : public Peripheral,
                      private Analog {
  public:
   ADS1X15Input(const JsonObjectConst& parameters);
-  virtual ~ADS1X15Input() = default;
+  virtual ~ADS1X15Input();
 
   // Type registration in the peripheral factory
   const String& getType() const final;
@@ -25,6 +25,9 @@ class ADS1X15Input : public Peripheral,
   /**
    * Start an ADC measurement
    *
+   * In scan mode the adapter already holds the latest value, so it completes
+   * immediately.
+   *
    * \param parameters
    * \return The time until the result is ready to be read (~8 ms)
    */
@@ -57,6 +60,8 @@ class ADS1X15Input : public Peripheral,
   uint16_t channel_;
 
   std::shared_ptr<ADS1X15Adapter> ads1x15_adapter_;
+  /// Whether the channel was added to the adapter's scan
+  bool is_scanned_ = false;
 
   adsGain_t gain_ = GAIN_TWO;
   static const __FlashStringHelper* gain_key_;
@@ -0,0 +1,72 @@
+#include "scan_schedule.h"
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace ads1x15 {
+
+bool ScanSchedule::add(uint16_t channel, uint16_t gain) {
+  for (Pair& pair : pairs_) {
+    if (pair.channel == channel && pair.gain == gain) {
+      pair.users++;
+      return false;
+    }
+  }
+  pairs_.push_back({.channel = channel, .gain = gain, .users = 1});
+  return true;
+}
+
+bool ScanSchedule::remove(uint16_t channel, uint16_t gain) {
+  for (size_t i = 0; i < pairs_.size(); i++) {
+    Pair& pair = pairs_[i];
+    if (pair.channel != channel || pair.gain != gain) {
+      continue;
+    }
+    pair.users--;
+    if (pair.users) {
+      break;
+    }
+    pairs_.erase(pairs_.begin() + i);
+    // Discard the active conversion if it or an earlier pair was removed
+    if (i <= active_) {
+      active_ = SIZE_MAX;
+    }
+    break;
+  }
+  return pairs_.empty();
+}
+
+void ScanSchedule::step(const ReadCallback& read, const StartCallback& start,
+                        std::chrono::steady_clock::time_point now) {
+  if (pairs_.empty()) {
+    return;
+  }
+
+  if (active_ < pairs_.size()) {
+    Reading& reading = pairs_[active_].reading;
+    reading.voltage = read();
+    reading.read_at = now;
+  }
+
+  const size_t next = active_ + 1 < pairs_.size() ? active_ + 1 : 0;
+  if (next == active_) {
+    return;
+  }
+  active_ = next;
+  start(pairs_[active_].channel, pairs_[active_].gain);
+}
+
+const ScanSchedule::Reading* ScanSchedule::get(uint16_t channel,
+                                               uint16_t gain) const {
+  for (const Pair& pair : pairs_) {
+    if (pair.channel == channel && pair.gain == gain) {
+      return &pair.reading;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace ads1x15
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace ads1x15 {
+
+/**
+ * Round-robin schedule of the channel and gain pairs of an ADC scan
+ *
+ * The ADC converts the active pair continuously. Each step stores the
+ * conversion of the active pair and then starts the next pair, so a stored
+ * value was always converted with its own pair's settings.
+ */
+class ScanSchedule {
+ public:
+  /// Reads the conversion of the active pair in volts
+  using ReadCallback = std::function<float()>;
+  /// Starts the continuous conversion of a channel and gain pair
+  using StartCallback = std::function<void(uint16_t channel, uint16_t gain)>;
+
+  /// The latest value of a scanned pair
+  struct Reading {
+    /// NAN until the first conversion was stored
+    float voltage = NAN;
+    std::chrono::steady_clock::time_point read_at;
+  };
+
+  /**
+   * Add a channel and gain pair to the scan
+   *
+   * Pairs that are already scanned are shared by counting their users.
+   *
+   * \param channel The mux value of the channel
+   * \param gain The PGA value of the gain
+   * \return True if the pair was not scanned yet
+   */
+  bool add(uint16_t channel, uint16_t gain);
+
+  /**
+   * Remove a user of a channel and gain pair from the scan
+   *
+   * \param channel The mux value of the channel
+   * \param gain The PGA value of the gain
+   * \return True if no pairs are left to scan
+   */
+  bool remove(uint16_t channel, uint16_t gain);
+
+  /**
+   * Store the conversion of the active pair and start the next pair
+   *
+   * With a single pair the conversion simply keeps running.
+   *
+   * \param read Reads the finished conversion of the active pair
+   * \param start Starts the conversion of the next pair
+   * \param now When the conversion was read
+   */
+  void step(const ReadCallback& read, const StartCallback& start,
+            std::chrono::steady_clock::time_point now);
+
+  /**
+   * Get the latest value of a channel and gain pair
+   *
+   * \param channel The mux value of the channel
+   * \param gain The PGA value of the gain
+   * \return The latest value or nullptr if the pair is not scanned
+   */
+  const Reading* get(uint16_t channel, uint16_t gain) const;
+
+ private:
+  struct Pair {
+    uint16_t channel;
+    uint16_t gain;
+    /// Number of inputs reading the pair
+    uint8_t users;
+    Reading reading;
+  };
+
+  std::vector<Pair> pairs_;
+  /// Index of the pair being converted, invalid if none started
+  size_t active_ = SIZE_MAX;
+};
+
+}  // namespace ads1x15
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -1,7 +1,11 @@
 #include "analog_in.h"
 
+#include <algorithm>
+
+#include "managers/services.h"
 #include "peripheral/peripheral_factory.h"
 #include "peripheral/peripherals/analog.h"
+#include "utils/error_store.h"
 
 namespace inamata {
 namespace peripheral {
@@ -33,6 +37,12 @@ AnalogIn::AnalogIn(const JsonObjectConst& parameters) {
   }
 
   String error = parseParameters(parameters);
+  if (!error.isEmpty()) {
+    setInvalid(error);
+    return;
+  }
+
+  error = parseFilterParameters(parameters);
   if (!error.isEmpty()) {
     setInvalid(error);
   }
@@ -47,7 +57,15 @@ const String& AnalogIn::type() {
 
 capabilities::GetValues::Result AnalogIn::getValues() {
   std::vector<utils::ValueUnit> values;
-  const uint16_t value = analogRead(pin_);
+  float value;
+  if (sample_task_) {
+    value = filter_.get();
+    if (std::isnan(value)) {
+      return {.values = {}, .error = ErrorResult(type(), "No samples yet")};
+    }
+  } else {
+    value = analogRead(pin_);
+  }
   const float voltage = value * 3.3 / 4096.0;
 
   if (voltage_data_point_type_.isValid()) {
@@ -73,6 +91,84 @@ capabilities::GetValues::Result AnalogIn::getValues() {
   return {.values = values, .error = ErrorResult()};
 }
 
+String AnalogIn::parseFilterParameters(const JsonObjectConst& parameters) {
+  JsonVariantConst oversampling = parameters[oversampling_key_];
+  if (!oversampling.isNull()) {
+    if (!oversampling.is<uint8_t>() || oversampling.as<uint8_t>() < 1 ||
+        oversampling.as<uint8_t>() > kMaxOversampling) {
+      return ErrorStore::genMissingProperty(
+          oversampling_key_, ErrorStore::KeyType::kUint32t, true);
+    }
+    oversampling_ = oversampling.as<uint8_t>();
+  }
+
+  // An odd window so the median is always one of the samples
+  JsonVariantConst median_window = parameters[median_window_key_];
+  if (!median_window.isNull()) {
+    if (!median_window.is<uint8_t>() || median_window.as<uint8_t>() % 2 == 0 ||
+        median_window.as<uint8_t>() > kMaxMedianWindow) {
+      return ErrorStore::genMissingProperty(
+          median_window_key_, ErrorStore::KeyType::kUint32t, true);
+    }
+    filter_.setMedianWindow(median_window.as<uint8_t>());
+  }
+
+  JsonVariantConst filter = parameters[filter_key_];
+  if (!filter.isNull()) {
+    SampleFilter::Smoothing smoothing;
+    if (filter == "ema") {
+      smoothing = SampleFilter::Smoothing::kEma;
+    } else if (filter == "boxcar") {
+      smoothing = SampleFilter::Smoothing::kBoxcar;
+    } else {
+      return ErrorStore::genMissingProperty(
+          filter_key_, ErrorStore::KeyType::kString, true);
+    }
+    JsonVariantConst filter_window = parameters[filter_window_key_];
+    if (!filter_window.is<uint8_t>() || filter_window.as<uint8_t>() < 1 ||
+        filter_window.as<uint8_t>() > kMaxFilterWindow) {
+      return ErrorStore::genMissingProperty(
+          filter_window_key_, ErrorStore::KeyType::kUint32t);
+    }
+    filter_.setSmoothing(smoothing, filter_window.as<uint8_t>());
+  }
+
+  // Without any filtering, getValues reads the ADC directly
+  if (oversampling_ == 1 && !filter_.isFiltering()) {
+    return String();
+  }
+
+  std::chrono::milliseconds sample_interval(100);
+  JsonVariantConst sample_interval_ms = parameters[sample_interval_ms_key_];
+  if (!sample_interval_ms.isNull()) {
+    if (!sample_interval_ms.is<uint32_t>() ||
+        std::chrono::milliseconds(sample_interval_ms.as<uint32_t>()) <
+            kMinSampleInterval) {
+      return ErrorStore::genMissingProperty(
+          sample_interval_ms_key_, ErrorStore::KeyType::kUint32t, true);
+    }
+    sample_interval =
+        std::chrono::milliseconds(sample_interval_ms.as<uint32_t>());
+  }
+
+  sample_task_ = std::unique_ptr<PeripheralTask>(new PeripheralTask(
+      Services::getScheduler(), std::bind(&AnalogIn::sample, this)));
+  sample_task_->setInterval(sample_interval.count());
+  sample_task_->setIterations(TASK_FOREVER);
+  sample_task_->enable();
+  return String();
+}
+
+float AnalogIn::readOversampled() {
+  uint32_t sum = 0;
+  for (uint8_t i = 0; i < oversampling_; i++) {
+    sum += analogRead(pin_);
+  }
+  return float(sum) / oversampling_;
+}
+
+void AnalogIn::sample() { filter_.add(readOversampled()); }
+
 std::shared_ptr<Peripheral> AnalogIn::factory(
     const ServiceGetters& services, const JsonObjectConst& parameters) {
   return std::make_shared<AnalogIn>(parameters);
@@ -89,6 +185,15 @@ const std::array<uint8_t, 8> AnalogIn::valid_pins_ = {
 };
 const __FlashStringHelper* AnalogIn::invalid_pin_error_ =
     FPSTR("Pin # not valid (only ADC1: 32 - 39)");
+const __FlashStringHelper* AnalogIn::oversampling_key_ =
+    FPSTR("oversampling");
+const __FlashStringHelper* AnalogIn::median_window_key_ =
+    FPSTR("median_window");
+const __FlashStringHelper* AnalogIn::filter_key_ = FPSTR("filter");
+const __FlashStringHelper* AnalogIn::filter_window_key_ =
+    FPSTR("filter_window");
+const __FlashStringHelper* AnalogIn::sample_interval_ms_key_ =
+    FPSTR("sample_interval_ms");
 
 }  // namespace analog_in
 }  // namespace peripherals
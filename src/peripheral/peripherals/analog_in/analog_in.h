@@ -2,12 +2,15 @@
 
 #include <ArduinoJson.h>
 
+#include <chrono>
 #include <memory>
 
 #include "managers/service_getters.h"
 #include "peripheral/capabilities/get_values.h"
 #include "peripheral/peripheral.h"
+#include "peripheral/peripheral_task.h"
 #include "peripheral/peripherals/analog.h"
+#include "peripheral/peripherals/analog_in/sample_filter.h"
 
 namespace inamata {
 namespace peripheral {
@@ -15,7 +18,12 @@ namespace peripherals {
 namespace analog_in {
 
 /**
- * Peripheral to control a GPIO output
+ * Peripheral to read an analog input pin
+ *
+ * Optionally filters the readings. A background task then takes a sample every
+ * interval, each the mean of several ADC reads (oversampling). Spikes are
+ * removed by a median over the last samples before an EMA or boxcar filter
+ * smooths them. getValues returns the filtered value without reading the ADC.
  */
 class AnalogIn : public Peripheral,
                  public capabilities::GetValues,
@@ -29,22 +37,61 @@ class AnalogIn : public Peripheral,
   static const String& type();
 
   /**
-   * Get the GPIO state
+   * Get the analog reading as voltage, percent and mapped unit
    *
-   * \return The value 1 represents the high state, 0 its low state
+   * \return The filtered reading if filtering is enabled, else a direct one
    */
   capabilities::GetValues::Result getValues() final;
 
  private:
+  /**
+   * Parse the optional oversampling and filter parameters
+   *
+   * \param parameters The peripheral's parameters
+   * \return An error message if a parameter is invalid, else empty
+   */
+  String parseFilterParameters(const JsonObjectConst& parameters);
+
+  /**
+   * Read the ADC and average the reads
+   *
+   * \return The mean of oversampling_ reads in ADC counts
+   */
+  float readOversampled();
+
+  /**
+   * Take a sample and pass it through the median and smoothing filters
+   */
+  void sample();
+
   static std::shared_ptr<Peripheral> factory(const ServiceGetters& services,
                                              const JsonObjectConst& parameter);
   static bool registered_;
   static bool capability_get_values_;
 
-  /// The pin to be used as a GPIO output
+  /// The pin to be used as an analog input
   unsigned int pin_;
   static const std::array<uint8_t, 8> valid_pins_;
   static const __FlashStringHelper* invalid_pin_error_;
+
+  /// ADC reads averaged per sample
+  uint8_t oversampling_ = 1;
+  /// Filters the readings in ADC counts
+  SampleFilter filter_;
+  /// Takes a filtered sample every interval
+  std::unique_ptr<PeripheralTask> sample_task_;
+
+  static constexpr uint8_t kMaxOversampling = 64;
+  static constexpr uint8_t kMaxMedianWindow = SampleFilter::kMaxMedianWindow;
+  static constexpr uint8_t kMaxFilterWindow = 64;
+  /// Shortest sample interval, limits the CPU time spent reading
+  static constexpr std::chrono::milliseconds kMinSampleInterval{10};
+
+  static const __FlashStringHelper* oversampling_key_;
+  static const __FlashStringHelper* median_window_key_;
+  static const __FlashStringHelper* filter_key_;
+  static const __FlashStringHelper* filter_window_key_;
+  static const __FlashStringHelper* sample_interval_ms_key_;
 };
 
 }  // namespace analog_in
@@ -0,0 +1,78 @@
+#include "sample_filter.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace analog_in {
+
+void SampleFilter::setMedianWindow(uint8_t window) {
+  window = std::min(window, kMaxMedianWindow);
+  median_samples_.assign(window > 1 ? window : 0, 0);
+  median_index_ = 0;
+  median_full_ = false;
+}
+
+void SampleFilter::setSmoothing(Smoothing smoothing, uint8_t window) {
+  smoothing_ = smoothing;
+  ema_alpha_ = 2.0 / (window + 1);
+  boxcar_samples_.assign(smoothing == Smoothing::kBoxcar ? window : 0, 0);
+  boxcar_index_ = 0;
+  boxcar_count_ = 0;
+}
+
+bool SampleFilter::isFiltering() const {
+  return !median_samples_.empty() || smoothing_ != Smoothing::kNone;
+}
+
+float SampleFilter::add(float sample) {
+  float value = sample;
+
+  // Remove spikes by taking the median of the last samples
+  if (!median_samples_.empty()) {
+    median_samples_[median_index_] = value;
+    median_index_++;
+    if (median_index_ == median_samples_.size()) {
+      median_index_ = 0;
+      median_full_ = true;
+    }
+    const size_t count = median_full_ ? median_samples_.size() : median_index_;
+    auto sorted_end = std::copy_n(median_samples_.begin(), count,
+                                  median_scratch_.begin());
+    auto middle = median_scratch_.begin() + count / 2;
+    std::nth_element(median_scratch_.begin(), middle, sorted_end);
+    value = *middle;
+  }
+
+  switch (smoothing_) {
+    case Smoothing::kEma:
+      if (std::isnan(filtered_)) {
+        filtered_ = value;
+      } else {
+        filtered_ += ema_alpha_ * (value - filtered_);
+      }
+      break;
+    case Smoothing::kBoxcar:
+      boxcar_samples_[boxcar_index_] = value;
+      boxcar_index_ = (boxcar_index_ + 1) % boxcar_samples_.size();
+      boxcar_count_ = std::min(boxcar_count_ + 1, boxcar_samples_.size());
+      filtered_ = std::accumulate(boxcar_samples_.begin(),
+                                  boxcar_samples_.begin() + boxcar_count_,
+                                  0.0f) /
+                  boxcar_count_;
+      break;
+    default:
+      filtered_ = value;
+      break;
+  }
+  return filtered_;
+}
+
+float SampleFilter::get() const { return filtered_; }
+
+}  // namespace analog_in
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace analog_in {
+
+/**
+ * Filters a stream of samples
+ *
+ * Spikes are removed by a median over the last samples before an EMA or
+ * boxcar filter smooths them. Each filter is optional.
+ */
+class SampleFilter {
+ public:
+  /// Smoothing filter applied after the median filter
+  enum class Smoothing {
+    kNone,
+    /// Exponential moving average with alpha = 2 / (window + 1)
+    kEma,
+    /// Mean of the last window samples
+    kBoxcar,
+  };
+
+  /// Max samples to take the median of
+  static constexpr uint8_t kMaxMedianWindow = 15;
+
+  /**
+   * Set the number of samples to take the median of
+   *
+   * \param window An odd number of samples up to kMaxMedianWindow, 1 to
+   *   disable the median filter
+   */
+  void setMedianWindow(uint8_t window);
+
+  /**
+   * Set the smoothing filter
+   *
+   * \param smoothing The filter to apply after the median filter
+   * \param window The samples to smooth over, at least 1
+   */
+  void setSmoothing(Smoothing smoothing, uint8_t window);
+
+  /**
+   * Whether any filter is set
+   *
+   * \return True if samples are changed by the filter
+   */
+  bool isFiltering() const;
+
+  /**
+   * Add a sample and update the filtered value
+   *
+   * \param sample The new sample
+   * \return The filtered value
+   */
+  float add(float sample);
+
+  /**
+   * Get the filtered value
+   *
+   * \return The filtered value, NAN until the first sample
+   */
+  float get() const;
+
+ private:
+  /// Last samples for the median filter, used as a ring buffer
+  std::vector<float> median_samples_;
+  size_t median_index_ = 0;
+  /// Whether the ring buffer was filled once
+  bool median_full_ = false;
+  /// Partially sorted copy of the median samples, kept to not allocate
+  std::array<float, kMaxMedianWindow> median_scratch_;
+
+  Smoothing smoothing_ = Smoothing::kNone;
+  float ema_alpha_ = 1;
+  /// Last median filtered samples for the boxcar filter
+  std::vector<float> boxcar_samples_;
+  size_t boxcar_index_ = 0;
+  size_t boxcar_count_ = 0;
+
+  float filtered_ = NAN;
+};
+
+}  // namespace analog_in
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -1,5 +1,7 @@
 #include "cse7766.h"
 
+#include <algorithm>
+
 #include "peripheral/peripheral_factory.h"
 
 namespace inamata {
@@ -7,8 +9,10 @@ namespace peripheral {
 namespace peripherals {
 namespace cse7766 {
 
-CSE7766::CSE7766(const JsonObjectConst& parameters)
-    : UARTAbstractPeripheral(parameters) {
+CSE7766::CSE7766(const ServiceGetters& services,
+                 const JsonObjectConst& parameters)
+    : UARTAbstractPeripheral(parameters),
+      energy_counter_(services.getStorage()) {
   // If the base class constructor failed, abort the constructor
   if (!isValid()) {
     return;
@@ -39,6 +43,10 @@ CSE7766::CSE7766(const JsonObjectConst& parameters)
                                               ErrorStore::KeyType::kUUID));
     return;
   }
+
+  // Optional data point type for the accumulated energy
+  energy_data_point_type_ =
+      utils::UUID(parameters[energy_data_point_type_key_]);
 }
 
 const String& CSE7766::getType() const { return type(); }
@@ -50,8 +58,11 @@ const String& CSE7766::type() {
 
 capabilities::StartMeasurement::Result CSE7766::startMeasurement(
     const JsonVariantConst& parameters) {
+  // Parse the frames buffered before the start, so that only a frame received
+  // after it completes the measurement
+  readFrame();
   resetState();
-  return readFrame();
+  return capabilities::StartMeasurement::Result{.wait = no_data_wait_};
 }
 
 capabilities::StartMeasurement::Result CSE7766::handleMeasurement() {
@@ -67,17 +78,24 @@ capabilities::StartMeasurement::Result CSE7766::handleMeasurement() {
 }
 
 capabilities::GetValues::Result CSE7766::getValues() {
-  if (in_data_[0] == 0xAA) {
+  if (!parser_.hasFrame()) {
+    return capabilities::GetValues::Result{
+        .error = ErrorResult(type(), "No frame")};
+  }
+  const uint8_t* frame = parser_.getFrame();
+  if (frame[0] == 0xAA) {
     return capabilities::GetValues::Result{
         .error = ErrorResult(type(), "Not calibrated")};
   }
 
   capabilities::GetValues::Result result;
-  const uint8_t adj = in_data_[adj_offset];
+  const uint8_t adj = frame[adj_offset];
 
   if (adj & adj_voltage_mask) {
-    const double voltage_coef = parse24bit(in_data_ + voltage_coef_offset);
-    const double voltage_cycle = parse24bit(in_data_ + voltage_cycle_offset);
+    const double voltage_coef =
+        CseFrameParser::parse24bit(frame + voltage_coef_offset);
+    const double voltage_cycle =
+        CseFrameParser::parse24bit(frame + voltage_cycle_offset);
     const float voltage = voltage_coef / voltage_cycle;
     result.values.push_back(
         utils::ValueUnit(voltage, voltage_data_point_type_));
@@ -87,10 +105,12 @@ capabilities::GetValues::Result CSE7766::getValues() {
   if (adj & adj_power_mask) {
     // Ensure abnormal header and power out-of-range bit are not set.
     // Otherwise set power as off
-    if ((in_data_[0] & power_oor_value) != power_oor_value) {
+    if ((frame[0] & power_oor_value) != power_oor_value) {
       is_power_valid = true;
-      const double power_coef = parse24bit(in_data_ + power_coef_offset);
-      const double power_cycle = parse24bit(in_data_ + power_cycles_offset);
+      const double power_coef =
+          CseFrameParser::parse24bit(frame + power_coef_offset);
+      const double power_cycle =
+          CseFrameParser::parse24bit(frame + power_cycles_offset);
       power = power_coef / power_cycle;
     }
   }
@@ -98,8 +118,10 @@ capabilities::GetValues::Result CSE7766::getValues() {
   float current = 0.0;
   if (adj & adj_current_mask) {
     if (is_power_valid) {
-      const double current_coef = parse24bit(in_data_ + current_coef_offset);
-      const double current_cycle = parse24bit(in_data_ + current_cycle_offset);
+      const double current_coef =
+          CseFrameParser::parse24bit(frame + current_coef_offset);
+      const double current_cycle =
+          CseFrameParser::parse24bit(frame + current_cycle_offset);
       current = current_coef / current_cycle;
     }
   }
@@ -110,6 +132,11 @@ capabilities::GetValues::Result CSE7766::getValues() {
         utils::ValueUnit(current, current_data_point_type_));
   }
 
+  if (energy_data_point_type_.isValid() && energy_counter_.isLoaded()) {
+    result.values.push_back(
+        utils::ValueUnit(energy_counter_.getKwh(), energy_data_point_type_));
+  }
+
   // Mark frame as being read and allow frame to be cleared for next poll
   got_values_ = true;
 
@@ -117,88 +144,53 @@ capabilities::GetValues::Result CSE7766::getValues() {
 }
 
 capabilities::StartMeasurement::Result CSE7766::readFrame() {
-  while (true) {
-    // Check if a valid frame has been read (once frame is full).
-    if (in_data_i_ >= sizeof(in_data_)) {
-      // Sum all bytes (with overflow) excluding header and checksum bytes
-      uint8_t checksum = 0;
-      for (uint8_t i = 2; i < checksum_offset; i++) {
-        checksum += in_data_[i];
-      }
-      // On invalid checksum, read new frame
-      if (checksum != in_data_[checksum_offset]) {
-        in_data_i_ = 0;
-        invalid_byte_count_ += sizeof(in_data_);
-        continue;
-      } else {
-        // Frame read successfully, can now get values from frame
-        return capabilities::StartMeasurement::Result();
-      }
+  HardwareSerial* serial = uart_adapter_->getSerial();
+  // Only drain the bytes already received to never block the scheduler
+  int available = serial->available();
+  uint8_t buffer[32];
+  while (available > 0) {
+    const size_t byte_count =
+        serial->read(buffer, std::min<size_t>(available, sizeof(buffer)));
+    if (byte_count == 0) {
+      break;
     }
-
-    // Read bytes while available (not -1), wait if no valid data available
-    int byte_read = uart_adapter_->getSerial()->read();
-    if (byte_read == -1) {
-      return capabilities::StartMeasurement::Result{.wait = no_data_wait_};
-    }
-    // If more than two frame lengths of invalid bytes were read, then
-    // clear input buffer (at most 512 bytes) and wait for new attempt
-    if (invalid_byte_count_ &&
-        invalid_byte_count_ % (sizeof(in_data_) * 2) == 0) {
-      HardwareSerial* serial = uart_adapter_->getSerial();
-      uint8_t buffer[64];
-      for (int i = 0; i < 8; i++) {
-        // Will block for 1s due to HardwareSerial timeout
-        size_t byte_count = serial->readBytes(buffer, sizeof(buffer));
-        if (byte_count != sizeof(buffer)) {
-          break;
-        }
-      }
-      invalid_byte_count_++;
-      return capabilities::StartMeasurement::Result{.wait = no_data_wait_};
+    available -= byte_count;
+    if (parser_.parse(buffer, byte_count)) {
+      has_new_frame_ = true;
+      countEnergy();
     }
+  }
 
-    // If first byte is invalid, read next byte and check it
-    if (in_data_i_ == 0 && byte_read != 0x55 && byte_read < 0xF0 &&
-        byte_read != 0xAA) {
-      invalid_byte_count_++;
-      continue;
-    }
-    // If the second byte is invalid, restart reading frame
-    if (in_data_i_ == 1 && byte_read != 0x5A) {
-      in_data_i_ = 0;
-      invalid_byte_count_ += 2;
-      continue;
-    }
-    // Save byte at index and increment index
-    in_data_[in_data_i_] = byte_read;
-    in_data_i_++;
+  if (has_new_frame_) {
+    return capabilities::StartMeasurement::Result();
   }
+  return capabilities::StartMeasurement::Result{.wait = no_data_wait_};
+}
+
+void CSE7766::countEnergy() {
+  if (!energy_data_point_type_.isValid()) {
+    return;
+  }
+  const uint8_t* frame = parser_.getFrame();
+
+  const uint16_t pf = CseFrameParser::parse16bit(frame + pf_offset);
+  const uint32_t power_coef =
+      CseFrameParser::parse24bit(frame + power_coef_offset);
+  energy_counter_.add(id, pulse_energy_.update(pf, power_coef));
 }
 
 void CSE7766::resetState() {
   // Set after reading frame and getting values
   got_values_ = false;
-  // Clear frame data and errors
-  memset(in_data_, 0, sizeof(in_data_));
-  in_data_i_ = 0;
-  invalid_byte_count_ = 0;
+  // Wait for a frame received after this point. Partial frames are kept
+  has_new_frame_ = false;
   // Start time of reading a new frame
   measurement_start_ = std::chrono::steady_clock::now();
 }
 
-uint32_t CSE7766::parse24bit(uint8_t* first_byte) {
-  return uint32_t(*first_byte) << 16 | uint32_t(*(first_byte + 1)) << 8 |
-         uint32_t(*(first_byte + 2));
-}
-
-uint32_t CSE7766::parse16bit(uint8_t* first_byte) {
-  return uint32_t(*first_byte) << 8 | uint32_t(*(first_byte + 1));
-}
-
 std::shared_ptr<Peripheral> CSE7766::factory(
     const ServiceGetters& services, const JsonObjectConst& parameters) {
-  return std::make_shared<CSE7766>(parameters);
+  return std::make_shared<CSE7766>(services, parameters);
 }
 
 bool CSE7766::registered_ = PeripheralFactory::registerFactory(type(), factory);
@@ -215,6 +207,8 @@ const __FlashStringHelper* CSE7766::current_data_point_type_key_ =
     FPSTR("current_data_point_type");
 const __FlashStringHelper* CSE7766::power_data_point_type_key_ =
     FPSTR("power_data_point_type");
+const __FlashStringHelper* CSE7766::energy_data_point_type_key_ =
+    FPSTR("energy_data_point_type");
 
 }  // namespace cse7766
 }  // namespace peripherals
@@ -1,5 +1,8 @@
+#include "managers/service_getters.h"
 #include "peripheral/capabilities/get_values.h"
 #include "peripheral/capabilities/start_measurement.h"
+#include "peripheral/peripherals/cse_frame_parser.h"
+#include "peripheral/peripherals/energy_counter.h"
 #include "peripheral/peripherals/uart/uart_abstract_peripheral.h"
 
 namespace inamata {
@@ -10,15 +13,20 @@ namespace cse7766 {
 /**
  * Driver for CSE7766, an electrical energy measurement chip
  *
- * UART baud rate is 4800 bps with an 8E1 encoding but 8N1 also works. Reads a
- * data frame via the startMeasurement interface and values from the buffered
- * data frame can be read via the getValues interface.
+ * UART baud rate is 4800 bps with an 8E1 encoding but 8N1 also works. The
+ * chip sends a frame every 50ms. Each call only parses the bytes already
+ * received, so it never blocks. A measurement is ready once a valid frame was
+ * received after it started and getValues returns the most recent valid frame.
+ *
+ * If an energy data point type is set, the active energy is counted from the
+ * chip's PF pulse register and reported in kWh. The 16-bit register wraps
+ * after ~65k pulses, so it has to be polled before then (hours at 2kW).
  */
 class CSE7766 : public uart::UARTAbstractPeripheral,
                 public capabilities::GetValues,
                 public capabilities::StartMeasurement {
  public:
-  CSE7766(const JsonObjectConst& parameters);
+  CSE7766(const ServiceGetters& services, const JsonObjectConst& parameters);
   virtual ~CSE7766() = default;
 
   // Type registration in the peripheral factory
@@ -26,10 +34,13 @@ class CSE7766 : public uart::UARTAbstractPeripheral,
   static const String& type();
 
   /**
-   * Reset state and start reading data frame from CSE7766
+   * Reset state and wait for a data frame from CSE7766
+   *
+   * Frames received before the start are parsed but do not complete the
+   * measurement.
    *
    * @param parameters No parameters expected
-   * @return Error, wait or ready depending on read frame
+   * @return Wait for the next frame
    */
   capabilities::StartMeasurement::Result startMeasurement(
       const JsonVariantConst& parameters) final;
@@ -37,10 +48,10 @@ class CSE7766 : public uart::UARTAbstractPeripheral,
   /**
    * Reads data frame CSE7766 and handle reset or timeout
    *
-   * - Attempt to read full and valid data frame from CSE7766 via UART/serial
+   * - Parse the bytes received from CSE7766 via UART/serial since the last call
    * - Reset state after having read the values and start new timeout
    * - Return timeout error if values not ready or read due to timeout
-   * - Return wait on no data or too many invalid bytes
+   * - Return wait if no new valid frame was received
    *
    * \return A vector with all read data points and their type
    */
@@ -58,43 +69,30 @@ class CSE7766 : public uart::UARTAbstractPeripheral,
                                              const JsonObjectConst& parameters);
 
   /**
-   * Read data frame until valid frame or fault occurs
+   * Parse the bytes available on the UART without waiting for more
    *
-   * @return Blank on success, wait if fault occurs
+   * @return Blank if a new valid frame was received, else wait
    */
   capabilities::StartMeasurement::Result readFrame();
 
   /**
-   * Reset frame buffer, error counter and timeout
+   * Count the energy of the PF pulses since the previous frame
    */
-  void resetState();
+  void countEnergy();
 
   /**
-   * Parse a 24-bit MSB/big-endian uint
-   *
-   * @param first_byte Pointer to first byte of 24-bit uint
-   * @return Parsed uint stored in a native 32-bit uint
+   * Start waiting for a new frame and reset the timeout
    */
-  static uint32_t parse24bit(uint8_t* first_byte);
-
-  /**
-   * Parse a 16-bit MSB/big-endian uint
-   *
-   * @param first_byte Pointer to first byte of 16-bit uint
-   * @return Parsed uint stored in a native 32-bit uint
-   */
-  static uint32_t parse16bit(uint8_t* first_byte);
+  void resetState();
 
   static bool registered_;
   static bool capability_get_values_;
   static bool capability_start_measurement_;
 
-  /// Buffer for a data frame (frame is 24 bytes)
-  uint8_t in_data_[24];
-  /// Index of the data frame buffer
-  uint8_t in_data_i_;
-  /// Number of invalid bytes read
-  uint32_t invalid_byte_count_;
+  /// Assembles the received bytes and keeps the most recent valid frame
+  CseFrameParser parser_;
+  /// Whether a valid frame was received since the measurement started
+  bool has_new_frame_ = false;
   /// Whether values from frame buffer were read
   bool got_values_ = false;
   /// When reading the frame buffer started (for timeout)
@@ -125,11 +123,12 @@ class CSE7766 : public uart::UARTAbstractPeripheral,
   static constexpr uint8_t power_cycles_offset = 17;
   /// Byte offset (position) in frame for 'adj' flags
   static constexpr uint8_t adj_offset = 20;
-  /// Byte offset (position) in frame for frame checksum
-  static constexpr uint8_t checksum_offset = 23;
+  /// Byte offset (position) in frame for the 16-bit PF pulse count
+  static constexpr uint8_t pf_offset = 21;
 
   /// Bitmask for header 1 byte if errors occured
-  static constexpr uint8_t header_error_mask = 0xF0;
+  static constexpr uint8_t header_error_mask =
+      CseFrameParser::header_error_mask;
   /// Power Out-of-Range error - No electrical consumer / no current
   static constexpr uint8_t power_oor_value = header_error_mask | 1 << 1;
   /// Current Out-of-Range error - No electrical consumer / no current
@@ -151,6 +150,16 @@ class CSE7766 : public uart::UARTAbstractPeripheral,
   utils::UUID power_data_point_type_{nullptr};
   /// Key in parameters dict for the ID of power data point type
   static const __FlashStringHelper* power_data_point_type_key_;
+
+  /// ID of the optional energy data point type (kWh)
+  utils::UUID energy_data_point_type_{nullptr};
+  /// Key in parameters dict for the ID of energy data point type
+  static const __FlashStringHelper* energy_data_point_type_key_;
+
+  /// The accumulated active energy
+  EnergyCounter energy_counter_;
+  /// Energy of the PF pulses between frames
+  PulseEnergy pulse_energy_;
 };
 
 }  // namespace cse7766
@@ -0,0 +1,85 @@
+#include "cse_frame_parser.h"
+
+#include <cstring>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+
+size_t CseFrameParser::parse(const uint8_t* data, size_t size) {
+  size_t frame_count = 0;
+  for (size_t i = 0; i < size; i++) {
+    if (parseByte(data[i])) {
+      frame_count++;
+    }
+  }
+  return frame_count;
+}
+
+bool CseFrameParser::hasFrame() const { return has_frame_; }
+
+const uint8_t* CseFrameParser::getFrame() const { return frame_; }
+
+uint32_t CseFrameParser::parse24bit(const uint8_t* first_byte) {
+  return uint32_t(*first_byte) << 16 | uint32_t(*(first_byte + 1)) << 8 |
+         uint32_t(*(first_byte + 2));
+}
+
+uint32_t CseFrameParser::parse16bit(const uint8_t* first_byte) {
+  return uint32_t(*first_byte) << 8 | uint32_t(*(first_byte + 1));
+}
+
+bool CseFrameParser::parseByte(const uint8_t byte) {
+  // Wait for the first header byte to start a frame
+  if (in_data_i_ == 0 && !isHeader(byte)) {
+    return false;
+  }
+  // On an invalid second header byte, check if it starts a frame instead
+  if (in_data_i_ == 1 && byte != header_2_value) {
+    in_data_i_ = 0;
+    return parseByte(byte);
+  }
+  // Save byte at index and increment index
+  in_data_[in_data_i_] = byte;
+  in_data_i_++;
+  if (in_data_i_ < sizeof(in_data_)) {
+    return false;
+  }
+
+  // Sum all bytes (with overflow) excluding header and checksum bytes
+  uint8_t checksum = 0;
+  for (uint8_t i = 2; i < checksum_offset; i++) {
+    checksum += in_data_[i];
+  }
+  if (checksum != in_data_[checksum_offset]) {
+    resyncFrame();
+    return false;
+  }
+  // Keep the frame so that the most recent valid one can be read
+  memcpy(frame_, in_data_, sizeof(frame_));
+  has_frame_ = true;
+  in_data_i_ = 0;
+  return true;
+}
+
+void CseFrameParser::resyncFrame() {
+  // The frame may have started within the invalid one
+  for (uint8_t i = 1; i < sizeof(in_data_); i++) {
+    const bool is_last = i + 1 == sizeof(in_data_);
+    if (isHeader(in_data_[i]) &&
+        (is_last || in_data_[i + 1] == header_2_value)) {
+      in_data_i_ = sizeof(in_data_) - i;
+      memmove(in_data_, in_data_ + i, in_data_i_);
+      return;
+    }
+  }
+  in_data_i_ = 0;
+}
+
+bool CseFrameParser::isHeader(const uint8_t byte) {
+  return byte == 0x55 || byte == 0xAA || byte >= header_error_mask;
+}
+
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
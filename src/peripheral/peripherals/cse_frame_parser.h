@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+
+/**
+ * Assembles the 24 byte frames sent by CSE7766 and CSE6677 chips
+ *
+ * Bytes are parsed incrementally as they are received, so a frame may be
+ * split across calls. Frames are synced on the two header bytes and only kept
+ * if their checksum is valid. On an invalid checksum, parsing continues at the
+ * next header within the frame instead of dropping it.
+ */
+class CseFrameParser {
+ public:
+  /**
+   * Parse received bytes
+   *
+   * \param data The received bytes
+   * \param size The number of received bytes
+   * \return The number of valid frames completed by the bytes
+   */
+  size_t parse(const uint8_t* data, size_t size);
+
+  /**
+   * Whether a valid frame was received since the parser was created
+   *
+   * \return True if getFrame returns a valid frame
+   */
+  bool hasFrame() const;
+
+  /**
+   * Get the most recent valid frame
+   *
+   * \return Pointer to the kFrameSize bytes of the frame
+   */
+  const uint8_t* getFrame() const;
+
+  /**
+   * Parse a 24-bit MSB/big-endian uint
+   *
+   * \param first_byte Pointer to first byte of 24-bit uint
+   * \return Parsed uint stored in a native 32-bit uint
+   */
+  static uint32_t parse24bit(const uint8_t* first_byte);
+
+  /**
+   * Parse a 16-bit MSB/big-endian uint
+   *
+   * \param first_byte Pointer to first byte of 16-bit uint
+   * \return Parsed uint stored in a native 32-bit uint
+   */
+  static uint32_t parse16bit(const uint8_t* first_byte);
+
+  /// Size of a frame incl. the header and checksum bytes
+  static constexpr size_t kFrameSize = 24;
+  /// Bitmask for header 1 byte if errors occured
+  static constexpr uint8_t header_error_mask = 0xF0;
+
+ private:
+  /**
+   * Add a received byte to the frame being assembled
+   *
+   * \param byte The received byte
+   * \return True if the byte completed a valid frame
+   */
+  bool parseByte(const uint8_t byte);
+
+  /**
+   * Continue at the next header in a frame with an invalid checksum
+   */
+  void resyncFrame();
+
+  /**
+   * Whether the byte can be the first header byte of a frame
+   *
+   * \param byte The received byte
+   * \return True for normal (0x55), uncalibrated (0xAA) or error (0xFx) frames
+   */
+  static bool isHeader(const uint8_t byte);
+
+  /// Buffer for the data frame being assembled
+  uint8_t in_data_[kFrameSize];
+  /// Index of the data frame buffer
+  uint8_t in_data_i_ = 0;
+  /// The most recent valid data frame
+  uint8_t frame_[kFrameSize] = {};
+  /// Whether a valid frame was received
+  bool has_frame_ = false;
+
+  /// Byte offset (position) in frame for frame checksum
+  static constexpr uint8_t checksum_offset = 23;
+  /// Second header byte of all frames
+  static constexpr uint8_t header_2_value = 0x5A;
+};
+
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -1,6 +1,10 @@
 #include "digital_in.h"
 
+#include <esp_timer.h>
+#include <hal/gpio_ll.h>
+
 #include "peripheral/peripheral_factory.h"
+#include "utils/error_store.h"
 
 namespace inamata {
 namespace peripheral {
@@ -50,6 +54,41 @@ DigitalIn::DigitalIn(const JsonObjectConst& parameters) {
   if (active_low.as<bool>()) {
     active_low_ = true;
   }
+
+  // Capture edges with an interrupt if any of its statistics are requested
+  edge_count_data_point_type_ =
+      utils::UUID(parameters[edge_count_data_point_type_key_]);
+  on_duration_data_point_type_ =
+      utils::UUID(parameters[on_duration_data_point_type_key_]);
+  last_change_data_point_type_ =
+      utils::UUID(parameters[last_change_data_point_type_key_]);
+  if (!edge_count_data_point_type_.isValid() &&
+      !on_duration_data_point_type_.isValid() &&
+      !last_change_data_point_type_.isValid()) {
+    return;
+  }
+
+  uint32_t debounce_us = 0;
+  JsonVariantConst debounce_us_json = parameters[debounce_us_key_];
+  if (!debounce_us_json.isNull()) {
+    if (!debounce_us_json.is<uint32_t>()) {
+      setInvalid(ErrorStore::genMissingProperty(
+          debounce_us_key_, ErrorStore::KeyType::kUint32t, true));
+      return;
+    }
+    debounce_us = debounce_us_json.as<uint32_t>();
+  }
+
+  edge_capture_.begin(digitalRead(pin_), active_low_, debounce_us,
+                      esp_timer_get_time());
+  attachInterruptArg(pin_, handleEdge, this, CHANGE);
+  is_capturing_ = true;
+}
+
+DigitalIn::~DigitalIn() {
+  if (is_capturing_) {
+    detachInterrupt(pin_);
+  }
 }
 
 const String& DigitalIn::getType() const { return type(); }
@@ -64,8 +103,31 @@ capabilities::GetValues::Result DigitalIn::getValues() {
   if (active_low_) {
     value = !value;
   }
-  return {.values = {
-              utils::ValueUnit(static_cast<float>(value), data_point_type_)}};
+  capabilities::GetValues::Result result = {
+      .values = {
+          utils::ValueUnit(static_cast<float>(value), data_point_type_)}};
+  if (!is_capturing_) {
+    return result;
+  }
+
+  const int64_t now_us = esp_timer_get_time();
+  edge_capture_.update(now_us);
+  const utils::EdgeCapture::Interval interval =
+      edge_capture_.takeInterval(now_us);
+  if (edge_count_data_point_type_.isValid()) {
+    result.values.push_back(
+        utils::ValueUnit(interval.activations, edge_count_data_point_type_));
+  }
+  if (on_duration_data_point_type_.isValid()) {
+    result.values.push_back(utils::ValueUnit(interval.on_duration_us / 1e6f,
+                                             on_duration_data_point_type_));
+  }
+  const int64_t last_change_us = edge_capture_.getLastChange();
+  if (last_change_data_point_type_.isValid() && last_change_us >= 0) {
+    result.values.push_back(utils::ValueUnit(
+        (now_us - last_change_us) / 1e6f, last_change_data_point_type_));
+  }
+  return result;
 }
 
 bool DigitalIn::readState() {
@@ -78,6 +140,13 @@ bool DigitalIn::readState() {
 
 bool DigitalIn::readCurrentState() { return readState(); }
 
+void IRAM_ATTR DigitalIn::handleEdge(void* arg) {
+  DigitalIn* digital_in = static_cast<DigitalIn*>(arg);
+  digital_in->edge_capture_.onChange(
+      esp_timer_get_time(),
+      gpio_ll_get_level(&GPIO, gpio_num_t(digital_in->pin_)));
+}
+
 std::shared_ptr<Peripheral> DigitalIn::factory(
     const ServiceGetters& services, const JsonObjectConst& parameters) {
   return std::make_shared<DigitalIn>(parameters);
@@ -92,6 +161,13 @@ bool DigitalIn::capability_get_values_ =
 const __FlashStringHelper* DigitalIn::input_type_key_ = FPSTR("input_type");
 const __FlashStringHelper* DigitalIn::input_type_key_error_ =
     FPSTR("Missing property: input_type (str)");
+const __FlashStringHelper* DigitalIn::debounce_us_key_ = FPSTR("debounce_us");
+const __FlashStringHelper* DigitalIn::edge_count_data_point_type_key_ =
+    FPSTR("edge_count_data_point_type");
+const __FlashStringHelper* DigitalIn::on_duration_data_point_type_key_ =
+    FPSTR("on_duration_data_point_type");
+const __FlashStringHelper* DigitalIn::last_change_data_point_type_key_ =
+    FPSTR("last_change_data_point_type");
 
 }  // namespace digital_in
 }  // namespace peripherals
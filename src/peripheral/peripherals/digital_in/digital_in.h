@@ -6,6 +6,7 @@
 #include "managers/service_getters.h"
 #include "peripheral/capabilities/get_values.h"
 #include "peripheral/peripheral.h"
+#include "utils/edge_capture.h"
 
 namespace inamata {
 namespace peripheral {
@@ -13,14 +14,18 @@ namespace peripherals {
 namespace digital_in {
 
 /**
- * Peripheral to control a GPIO output
+ * Peripheral to read a GPIO input
+ *
+ * Optionally captures edges with an interrupt to report pulses that are
+ * shorter than the poll period. The ISR timestamps the pin changes and
+ * EdgeCapture debounces them.
  */
 class DigitalIn : public Peripheral,
                   public capabilities::GetValues,
                   public Debouncer {
  public:
   DigitalIn(const JsonObjectConst& parameters);
-  virtual ~DigitalIn() = default;
+  virtual ~DigitalIn();
 
   // Type registration in the peripheral factory
   const String& getType() const final;
@@ -29,6 +34,9 @@ class DigitalIn : public Peripheral,
   /**
    * Get the GPIO state
    *
+   * With edge capture, also returns the activations, the active time in
+   * seconds since the last call and the seconds since the last change.
+   *
    * \return The value 1 represents the high state, 0 its low state
    */
   capabilities::GetValues::Result getValues() final;
@@ -41,6 +49,13 @@ class DigitalIn : public Peripheral,
    */
   bool readCurrentState();
 
+  /**
+   * Timestamp a pin change and pass it to the edge capture
+   *
+   * \param arg The DigitalIn attached to the pin
+   */
+  static void IRAM_ATTR handleEdge(void* arg);
+
   static std::shared_ptr<Peripheral> factory(const ServiceGetters& services,
                                              const JsonObjectConst& parameter);
   static bool registered_;
@@ -55,9 +70,21 @@ class DigitalIn : public Peripheral,
   /// Data point type for the GPIO output pin state
   utils::UUID data_point_type_{nullptr};
 
+  /// Data point types of the edge capture statistics
+  utils::UUID edge_count_data_point_type_{nullptr};
+  utils::UUID on_duration_data_point_type_{nullptr};
+  utils::UUID last_change_data_point_type_{nullptr};
+  /// Whether the ISR is attached to the pin
+  bool is_capturing_ = false;
+  utils::EdgeCapture edge_capture_;
+
   /// How to setup the input GPIO
   static const __FlashStringHelper* input_type_key_;
   static const __FlashStringHelper* input_type_key_error_;
+  static const __FlashStringHelper* debounce_us_key_;
+  static const __FlashStringHelper* edge_count_data_point_type_key_;
+  static const __FlashStringHelper* on_duration_data_point_type_key_;
+  static const __FlashStringHelper* last_change_data_point_type_key_;
 };
 
 }  // namespace digital_in
@@ -0,0 +1,69 @@
+#include "energy_counter.h"
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+
+EnergyCounter::EnergyCounter(std::shared_ptr<Storage> storage)
+    : storage_(storage) {}
+
+EnergyCounter::~EnergyCounter() {
+  // Keep the energy counted since the last save when the peripheral is
+  // replaced or removed
+  if (is_dirty_) {
+    save();
+  }
+}
+
+void EnergyCounter::add(const utils::UUID& peripheral_id, double energy_mj) {
+  if (!is_loaded_) {
+    load(peripheral_id);
+  }
+  if (!energy_.add(energy_mj)) {
+    return;
+  }
+  is_dirty_ = true;
+
+  if (std::chrono::steady_clock::now() - saved_at_ >= kSaveInterval) {
+    save();
+  }
+}
+
+bool EnergyCounter::isLoaded() const { return is_loaded_; }
+
+double EnergyCounter::getKwh() const { return energy_.getKwh(); }
+
+void EnergyCounter::load(const utils::UUID& peripheral_id) {
+  is_loaded_ = true;
+  peripheral_id_ = peripheral_id.toString();
+  saved_at_ = std::chrono::steady_clock::now();
+  if (!storage_) {
+    return;
+  }
+
+  JsonDocument counters;
+  ErrorResult error = storage_->loadEnergyCounters(counters);
+  if (error.isError()) {
+    TRACELN(error.toString());
+    return;
+  }
+  energy_.setMj(counters[peripheral_id_].as<uint64_t>());
+}
+
+void EnergyCounter::save() {
+  saved_at_ = std::chrono::steady_clock::now();
+  if (!storage_) {
+    return;
+  }
+  ErrorResult error =
+      storage_->storeEnergyCounter(peripheral_id_, energy_.getMj());
+  if (error.isError()) {
+    TRACELN(error.toString());
+    return;
+  }
+  is_dirty_ = false;
+}
+
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <memory>
+
+#include "managers/storage.h"
+#include "peripheral/peripherals/energy_integration.h"
+#include "utils/uuid.h"
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+
+/**
+ * Accumulates the active energy of a power meter and persists it
+ *
+ * The energy is counted in an EnergyAccumulator. It is loaded on the first
+ * use and saved at most every kSaveInterval to limit flash writes, so up to
+ * that much energy is lost on a power cut.
+ */
+class EnergyCounter {
+ public:
+  /**
+   * \param storage Persists the counter. Counts without persisting if null
+   */
+  EnergyCounter(std::shared_ptr<Storage> storage);
+  ~EnergyCounter();
+
+  /**
+   * Add energy to the counter and save it if the save interval passed
+   *
+   * \param peripheral_id The ID of the power meter to load and save under
+   * \param energy_mj The energy in millijoules. Fractions are carried over
+   */
+  void add(const utils::UUID& peripheral_id, double energy_mj);
+
+  /**
+   * Whether the counter was loaded and can be reported
+   *
+   * \return True after the first call to add()
+   */
+  bool isLoaded() const;
+
+  /**
+   * Get the accumulated energy
+   *
+   * \return The energy in kWh
+   */
+  double getKwh() const;
+
+  /// Min time between saving the counter to flash
+  static constexpr std::chrono::minutes kSaveInterval{15};
+
+ private:
+  void load(const utils::UUID& peripheral_id);
+  void save();
+
+  std::shared_ptr<Storage> storage_;
+  /// ID the counter is stored under, set on loading
+  String peripheral_id_;
+  bool is_loaded_ = false;
+  bool is_dirty_ = false;
+
+  EnergyAccumulator energy_;
+  std::chrono::steady_clock::time_point saved_at_;
+};
+
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,55 @@
+#include "energy_integration.h"
+
+#include <cmath>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+
+bool EnergyAccumulator::add(double energy_mj) {
+  // Ignore negative power from swapped CTs or parse errors
+  if (!(energy_mj > 0)) {
+    return false;
+  }
+  remainder_mj_ += energy_mj;
+  const double whole_mj = std::floor(remainder_mj_);
+  energy_mj_ += uint64_t(whole_mj);
+  remainder_mj_ -= whole_mj;
+  return true;
+}
+
+double EnergyAccumulator::getKwh() const {
+  // 1 kWh = 3600 kJ
+  return (energy_mj_ + remainder_mj_) / 3.6e9;
+}
+
+uint64_t EnergyAccumulator::getMj() const { return energy_mj_; }
+
+void EnergyAccumulator::setMj(uint64_t energy_mj) { energy_mj_ = energy_mj; }
+
+double PulseEnergy::update(uint16_t pf, uint32_t power_coef) {
+  // The 16-bit count wraps, so the unsigned difference stays correct
+  const uint16_t pulses = has_pf_ ? uint16_t(pf - last_pf_) : 0;
+  last_pf_ = pf;
+  has_pf_ = true;
+  return pulses * double(power_coef) / 1000;
+}
+
+double TrapezoidEnergy::update(float power,
+                               std::chrono::steady_clock::time_point now) {
+  // W * ms = mJ
+  double energy_mj = 0;
+  if (last_power_at_ != std::chrono::steady_clock::time_point::min()) {
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                              last_power_at_);
+    energy_mj = (last_power_ + power) / 2 * elapsed.count();
+  }
+  last_power_ = power;
+  last_power_at_ = now;
+  return energy_mj;
+}
+
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+
+/**
+ * Counts energy in whole millijoules and carries the fractions over
+ *
+ * The 64-bit counter lasts for millions of years at 10kW.
+ */
+class EnergyAccumulator {
+ public:
+  /**
+   * Add energy to the counter
+   *
+   * \param energy_mj The energy in millijoules. Ignored if not positive
+   * \return True if energy was added
+   */
+  bool add(double energy_mj);
+
+  /**
+   * Get the accumulated energy
+   *
+   * \return The energy in kWh
+   */
+  double getKwh() const;
+
+  /// The whole millijoules counted
+  uint64_t getMj() const;
+
+  /// Set the whole millijoules counted, such as when loading the counter
+  void setMj(uint64_t energy_mj);
+
+ private:
+  uint64_t energy_mj_ = 0;
+  /// Energy below 1 mJ not yet added to the counter
+  double remainder_mj_ = 0;
+};
+
+/**
+ * Energy from the PF pulse count of CSE7766 frames
+ *
+ * Each pulse is power_coef / 1e6 / 3600 Wh, which is power_coef / 1000 mJ.
+ */
+class PulseEnergy {
+ public:
+  /**
+   * Get the energy of the pulses since the previous frame
+   *
+   * \param pf The 16-bit PF pulse count of the frame. Wraps around
+   * \param power_coef The power coefficient of the frame
+   * \return The energy in millijoules. Zero for the first frame
+   */
+  double update(uint16_t pf, uint32_t power_coef);
+
+ private:
+  /// PF pulse count of the previous frame
+  uint16_t last_pf_ = 0;
+  /// Whether a previous PF pulse count was parsed
+  bool has_pf_ = false;
+};
+
+/**
+ * Energy from the power of CSE6677 frames with the trapezoidal rule
+ */
+class TrapezoidEnergy {
+ public:
+  /**
+   * Get the energy since the previous frame
+   *
+   * \param power The power of the frame in watts
+   * \param now When the frame was parsed
+   * \return The energy in millijoules. Zero for the first frame
+   */
+  double update(float power, std::chrono::steady_clock::time_point now);
+
+ private:
+  /// Power of the previous frame in watts
+  float last_power_ = 0;
+  /// When the previous frame was parsed
+  std::chrono::steady_clock::time_point last_power_at_ =
+      std::chrono::steady_clock::time_point::min();
+};
+
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -1,6 +1,11 @@
 #include "modbus_client_adapter.h"
 
+#include <algorithm>
+
+#include "managers/services.h"
 #include "peripheral/peripheral_factory.h"
+#include "peripheral/peripherals/modbus/read_block_planner.h"
+#include "peripheral/peripherals/modbus/write_block_planner.h"
 #include "utils/error_store.h"
 
 namespace inamata {
@@ -37,6 +42,18 @@ ModbusClientAdapter::ModbusClientAdapter(const JsonObjectConst& parameters) {
     return;
   }
 
+  // Optional max gap between reads to merge them
+  JsonVariantConst max_read_gap_json = parameters[max_read_gap_key_];
+  if (!max_read_gap_json.isNull()) {
+    if (!max_read_gap_json.is<float>() ||
+        max_read_gap_json.as<int>() >= kMaxReadRegisters) {
+      setInvalid(ErrorStore::genMissingProperty(max_read_gap_key_,
+                                                ErrorStore::KeyType::kFloat));
+      return;
+    }
+    max_read_gap_ = max_read_gap_json.as<uint16_t>();
+  }
+
   // Initialize serial and Modbus interface
   RTUutils::prepareHardwareSerial(Serial1);
   Serial1.begin(baud_rate_json.as<unsigned long>(), SERIAL_8N1, rx_pin, tx_pin);
@@ -44,6 +61,10 @@ ModbusClientAdapter::ModbusClientAdapter(const JsonObjectConst& parameters) {
   driver_->onResponseHandler(
       std::bind(&ModbusClientAdapter::modbusResponseHandler, this, _1, _2));
   driver_->begin(Serial1);
+
+  flush_task_ = std::unique_ptr<PeripheralTask>(new PeripheralTask(
+      Services::getScheduler(),
+      std::bind(&ModbusClientAdapter::sendPendingRequests, this)));
 }
 
 const String& ModbusClientAdapter::getType() const { return type(); }
@@ -56,76 +77,338 @@ const String& ModbusClientAdapter::type() {
 Modbus::Error ModbusClientAdapter::addReadRequest(
     const uint8_t server_id, const uint16_t read_address,
     const uint16_t read_size,
-    std::function<void(ModbusMessage& response)> response_callback,
-    uint32_t* const request_token) {
-  Modbus::Error error = preRequest();
-  if (error != Modbus::Error::SUCCESS) {
-    return error;
+    std::function<void(ModbusMessage& response)> response_callback) {
+  if (read_size == 0 || read_size > kMaxReadRegisters) {
+    return Modbus::Error::PARAMETER_LIMIT_ERROR;
+  }
+  // Limit the memory used if the reads are not being sent
+  if (pending_reads_.size() >= kMaxPendingReads) {
+    sendPendingRequests();
+  }
+
+  pending_reads_.push_back(
+      {server_id, read_address, read_size, response_callback});
+  return Modbus::Error::SUCCESS;
+}
+
+void ModbusClientAdapter::addPendingWrite(
+    const uint8_t server_id, const bool write_registers,
+    const uint16_t write_address, const uint16_t value,
+    std::function<void(ModbusMessage& response)> response_callback) {
+  // Limit the memory used if the writes are not being sent
+  if (pending_write_count_ >= kMaxPendingWrites) {
+    sendPendingRequests();
   }
 
-  error = driver_->addRequest(++request_token_, server_id, READ_HOLD_REGISTER,
-                              read_address, read_size);
+  auto& writes = pending_writes_[{server_id, write_registers}];
+  if (writes.find(write_address) == writes.end()) {
+    pending_write_count_++;
+  }
+  writes[write_address] = {value, response_callback};
 
-  postRequest(error, response_callback, request_token);
-  return error;
+  // Send once the other tasks of this pass could add their writes
+  flush_task_->setIterations(1);
+  flush_task_->enableIfNot();
+}
+
+void ModbusClientAdapter::sendPendingRequests() {
+  sendPendingReads();
+  sendPendingWrites();
+}
+
+void ModbusClientAdapter::sendPendingReads() {
+  if (pending_reads_.empty()) {
+    return;
+  }
+  std::vector<PendingRead> reads;
+  reads.swap(pending_reads_);
+
+  std::vector<ReadRange> ranges;
+  ranges.reserve(reads.size());
+  for (const PendingRead& read : reads) {
+    ranges.push_back({read.server_id, read.address, read.size});
+  }
+  for (const std::vector<size_t>& indices :
+       planReadBlocks(ranges, max_read_gap_, kMaxReadRegisters)) {
+    std::vector<PendingRead> block;
+    block.reserve(indices.size());
+    for (const size_t index : indices) {
+      block.push_back(std::move(reads[index]));
+    }
+    sendReadBlock(std::move(block));
+  }
 }
 
 Modbus::Error ModbusClientAdapter::addWriteRequest(
     const uint8_t server_id, const uint16_t write_address, const uint16_t value,
     std::function<void(ModbusMessage& response)> response_callback,
     uint32_t* const request_token) {
-  Modbus::Error error = preRequest();
+  return sendRequest(server_id, WRITE_COIL, write_address, value,
+                     response_callback, request_token);
+}
+
+Modbus::Error ModbusClientAdapter::addWriteMultipleRequest(
+    const uint8_t server_id, const uint8_t function_code,
+    const uint16_t write_address, std::vector<uint16_t> values,
+    std::function<void(ModbusMessage& response)> response_callback,
+    uint32_t* const request_token) {
+  uint16_t max_values;
+  if (function_code == WRITE_MULT_COILS) {
+    max_values = kMaxWriteCoils;
+  } else if (function_code == WRITE_MULT_REGISTERS) {
+    max_values = kMaxWriteRegisters;
+  } else {
+    return Modbus::Error::ILLEGAL_FUNCTION;
+  }
+  if (values.empty() || values.size() > max_values) {
+    return Modbus::Error::PARAMETER_LIMIT_ERROR;
+  }
+  const uint16_t count = values.size();
+  return sendRequest(server_id, function_code, write_address, count,
+                     response_callback, request_token, std::move(values));
+}
+
+const ModbusClientAdapter::Stats& ModbusClientAdapter::getStats() {
+  return stats_;
+}
+
+void ModbusClientAdapter::sendReadBlock(std::vector<PendingRead> reads) {
+  const uint8_t server_id = reads.front().server_id;
+  const uint16_t block_address = reads.front().address;
+  uint32_t block_end = 0;
+  for (const PendingRead& read : reads) {
+    block_end = std::max(block_end, uint32_t(read.address) + read.size);
+  }
+
+  std::function<void(ModbusMessage & response)> callback;
+  if (reads.size() == 1) {
+    callback = reads.front().callback;
+  } else {
+    callback = [reads, block_address](ModbusMessage& response) {
+      for (const PendingRead& read : reads) {
+        ModbusMessage slice = sliceResponse(response, block_address, read);
+        if (read.callback) {
+          read.callback(slice);
+        }
+      }
+    };
+  }
+
+  Modbus::Error error =
+      sendRequest(server_id, READ_HOLD_REGISTER, block_address,
+                  uint16_t(block_end - block_address), callback, nullptr);
   if (error != Modbus::Error::SUCCESS) {
-    return error;
+    // Notify the reads as they already returned a success when queued
+    ModbusMessage response;
+    response.setError(server_id, READ_HOLD_REGISTER, error);
+    for (const PendingRead& read : reads) {
+      if (read.callback) {
+        read.callback(response);
+      }
+    }
+  }
+}
+
+void ModbusClientAdapter::sendPendingWrites() {
+  if (pending_writes_.empty()) {
+    return;
+  }
+  decltype(pending_writes_) writes;
+  writes.swap(pending_writes_);
+  pending_write_count_ = 0;
+
+  for (auto& server_writes : writes) {
+    const uint8_t server_id = server_writes.first.first;
+    const bool write_registers = server_writes.first.second;
+    const uint16_t max_values =
+        write_registers ? kMaxWriteRegisters : kMaxWriteCoils;
+
+    // The writes are sorted by address
+    std::vector<uint16_t> addresses;
+    addresses.reserve(server_writes.second.size());
+    for (const auto& write : server_writes.second) {
+      addresses.push_back(write.first);
+    }
+    auto it = server_writes.second.begin();
+    for (const WriteBlock& write_block :
+         planWriteBlocks(addresses, max_values)) {
+      std::vector<PendingWrite> block;
+      block.reserve(write_block.size);
+      for (uint16_t i = 0; i < write_block.size; i++, ++it) {
+        block.push_back(std::move(it->second));
+      }
+      sendWriteBlock(server_id, write_registers, write_block.address,
+                     std::move(block));
+    }
   }
+}
 
-  Modbus::Error err = driver_->addRequest(++request_token_, server_id,
-                                          WRITE_COIL, write_address, value);
+void ModbusClientAdapter::sendWriteBlock(const uint8_t server_id,
+                                         const bool write_registers,
+                                         const uint16_t address,
+                                         std::vector<PendingWrite> writes) {
+  std::function<void(ModbusMessage & response)> callback;
+  if (writes.size() == 1) {
+    callback = writes.front().callback;
+  } else {
+    callback = [writes](ModbusMessage& response) {
+      for (const PendingWrite& write : writes) {
+        if (write.callback) {
+          write.callback(response);
+        }
+      }
+    };
+  }
 
-  postRequest(error, response_callback, request_token);
-  return err;
+  uint8_t function_code;
+  Modbus::Error error;
+  if (writes.size() == 1 && !write_registers) {
+    // Write single coil expects 0xFF00 for on
+    function_code = WRITE_COIL;
+    error = addWriteRequest(server_id, address,
+                            writes.front().value ? 0xFF00 : 0x0000, callback,
+                            nullptr);
+  } else {
+    function_code = write_registers ? WRITE_MULT_REGISTERS : WRITE_MULT_COILS;
+    std::vector<uint16_t> values;
+    values.reserve(writes.size());
+    for (const PendingWrite& write : writes) {
+      values.push_back(write.value);
+    }
+    error = addWriteMultipleRequest(server_id, function_code, address,
+                                    std::move(values), callback, nullptr);
+  }
+  if (error != Modbus::Error::SUCCESS && callback) {
+    // Notify the writes as they were queued without an error
+    ModbusMessage response;
+    response.setError(server_id, function_code, error);
+    callback(response);
+  }
 }
 
-Modbus::Error ModbusClientAdapter::preRequest() {
-  // If callbacks aren't removed, remove oldest
-  if (callbacks_.size() > 10) {
-    const auto& callback = callbacks_.begin();
-    TRACEF("Callbacks overflow: %u\r\n", callback->first);
-    callbacks_.erase(callback);
+ModbusMessage ModbusClientAdapter::sliceResponse(
+    const ModbusMessage& response, const uint16_t block_address,
+    const PendingRead& read) {
+  // First value is on pos 3, after server ID, function code and length byte
+  const uint16_t header_offset = 3;
+  const uint16_t offset =
+      header_offset + (read.address - block_address) * sizeof(uint16_t);
+  const uint16_t byte_count = read.size * sizeof(uint16_t);
+  if (response.getError() != Modbus::Error::SUCCESS ||
+      offset + byte_count > response.size()) {
+    return response;
   }
-  return Modbus::Error::SUCCESS;
+
+  ModbusMessage slice;
+  slice.add(response.getServerID(), response.getFunctionCode(),
+            uint8_t(byte_count));
+  slice.add(response.data() + offset, byte_count);
+  return slice;
 }
 
-void ModbusClientAdapter::postRequest(
-    Modbus::Error error,
+Modbus::Error ModbusClientAdapter::sendRequest(
+    const uint8_t server_id, const uint8_t function_code,
+    const uint16_t address, const uint16_t parameter,
     std::function<void(ModbusMessage& response)> response_callback,
-    uint32_t* const request_token) {
-  // Save the current request token value to the output variable
+    uint32_t* const request_token, std::vector<uint16_t> values) {
+  uint32_t token;
+  Modbus::Error error;
+  {
+    std::lock_guard<std::mutex> lock(transactions_mutex_);
+    token = transactions_.open({.server_id = server_id,
+                                .function_code = function_code,
+                                .address = address,
+                                .parameter = parameter,
+                                .values = std::move(values),
+                                .callback = response_callback});
+    if (!token) {
+      TRACELN("Transactions full");
+      return Modbus::Error::REQUEST_QUEUE_FULL;
+    }
+    stats_.requests++;
+    // Queued by the driver, so the response is handled after the unlock
+    error = issueRequest(token, *transactions_.find(token));
+    if (error != Modbus::Error::SUCCESS) {
+      transactions_.close(token);
+    }
+  }
   if (request_token) {
-    *request_token = request_token_;
+    *request_token = token;
   }
-  // On success register the callback, else print the error
-  if (error == Modbus::SUCCESS && response_callback) {
-    callbacks_[request_token_] = response_callback;
-  } else {
+
+  if (error != Modbus::Error::SUCCESS) {
     ModbusError e(error);
     TRACEF("Error creating request: %02X - %s\r\n", (int)e, (const char*)e);
   }
+  return error;
+}
+
+Modbus::Error ModbusClientAdapter::issueRequest(const uint32_t token,
+                                                const Request& request) {
+  if (request.function_code == WRITE_MULT_REGISTERS) {
+    std::vector<uint16_t> words(request.values);
+    return driver_->addRequest(token, request.server_id, request.function_code,
+                               request.address, uint16_t(words.size()),
+                               uint8_t(words.size() * sizeof(uint16_t)),
+                               words.data());
+  }
+  if (request.function_code == WRITE_MULT_COILS) {
+    // Pack the coils LSB first, 8 per byte
+    std::vector<uint8_t> bytes((request.values.size() + 7) / 8, 0);
+    for (size_t i = 0; i < request.values.size(); i++) {
+      if (request.values[i]) {
+        bytes[i / 8] |= 1 << (i % 8);
+      }
+    }
+    return driver_->addRequest(token, request.server_id, request.function_code,
+                               request.address,
+                               uint16_t(request.values.size()),
+                               uint8_t(bytes.size()), bytes.data());
+  }
+  return driver_->addRequest(token, request.server_id, request.function_code,
+                             request.address, request.parameter);
 }
 
 void ModbusClientAdapter::modbusResponseHandler(ModbusMessage response,
                                                 uint32_t token) {
-  auto callback = callbacks_.find(token);
-  if (callback == callbacks_.end()) {
-    TRACEF("Callback not found: %d\r\n", token);
-    return;
+  const Modbus::Error error = response.getError();
+  Request finished;
+  {
+    std::lock_guard<std::mutex> lock(transactions_mutex_);
+    if (!transactions_.find(token)) {
+      TRACEF("Transaction not found: %u\r\n", token);
+      return;
+    }
+
+    if (error == Modbus::Error::TIMEOUT) {
+      stats_.timeouts++;
+    } else if (error == Modbus::Error::CRC_ERROR) {
+      stats_.crc_errors++;
+    }
+
+    // Resend on lost or corrupted frames
+    const bool is_retryable =
+        error == Modbus::Error::TIMEOUT || error == Modbus::Error::CRC_ERROR;
+    const uint32_t retry_token =
+        is_retryable ? transactions_.retry(token, kMaxRetries) : 0;
+    if (retry_token) {
+      stats_.retries++;
+      const Modbus::Error retry_error =
+          issueRequest(retry_token, *transactions_.find(retry_token));
+      if (retry_error == Modbus::Error::SUCCESS) {
+        return;
+      }
+      token = retry_token;
+    }
+
+    transactions_.close(token, &finished);
   }
-  if (callback->second) {
-    callback->second(response);
+
+  if (finished.callback) {
+    finished.callback(response);
   } else {
-    TRACEF("Null callback: %d\r\n", token);
+    TRACEF("Null callback: %u\r\n", token);
   }
-  callbacks_.erase(callback);
 }
 
 std::shared_ptr<Peripheral> ModbusClientAdapter::factory(
@@ -136,6 +419,11 @@ std::shared_ptr<Peripheral> ModbusClientAdapter::factory(
 bool ModbusClientAdapter::registered_ =
     PeripheralFactory::registerFactory(type(), factory);
 
+ModbusClientAdapter::Stats ModbusClientAdapter::stats_;
+
+const __FlashStringHelper* ModbusClientAdapter::max_read_gap_key_ =
+    FPSTR("max_read_gap");
+
 }  // namespace modbus
 }  // namespace peripherals
 }  // namespace peripheral
@@ -3,10 +3,16 @@
 #include <ArduinoJson.h>
 #include <ModbusClientRTU.h>
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include "managers/service_getters.h"
 #include "peripheral/peripheral.h"
+#include "peripheral/peripheral_task.h"
+#include "peripheral/peripherals/modbus/transaction_table.h"
 
 namespace inamata {
 namespace peripheral {
@@ -15,6 +21,14 @@ namespace modbus {
 
 class ModbusClientAdapter : public Peripheral {
  public:
+  /// Request and error counters of all adapters since boot
+  struct Stats {
+    uint32_t requests = 0;
+    uint32_t timeouts = 0;
+    uint32_t crc_errors = 0;
+    uint32_t retries = 0;
+  };
+
   ModbusClientAdapter(const JsonObjectConst& parameters);
   virtual ~ModbusClientAdapter() = default;
 
@@ -22,25 +36,195 @@ class ModbusClientAdapter : public Peripheral {
   const String& getType() const final;
   static const String& type();
 
+  /**
+   * Queue a read of holding registers
+   *
+   * The read is sent with the other queued requests by sendPendingRequests().
+   * The callback receives a response with only the requested registers.
+   *
+   * \param server_id The Modbus server to read from
+   * \param read_address The first register to read
+   * \param read_size The number of registers to read
+   * \param response_callback Called with the response or error
+   * \return An error if the read size is invalid
+   */
   Modbus::Error addReadRequest(
       const uint8_t server_id, const uint16_t read_address,
       const uint16_t read_size,
-      std::function<void(ModbusMessage& response)> response_callback,
-      uint32_t* const request_token);
+      std::function<void(ModbusMessage& response)> response_callback);
 
+  /**
+   * Queue a write of a coil or holding register
+   *
+   * The writes of all outputs are sent by a one-shot task once the calling
+   * tasks of the scheduler pass have run, or earlier by sendPendingRequests().
+   * Later writes to the same address replace earlier ones.
+   *
+   * \param server_id The Modbus server to write to
+   * \param write_registers Whether to write a holding register, else a coil
+   * \param write_address The coil or register to write
+   * \param value The value to write. Coils are on if not zero
+   * \param response_callback Called with the response or error
+   */
+  void addPendingWrite(
+      const uint8_t server_id, const bool write_registers,
+      const uint16_t write_address, const uint16_t value,
+      std::function<void(ModbusMessage& response)> response_callback);
+
+  /**
+   * Send the queued reads and writes
+   *
+   * Reads of the same server are merged into one request if at most
+   * max_read_gap_ unrequested registers lie between them and the block does
+   * not exceed kMaxReadRegisters. Writes of the same server and function code
+   * to consecutive addresses are combined into one write multiple coils (FC15)
+   * or registers (FC16) request.
+   */
+  void sendPendingRequests();
+
+  /**
+   * Send a write single coil request
+   *
+   * \param server_id The Modbus server to write to
+   * \param write_address The coil to write
+   * \param value The value to write
+   * \param response_callback Called with the response or error
+   * \param request_token Set to the token of the request
+   * \return An error if the request could not be queued
+   */
   Modbus::Error addWriteRequest(
       const uint8_t server_id, const uint16_t write_address,
       const uint16_t value,
       std::function<void(ModbusMessage& response)> response_callback,
       uint32_t* const request_token);
 
- private:
-  Modbus::Error preRequest();
-  void postRequest(
-      Modbus::Error error,
+  /**
+   * Send a write multiple coils (FC15) or registers (FC16) request
+   *
+   * \param server_id The Modbus server to write to
+   * \param function_code WRITE_MULT_COILS or WRITE_MULT_REGISTERS
+   * \param write_address The first coil or register to write
+   * \param values The values to write. Coils are on if not zero
+   * \param response_callback Called with the response or error
+   * \param request_token Set to the token of the request
+   * \return An error if the request could not be queued
+   */
+  Modbus::Error addWriteMultipleRequest(
+      const uint8_t server_id, const uint8_t function_code,
+      const uint16_t write_address, std::vector<uint16_t> values,
       std::function<void(ModbusMessage& response)> response_callback,
       uint32_t* const request_token);
 
+  /**
+   * Get the request and error counters of all adapters
+   *
+   * \return The counters since boot
+   */
+  static const Stats& getStats();
+
+  /// Max registers of a single read holding registers request
+  static constexpr uint16_t kMaxReadRegisters = 125;
+  /// Max coils of a single write multiple coils request
+  static constexpr uint16_t kMaxWriteCoils = 1968;
+  /// Max registers of a single write multiple registers request
+  static constexpr uint16_t kMaxWriteRegisters = 123;
+
+ private:
+  struct PendingRead {
+    uint8_t server_id;
+    uint16_t address;
+    uint16_t size;
+    std::function<void(ModbusMessage& response)> callback;
+  };
+
+  struct PendingWrite {
+    uint16_t value;
+    std::function<void(ModbusMessage& response)> callback;
+  };
+
+  /**
+   * Send the queued reads as merged register blocks
+   */
+  void sendPendingReads();
+
+  /**
+   * Send the queued writes, one request per run of consecutive addresses
+   */
+  void sendPendingWrites();
+
+  /**
+   * Send a combined write and pass the response to each write
+   *
+   * \param server_id The Modbus server to write to
+   * \param write_registers Whether to write holding registers, else coils
+   * \param address The first coil or register to write
+   * \param writes The writes to consecutive addresses
+   */
+  void sendWriteBlock(const uint8_t server_id, const bool write_registers,
+                      const uint16_t address, std::vector<PendingWrite> writes);
+
+  /**
+   * Send a merged read and split the response for each read
+   *
+   * \param reads The reads of one server sorted by address
+   */
+  void sendReadBlock(std::vector<PendingRead> reads);
+
+  /**
+   * Copy the registers of a read out of the merged response
+   *
+   * Errors and short responses are passed on as they are.
+   *
+   * \param response The response of the merged read
+   * \param block_address The first register of the merged read
+   * \param read The read to copy the registers for
+   * \return A response as if only the read was requested
+   */
+  static ModbusMessage sliceResponse(const ModbusMessage& response,
+                                     const uint16_t block_address,
+                                     const PendingRead& read);
+
+  /**
+   * An open request and how to repeat it
+   */
+  struct Request {
+    uint8_t server_id = 0;
+    uint8_t function_code = 0;
+    uint16_t address = 0;
+    /// The read size or the written value
+    uint16_t parameter = 0;
+    /// The written values of multiple coils or registers
+    std::vector<uint16_t> values;
+    std::function<void(ModbusMessage& response)> callback;
+  };
+
+  /**
+   * Store the request in a free transaction slot and send it
+   *
+   * \param server_id The Modbus server
+   * \param function_code The Modbus function code
+   * \param address The first register or coil
+   * \param parameter The read size or the written value
+   * \param response_callback Called with the response or error
+   * \param request_token Set to the token of the request
+   * \param values The values of write multiple requests
+   * \return An error if no slot was free or the driver rejected the request
+   */
+  Modbus::Error sendRequest(
+      const uint8_t server_id, const uint8_t function_code,
+      const uint16_t address, const uint16_t parameter,
+      std::function<void(ModbusMessage& response)> response_callback,
+      uint32_t* const request_token, std::vector<uint16_t> values = {});
+
+  /**
+   * Pass the request of a transaction to the driver
+   *
+   * \param token The token of the transaction
+   * \param request The request to send
+   * \return An error if the driver rejected the request
+   */
+  Modbus::Error issueRequest(const uint32_t token, const Request& request);
+
   void modbusResponseHandler(ModbusMessage response, uint32_t token);
 
   static std::shared_ptr<Peripheral> factory(const ServiceGetters& services,
@@ -50,9 +234,30 @@ class ModbusClientAdapter : public Peripheral {
   std::unique_ptr<ModbusClientRTU> driver_;
   std::vector<uint16_t> values_;
 
-  uint32_t request_token_ = 0;
+  /// The open requests. The driver responds from its own task. Every request
+  /// in the driver's queue holds a slot until the driver responds to it, with
+  /// a TIMEOUT error if the server did not answer. This also caps the queue
+  TransactionTable<Request, 16> transactions_;
+  std::mutex transactions_mutex_;
+  /// Resends after a timeout or CRC error
+  static constexpr uint8_t kMaxRetries = 1;
+  static Stats stats_;
+
+  /// Reads waiting to be merged and sent
+  std::vector<PendingRead> pending_reads_;
+  static constexpr size_t kMaxPendingReads = 16;
+  /// Writes waiting to be combined and sent, by server and register type and
+  /// then by address
+  std::map<std::pair<uint8_t, bool>, std::map<uint16_t, PendingWrite>>
+      pending_writes_;
+  size_t pending_write_count_ = 0;
+  static constexpr size_t kMaxPendingWrites = 32;
+  /// Sends the queued requests on its next run
+  std::unique_ptr<PeripheralTask> flush_task_;
+  /// Max unrequested registers between two reads to still merge them
+  uint16_t max_read_gap_ = 4;
 
-  std::map<uint32_t, std::function<void(ModbusMessage& response)>> callbacks_;
+  static const __FlashStringHelper* max_read_gap_key_;
 };
 
 }  // namespace modbus
@@ -40,6 +40,14 @@ ModbusClientInput::ModbusClientInput(const JsonObjectConst& parameters)
     return;
   }
   read_size_ = read_size_json.as<uint16_t>();
+  registers_ = RegisterCache(read_size_);
+
+  // Optional max age of cached registers. Zero reads on every measurement
+  std::chrono::milliseconds max_age{0};
+  JsonVariantConst max_age_json = parameters[max_age_key_];
+  if (max_age_json.is<float>()) {
+    max_age = std::chrono::milliseconds(max_age_json.as<uint32_t>());
+  }
 
   JsonArrayConst inputs_json = parameters[inputs_key_];
   if (inputs_json.size() == 0) {
@@ -72,6 +80,13 @@ ModbusClientInput::ModbusClientInput(const JsonObjectConst& parameters)
     if (b_json.is<float>()) {
       input.b = b_json.as<float>();
     }
+    JsonVariantConst input_max_age_json = input_json[max_age_key_];
+    if (input_max_age_json.is<float>()) {
+      input.max_age =
+          std::chrono::milliseconds(input_max_age_json.as<uint32_t>());
+    } else {
+      input.max_age = max_age;
+    }
   }
 }
 
@@ -90,12 +105,16 @@ capabilities::StartMeasurement::Result ModbusClientInput::startMeasurement(
   if (!ready_) {
     return {.wait = measurement_wait_};
   }
+  // Serve the measurement from the cache if no register is too old
+  if (response_error_ == Modbus::Error::SUCCESS &&
+      isCacheFresh(std::chrono::steady_clock::now())) {
+    return {};
+  }
 
   ready_ = false;
-  uint32_t request_token;
   Modbus::Error error = adapter_->addReadRequest(
       server_id_, read_address_, read_size_,
-      std::bind(&ModbusClientInput::handleResponse, this, _1), &request_token);
+      std::bind(&ModbusClientInput::handleResponse, this, _1));
 
   if (error != Modbus::SUCCESS) {
     ErrorResult result(type(), (const char*)ModbusError(error));
@@ -105,6 +124,8 @@ capabilities::StartMeasurement::Result ModbusClientInput::startMeasurement(
 }
 
 capabilities::StartMeasurement::Result ModbusClientInput::handleMeasurement() {
+  // Send the reads queued since the last call as merged requests
+  adapter_->sendPendingRequests();
   if (ready_) {
     return {};
   }
@@ -115,26 +136,21 @@ capabilities::GetValues::Result ModbusClientInput::getValues() {
   if (!ready_) {
     return {.values = {}, .error = ErrorResult(type(), "Not ready")};
   }
-  Modbus::Error error = response_.getError();
-  if (error != Modbus::Error::SUCCESS) {
+  if (response_error_ != Modbus::Error::SUCCESS) {
+    ModbusError modbus_error(response_error_);
     return {.values = {},
-            .error = ErrorResult(type(), (const char*)ModbusError(error))};
+            .error = ErrorResult(type(), (const char*)modbus_error)};
   }
 
-  // First value is on pos 3, after server ID, function code and length byte
-  const uint16_t header_offset = 3;
-
   // Reserve a ValueUnit for each input
   std::vector<utils::ValueUnit> values;
   values.reserve(inputs_.size());
 
   for (const auto& input : inputs_) {
     uint16_t raw_value;
-    const uint16_t offset = input.offset * sizeof(uint16_t) + header_offset;
-    if (offset + sizeof(uint16_t) > response_.size()) {
+    if (!registers_.get(input.offset, raw_value)) {
       return {.values = {}, .error = ErrorResult(type(), "Msg OOB")};
     }
-    response_.get(offset, raw_value);
     float value = raw_value * input.m + input.b;
     values.emplace_back(value, input.data_point_type);
   }
@@ -142,20 +158,44 @@ capabilities::GetValues::Result ModbusClientInput::getValues() {
   return {.values = values};
 }
 
+bool ModbusClientInput::isCacheFresh(
+    const std::chrono::steady_clock::time_point now) const {
+  for (const auto& input : inputs_) {
+    if (!registers_.isFresh(input.offset, input.max_age, now)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void ModbusClientInput::handleResponse(ModbusMessage& response) {
-  ready_ = true;
-  response_ = response;
   response_error_ = response.getError();
 
+  // First value is on pos 3, after server ID, function code and length byte
+  const uint16_t header_offset = 3;
+  if (response_error_ == Modbus::Error::SUCCESS &&
+      header_offset + read_size_ * sizeof(uint16_t) > response.size()) {
+    response_error_ = Modbus::Error::PACKET_LENGTH_ERROR;
+  }
+
   if (response_error_ != Modbus::Error::SUCCESS) {
 #ifdef ENABLE_TRACE
     ModbusError modbus_error(response_error_);
     TRACEF("Error: %02X - %s\r\n", (int)modbus_error,
            (const char*)modbus_error);
 #endif
-    // TODO: Return?
+    ready_ = true;
     return;
   }
+
+  const auto now = std::chrono::steady_clock::now();
+  for (uint16_t i = 0; i < read_size_; i++) {
+    uint16_t value;
+    response.get(header_offset + i * sizeof(uint16_t), value);
+    registers_.store(i, value, now);
+  }
+  // Set last as the response is handled in the Modbus client's task
+  ready_ = true;
 }
 
 std::shared_ptr<Peripheral> ModbusClientInput::factory(
@@ -169,6 +209,9 @@ bool ModbusClientInput::registered_ =
 bool ModbusClientInput::capability_get_values_ =
     capabilities::GetValues::registerType(type());
 
+const __FlashStringHelper* ModbusClientInput::max_age_key_ =
+    FPSTR("max_age_ms");
+
 }  // namespace modbus
 }  // namespace peripherals
 }  // namespace peripheral
@@ -2,17 +2,29 @@
 
 #include <ArduinoJson.h>
 
+#include <chrono>
+#include <vector>
+
 #include "managers/service_getters.h"
 #include "peripheral/capabilities/get_values.h"
 #include "peripheral/capabilities/start_measurement.h"
 #include "peripheral/peripheral.h"
 #include "peripheral/peripherals/modbus/modbus_client_abstract_peripheral.h"
+#include "peripheral/peripherals/modbus/register_cache.h"
 
 namespace inamata {
 namespace peripheral {
 namespace peripherals {
 namespace modbus {
 
+/**
+ * Reads holding registers and returns them as scaled values
+ *
+ * The registers of the last successful read are cached. A measurement started
+ * while every input's register is younger than its max age is served from the
+ * cache without a bus transaction. Measurements started while a read is in
+ * flight wait for and share that read.
+ */
 class ModbusClientInput : public ModbusClientAbstractPeripheral,
                           public capabilities::GetValues,
                           public capabilities::StartMeasurement {
@@ -42,6 +54,7 @@ class ModbusClientInput : public ModbusClientAbstractPeripheral,
    * offset: offset in bytes of the message payload (excl. 3 header bytes)
    * m: slope/gradient in the slope-intercept equation
    * b: intercept/y-axis offset in the slope-intercept equation
+   * max_age: how long a cached register can be returned. Zero to always read
    *
    * y = mx + b is applied to the extracted value
    *
@@ -52,8 +65,17 @@ class ModbusClientInput : public ModbusClientAbstractPeripheral,
     uint16_t offset = 0;
     float m = 1;
     float b = 0;
+    std::chrono::milliseconds max_age{0};
   };
 
+  /**
+   * Whether the registers of all inputs are younger than their max age
+   *
+   * \param now Time now of the steady clock
+   * \return True if the cached registers can be returned
+   */
+  bool isCacheFresh(const std::chrono::steady_clock::time_point now) const;
+
   void handleResponse(ModbusMessage& response);
 
   static std::shared_ptr<Peripheral> factory(const ServiceGetters& services,
@@ -68,10 +90,14 @@ class ModbusClientInput : public ModbusClientAbstractPeripheral,
   uint16_t read_address_;
   uint16_t read_size_;
 
-  ModbusMessage response_;
-  Modbus::Error response_error_;
+  /// Cached registers from read_address_ to read_address_ + read_size_
+  RegisterCache registers_;
+  Modbus::Error response_error_ = Modbus::Error::SUCCESS;
 
   std::chrono::milliseconds measurement_wait_{50};
+
+  /// Default max age of the inputs' registers in milliseconds
+  static const __FlashStringHelper* max_age_key_;
 };
 
 }  // namespace modbus
@@ -25,6 +25,11 @@ ModbusClientOutput::ModbusClientOutput(const JsonObjectConst& parameters)
   }
   server_id_ = server_id_json.as<uint8_t>();
 
+  JsonVariantConst registers_json = parameters[registers_key_];
+  if (registers_json.is<bool>()) {
+    write_registers_ = registers_json.as<bool>();
+  }
+
   JsonArrayConst outputs_json = parameters[outputs_key_];
   if (outputs_json.size() == 0) {
     setInvalid(ErrorStore::genMissingProperty(outputs_key_,
@@ -67,15 +72,13 @@ const String& ModbusClientOutput::type() {
 }
 
 void ModbusClientOutput::setValue(utils::ValueUnit value_unit) {
-  uint32_t request_token;
   bool added_request = false;
   for (const auto& output : outputs_) {
     if (output.data_point_type == value_unit.data_point_type) {
       added_request = true;
-      adapter_->addWriteRequest(
-          server_id_, output.address, value_unit.value,
-          std::bind(&ModbusClientOutput::handleResponse, this, _1),
-          &request_token);
+      adapter_->addPendingWrite(
+          server_id_, write_registers_, output.address, value_unit.value,
+          std::bind(&ModbusClientOutput::handleResponse, this, _1));
     }
   }
   if (!added_request) {
@@ -112,6 +115,9 @@ bool ModbusClientOutput::registered_ =
 bool ModbusClientOutput::capability_set_value_ =
     capabilities::SetValue::registerType(type());
 
+const __FlashStringHelper* ModbusClientOutput::registers_key_ =
+    FPSTR("registers");
+
 }  // namespace modbus
 }  // namespace peripherals
 }  // namespace peripheral
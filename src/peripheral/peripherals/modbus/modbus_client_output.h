@@ -12,6 +12,13 @@ namespace peripheral {
 namespace peripherals {
 namespace modbus {
 
+/**
+ * Writes values to coils or holding registers
+ *
+ * Written values are buffered by the adapter and sent with the writes of the
+ * other outputs of the same server. Writes to consecutive addresses are
+ * combined into one write multiple coils (FC15) or registers (FC16) request.
+ */
 class ModbusClientOutput : public ModbusClientAbstractPeripheral,
                            public capabilities::SetValue {
  public:
@@ -51,8 +58,12 @@ class ModbusClientOutput : public ModbusClientAbstractPeripheral,
 
   bool ready_;
   uint8_t server_id_;
+  /// Whether to write holding registers instead of coils
+  bool write_registers_ = false;
 
   Modbus::Error request_error_;
+
+  static const __FlashStringHelper* registers_key_;
 };
 
 }  // namespace modbus
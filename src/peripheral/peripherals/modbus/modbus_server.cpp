@@ -0,0 +1,356 @@
+#include "modbus_server.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "managers/services.h"
+#include "peripheral/capabilities/get_values.h"
+#include "peripheral/capabilities/set_value.h"
+#include "peripheral/capabilities/start_measurement.h"
+#include "peripheral/peripheral_factory.h"
+#include "utils/error_store.h"
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+using namespace std::placeholders;
+
+ModbusServer::ModbusServer(const JsonObjectConst& parameters)
+    : UARTAbstractPeripheral(parameters) {
+  // If the base class constructor failed, abort the constructor
+  if (!isValid()) {
+    return;
+  }
+
+  HardwareSerial* serial = uart_adapter_->getSerial();
+  if (!serial) {
+    setInvalid(ErrorStore::genNotAValid(uart_adapter_->id,
+                                        uart::UARTAdapter::type()));
+    return;
+  }
+
+  JsonVariantConst server_id_json = parameters[server_id_key_];
+  if (!server_id_json.is<float>() || server_id_json.as<int>() < 1 ||
+      server_id_json.as<int>() > 247) {
+    setInvalid(ErrorStore::genMissingProperty(server_id_key_,
+                                              ErrorStore::KeyType::kFloat));
+    return;
+  }
+  const uint8_t server_id = server_id_json.as<uint8_t>();
+
+  // Optional flow control (drive enable/receive enable) pin aka RTS
+  int dere_pin = -1;
+  JsonVariantConst dere_pin_json = parameters[dere_key_];
+  if (dere_pin_json.is<float>()) {
+    dere_pin = dere_pin_json.as<int>();
+  }
+
+  JsonVariantConst interval_ms_json = parameters[interval_ms_key_];
+  if (interval_ms_json.is<float>() && interval_ms_json.as<int>() > 0) {
+    refresh_interval_ =
+        std::chrono::milliseconds(interval_ms_json.as<uint32_t>());
+  }
+
+  JsonArrayConst registers_json = parameters[registers_key_];
+  if (registers_json.size() == 0) {
+    setInvalid(ErrorStore::genMissingProperty(registers_key_,
+                                              ErrorStore::KeyType::kArray));
+    return;
+  }
+  registers_.resize(registers_json.size());
+  for (size_t i = 0; i < registers_json.size(); i++) {
+    Register& reg = registers_[i];
+    JsonObjectConst register_json = registers_json[i];
+
+    reg.peripheral_id = utils::UUID(register_json[peripheral_key_]);
+    if (!reg.peripheral_id.isValid()) {
+      setInvalid(ErrorStore::genMissingProperty(peripheral_key_,
+                                                ErrorStore::KeyType::kUUID));
+      return;
+    }
+    reg.data_point_type = getDataPointType(register_json);
+    if (!reg.data_point_type.isValid()) {
+      setInvalid(utils::ValueUnit::data_point_type_key_error);
+      return;
+    }
+    JsonVariantConst address_json = register_json[address_key_];
+    if (!address_json.is<float>() || address_json.as<int>() < 0 ||
+        address_json.as<int>() >= kMaxRegisters) {
+      setInvalid(ErrorStore::genMissingProperty(address_key_,
+                                                ErrorStore::KeyType::kFloat));
+      return;
+    }
+    reg.address = address_json.as<uint16_t>();
+    JsonVariantConst m_json = register_json[m_key_];
+    if (m_json.is<float>()) {
+      reg.m = m_json.as<float>();
+    }
+    if (reg.m == 0) {
+      setInvalid(ErrorStore::genMissingProperty(m_key_,
+                                                ErrorStore::KeyType::kFloat));
+      return;
+    }
+    JsonVariantConst b_json = register_json[b_key_];
+    if (b_json.is<float>()) {
+      reg.b = b_json.as<float>();
+    }
+    reg.write = register_json[write_key_].as<bool>();
+
+    // Read each peripheral once per refresh for all its registers
+    bool is_source = false;
+    for (const Source& source : sources_) {
+      is_source |= source.peripheral_id == reg.peripheral_id;
+    }
+    if (!is_source) {
+      sources_.push_back({reg.peripheral_id});
+    }
+  }
+
+  image_.resize(kMaxRegisters, 0);
+
+  driver_ = std::unique_ptr<ModbusServerRTU>(
+      new ModbusServerRTU(kRequestTimeoutMs, dere_pin));
+  driver_->registerWorker(server_id, READ_HOLD_REGISTER,
+                          std::bind(&ModbusServer::handleRead, this, _1));
+  driver_->registerWorker(
+      server_id, WRITE_HOLD_REGISTER,
+      std::bind(&ModbusServer::handleWriteSingle, this, _1));
+  driver_->registerWorker(
+      server_id, WRITE_MULT_REGISTERS,
+      std::bind(&ModbusServer::handleWriteMultiple, this, _1));
+  // The UART adapter already sized the serial's buffers for RTU frames
+  driver_->begin(*serial);
+
+  refresh_task_ = std::unique_ptr<PeripheralTask>(
+      new PeripheralTask(Services::getScheduler(),
+                         std::bind(&ModbusServer::refreshRegisters, this)));
+  refresh_task_->setInterval(refresh_interval_.count());
+  refresh_task_->setIterations(TASK_FOREVER);
+  refresh_task_->enable();
+}
+
+const String& ModbusServer::getType() const { return type(); }
+
+const String& ModbusServer::type() {
+  static const String name{"ModbusServer"};
+  return name;
+}
+
+void ModbusServer::refreshRegisters() {
+  applyWrites();
+  for (Source& source : sources_) {
+    refreshSource(source);
+  }
+}
+
+void ModbusServer::refreshSource(Source& source) {
+  // Peripherals may be removed or added after the server
+  std::shared_ptr<Peripheral> peripheral =
+      Services::getPeripheralController().getPeripheral(source.peripheral_id);
+  auto get_values =
+      std::dynamic_pointer_cast<capabilities::GetValues>(peripheral);
+  if (!get_values) {
+    source.is_measuring = false;
+    return;
+  }
+
+  // Start a measurement and continue it on the next refreshes until ready
+  auto start_measurement =
+      std::dynamic_pointer_cast<capabilities::StartMeasurement>(peripheral);
+  if (start_measurement) {
+    if (!source.is_measuring) {
+      auto result = start_measurement->startMeasurement(JsonVariantConst());
+      if (result.error.isError()) {
+        TRACEF("Start fail: %s\r\n", result.error.toString().c_str());
+        return;
+      }
+      source.is_measuring = true;
+      if (result.wait.count() != 0) {
+        return;
+      }
+    }
+    auto result = start_measurement->handleMeasurement();
+    if (result.error.isError()) {
+      TRACEF("Handle fail: %s\r\n", result.error.toString().c_str());
+      source.is_measuring = false;
+      return;
+    }
+    if (result.wait.count() != 0) {
+      return;
+    }
+    source.is_measuring = false;
+  }
+
+  auto result = get_values->getValues();
+  if (result.error.isError()) {
+    TRACEF("Get values fail: %s\r\n", result.error.toString().c_str());
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const utils::ValueUnit& value_unit : result.values) {
+    for (const Register& reg : registers_) {
+      if (reg.peripheral_id != source.peripheral_id ||
+          reg.data_point_type != value_unit.data_point_type ||
+          std::isnan(value_unit.value)) {
+        continue;
+      }
+      float raw = std::round(value_unit.value * reg.m + reg.b);
+      raw = std::max(-32768.0f, std::min(raw, 65535.0f));
+      image_[reg.address] = uint16_t(int32_t(raw));
+    }
+  }
+}
+
+void ModbusServer::applyWrites() {
+  std::vector<Write> writes;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    writes.swap(writes_);
+  }
+
+  for (const Write& write : writes) {
+    for (const Register& reg : registers_) {
+      if (reg.address != write.address || !reg.write) {
+        continue;
+      }
+      auto set_value = std::dynamic_pointer_cast<capabilities::SetValue>(
+          Services::getPeripheralController().getPeripheral(
+              reg.peripheral_id));
+      if (!set_value) {
+        TRACEF("Not a SetValue: %s\r\n", reg.peripheral_id.toString().c_str());
+        continue;
+      }
+      set_value->setValue(
+          utils::ValueUnit((write.value - reg.b) / reg.m, reg.data_point_type));
+    }
+  }
+}
+
+ModbusMessage ModbusServer::handleRead(ModbusMessage request) {
+  ModbusMessage response;
+  uint16_t address;
+  uint16_t count;
+  request.get(2, address);
+  request.get(4, count);
+  if (count == 0 || count > 125) {
+    response.setError(request.getServerID(), request.getFunctionCode(),
+                      ILLEGAL_DATA_VALUE);
+    return response;
+  }
+  if (uint32_t(address) + count > image_.size()) {
+    response.setError(request.getServerID(), request.getFunctionCode(),
+                      ILLEGAL_DATA_ADDRESS);
+    return response;
+  }
+
+  response.add(request.getServerID(), request.getFunctionCode(),
+               uint8_t(count * sizeof(uint16_t)));
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (uint16_t i = 0; i < count; i++) {
+    response.add(image_[address + i]);
+  }
+  return response;
+}
+
+ModbusMessage ModbusServer::handleWriteSingle(ModbusMessage request) {
+  ModbusMessage response;
+  uint16_t address;
+  uint16_t value;
+  request.get(2, address);
+  request.get(4, value);
+  if (!isWritable(address, 1)) {
+    response.setError(request.getServerID(), request.getFunctionCode(),
+                      ILLEGAL_DATA_ADDRESS);
+    return response;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (writes_.size() >= kMaxWrites) {
+    response.setError(request.getServerID(), request.getFunctionCode(),
+                      SERVER_DEVICE_BUSY);
+    return response;
+  }
+  image_[address] = value;
+  writes_.push_back({address, value});
+  // The response to a write single register is the echoed request
+  return request;
+}
+
+ModbusMessage ModbusServer::handleWriteMultiple(ModbusMessage request) {
+  ModbusMessage response;
+  uint16_t address;
+  uint16_t count;
+  uint8_t byte_count;
+  request.get(2, address);
+  request.get(4, count);
+  request.get(6, byte_count);
+  // Values start at pos 7, after the server ID, FC, address, count and bytes
+  const uint16_t values_offset = 7;
+  if (count == 0 || count > 123 || byte_count != count * sizeof(uint16_t) ||
+      request.size() < values_offset + byte_count) {
+    response.setError(request.getServerID(), request.getFunctionCode(),
+                      ILLEGAL_DATA_VALUE);
+    return response;
+  }
+  if (!isWritable(address, count)) {
+    response.setError(request.getServerID(), request.getFunctionCode(),
+                      ILLEGAL_DATA_ADDRESS);
+    return response;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (writes_.size() + count > kMaxWrites) {
+    response.setError(request.getServerID(), request.getFunctionCode(),
+                      SERVER_DEVICE_BUSY);
+    return response;
+  }
+  for (uint16_t i = 0; i < count; i++) {
+    uint16_t value;
+    request.get(values_offset + i * sizeof(uint16_t), value);
+    image_[address + i] = value;
+    writes_.push_back({uint16_t(address + i), value});
+  }
+  response.add(request.getServerID(), request.getFunctionCode(), address,
+               count);
+  return response;
+}
+
+bool ModbusServer::isWritable(const uint16_t address,
+                              const uint16_t count) const {
+  for (uint32_t i = address; i < uint32_t(address) + count; i++) {
+    bool is_writable = false;
+    for (const Register& reg : registers_) {
+      is_writable |= reg.address == i && reg.write;
+    }
+    if (!is_writable) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<Peripheral> ModbusServer::factory(
+    const ServiceGetters& services, const JsonObjectConst& parameters) {
+  return std::make_shared<ModbusServer>(parameters);
+}
+
+bool ModbusServer::registered_ =
+    PeripheralFactory::registerFactory(type(), factory);
+
+const __FlashStringHelper* ModbusServer::server_id_key_ = FPSTR("server");
+const __FlashStringHelper* ModbusServer::registers_key_ = FPSTR("registers");
+const __FlashStringHelper* ModbusServer::peripheral_key_ = FPSTR("peripheral");
+const __FlashStringHelper* ModbusServer::address_key_ = FPSTR("address");
+const __FlashStringHelper* ModbusServer::m_key_ = FPSTR("m");
+const __FlashStringHelper* ModbusServer::b_key_ = FPSTR("b");
+const __FlashStringHelper* ModbusServer::write_key_ = FPSTR("write");
+const __FlashStringHelper* ModbusServer::interval_ms_key_ =
+    FPSTR("interval_ms");
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <ModbusServerRTU.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "peripheral/peripheral.h"
+#include "peripheral/peripheral_task.h"
+#include "peripheral/peripherals/uart/uart_abstract_peripheral.h"
+#include "utils/uuid.h"
+#include "utils/value_unit.h"
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+/**
+ * Modbus RTU server serving local readings to a PLC or SCADA system
+ *
+ * Maps the values of GetValues peripherals and the targets of SetValue
+ * peripherals to holding registers. Read requests (FC03) are answered from a
+ * cached register image by the eModbus server task, so they never wait on
+ * sensor I/O. An internal task refreshes the image every interval and applies
+ * written registers (FC06/FC16) to their SetValue peripherals.
+ *
+ * Peripherals with the StartMeasurement capability are measured over
+ * consecutive refreshes. Their registers therefore update every second
+ * interval or slower.
+ */
+class ModbusServer : public uart::UARTAbstractPeripheral {
+ public:
+  ModbusServer(const JsonObjectConst& parameters);
+  virtual ~ModbusServer() = default;
+
+  // Type registration in the peripheral factory
+  const String& getType() const final;
+  static const String& type();
+
+  /// Size of the register image, addresses 0 to kMaxRegisters - 1
+  static constexpr uint16_t kMaxRegisters = 128;
+
+ private:
+  /**
+   * peripheral: UUID of the peripheral to read or write
+   * data_point_type: UUID of the value's data point type
+   * address: the holding register
+   * m: slope/gradient in the slope-intercept equation
+   * b: intercept/y-axis offset in the slope-intercept equation
+   * write: whether a client may write the register to set the value
+   *
+   * register = m * value + b is rounded and values below zero are stored as
+   * two's complement. Written registers are read as unsigned and converted
+   * back with value = (register - b) / m before being set.
+   */
+  struct Register {
+    utils::UUID peripheral_id{nullptr};
+    utils::UUID data_point_type{nullptr};
+    uint16_t address = 0;
+    float m = 1;
+    float b = 0;
+    bool write = false;
+  };
+
+  /// A peripheral providing values for the registers
+  struct Source {
+    utils::UUID peripheral_id{nullptr};
+    /// Whether a measurement was started and is awaited
+    bool is_measuring = false;
+  };
+
+  /// A register written by a client, to be set on the main task
+  struct Write {
+    uint16_t address;
+    uint16_t value;
+  };
+
+  /**
+   * Read the values of the sources and store them in the register image
+   */
+  void refreshRegisters();
+
+  /**
+   * Read the values of a source if its measurement is ready
+   *
+   * \param source The source to read or measure
+   */
+  void refreshSource(Source& source);
+
+  /**
+   * Set the values of registers written by clients
+   */
+  void applyWrites();
+
+  /// Answer read holding registers requests from the register image
+  ModbusMessage handleRead(ModbusMessage request);
+  /// Store a written register and queue it to be set
+  ModbusMessage handleWriteSingle(ModbusMessage request);
+  /// Store written registers and queue them to be set
+  ModbusMessage handleWriteMultiple(ModbusMessage request);
+
+  /**
+   * Check that all registers in a range are mapped for writing
+   *
+   * \param address The first register
+   * \param count The number of registers
+   * \return True if all registers can be written
+   */
+  bool isWritable(const uint16_t address, const uint16_t count) const;
+
+  static std::shared_ptr<Peripheral> factory(const ServiceGetters& services,
+                                             const JsonObjectConst& parameters);
+  static bool registered_;
+
+  std::vector<Register> registers_;
+  std::vector<Source> sources_;
+
+  /// Register values served to clients. Guarded as eModbus runs in its task
+  std::vector<uint16_t> image_;
+  /// Registers written by clients and not yet set
+  std::vector<Write> writes_;
+  std::mutex mutex_;
+
+  std::unique_ptr<ModbusServerRTU> driver_;
+  /// Refreshes the register image and applies written registers
+  std::unique_ptr<PeripheralTask> refresh_task_;
+  std::chrono::milliseconds refresh_interval_{1000};
+
+  /// Time to receive a request frame
+  static constexpr uint32_t kRequestTimeoutMs = 2000;
+  /// Max written registers held until the refresh task sets them
+  static constexpr size_t kMaxWrites = 32;
+
+  static const __FlashStringHelper* server_id_key_;
+  static const __FlashStringHelper* registers_key_;
+  static const __FlashStringHelper* peripheral_key_;
+  static const __FlashStringHelper* address_key_;
+  static const __FlashStringHelper* m_key_;
+  static const __FlashStringHelper* b_key_;
+  static const __FlashStringHelper* write_key_;
+  static const __FlashStringHelper* interval_ms_key_;
+};
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,49 @@
+#include "read_block_planner.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+std::vector<std::vector<size_t>> planReadBlocks(
+    const std::vector<ReadRange>& reads, const uint16_t max_gap,
+    const uint16_t max_size) {
+  std::vector<size_t> order(reads.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&reads](size_t a, size_t b) {
+    return reads[a].server_id < reads[b].server_id ||
+           (reads[a].server_id == reads[b].server_id &&
+            reads[a].address < reads[b].address);
+  });
+
+  // Extend the block while the next read is close enough and fits into it
+  std::vector<std::vector<size_t>> blocks;
+  uint32_t block_end = 0;
+  for (const size_t index : order) {
+    const ReadRange& read = reads[index];
+    const uint32_t read_end = uint32_t(read.address) + read.size;
+    if (!blocks.empty()) {
+      const ReadRange& first = reads[blocks.back().front()];
+      const bool is_mergeable =
+          read.server_id == first.server_id &&
+          read.address <= block_end + max_gap &&
+          std::max(block_end, read_end) - first.address <= max_size;
+      if (is_mergeable) {
+        block_end = std::max(block_end, read_end);
+        blocks.back().push_back(index);
+        continue;
+      }
+    }
+    block_end = read_end;
+    blocks.push_back({index});
+  }
+  return blocks;
+}
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+/// A read of consecutive registers of a server
+struct ReadRange {
+  uint8_t server_id;
+  uint16_t address;
+  uint16_t size;
+};
+
+/**
+ * Group reads into blocks that can be read with one request each
+ *
+ * Reads of the same server are merged into one block if at most max_gap
+ * unrequested registers lie between them and the block does not exceed
+ * max_size registers. Overlapping reads are merged as well.
+ *
+ * \param reads The reads to group. Each read is at most max_size long
+ * \param max_gap Max unrequested registers between two merged reads
+ * \param max_size Max registers of a block
+ * \return The blocks as indices into reads, sorted by server and address
+ */
+std::vector<std::vector<size_t>> planReadBlocks(
+    const std::vector<ReadRange>& reads, const uint16_t max_gap,
+    const uint16_t max_size);
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,43 @@
+#include "register_cache.h"
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+RegisterCache::RegisterCache(uint16_t size) : registers_(size) {}
+
+void RegisterCache::store(uint16_t offset, uint16_t value,
+                          std::chrono::steady_clock::time_point now) {
+  if (offset >= registers_.size()) {
+    return;
+  }
+  registers_[offset] = {.value = value, .read_at = now};
+}
+
+bool RegisterCache::get(uint16_t offset, uint16_t& value) const {
+  if (offset >= registers_.size() ||
+      registers_[offset].read_at ==
+          std::chrono::steady_clock::time_point::min()) {
+    return false;
+  }
+  value = registers_[offset].value;
+  return true;
+}
+
+bool RegisterCache::isFresh(uint16_t offset,
+                            std::chrono::milliseconds max_age,
+                            std::chrono::steady_clock::time_point now) const {
+  uint16_t value;
+  if (!get(offset, value)) {
+    return false;
+  }
+  return registers_[offset].read_at + max_age > now;
+}
+
+uint16_t RegisterCache::size() const { return registers_.size(); }
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+/**
+ * The last successfully read values of a block of registers
+ *
+ * Each register keeps the time it was read, so readers with different
+ * cadences can decide whether it is recent enough for them.
+ */
+class RegisterCache {
+ public:
+  /**
+   * Create a cache without any read registers
+   *
+   * \param size The number of registers in the block
+   */
+  explicit RegisterCache(uint16_t size = 0);
+
+  /**
+   * Store the value of a successful read
+   *
+   * \param offset The register's offset in the block
+   * \param value The read value
+   * \param now When the value was read
+   */
+  void store(uint16_t offset, uint16_t value,
+             std::chrono::steady_clock::time_point now);
+
+  /**
+   * Get the value of a register
+   *
+   * \param offset The register's offset in the block
+   * \param value Set to the last read value
+   * \return False if the register is out of the block or was never read
+   */
+  bool get(uint16_t offset, uint16_t& value) const;
+
+  /**
+   * Whether a register was read less than max age ago
+   *
+   * \param offset The register's offset in the block
+   * \param max_age How long the value can be used. Zero is never fresh
+   * \param now Time now of the steady clock
+   * \return False if stale, never read or out of the block
+   */
+  bool isFresh(uint16_t offset, std::chrono::milliseconds max_age,
+               std::chrono::steady_clock::time_point now) const;
+
+  uint16_t size() const;
+
+ private:
+  struct Register {
+    uint16_t value = 0;
+    std::chrono::steady_clock::time_point read_at =
+        std::chrono::steady_clock::time_point::min();
+  };
+
+  std::vector<Register> registers_;
+};
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
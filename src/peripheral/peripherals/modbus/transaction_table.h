@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+/**
+ * Fixed number of open requests identified by the token sent with them
+ *
+ * Every request keeps its slot until it is closed, which caps the requests
+ * queued by the driver. Resent requests get a new token, so late responses
+ * to the earlier attempt are not matched anymore.
+ */
+template <typename Request, size_t kSize>
+class TransactionTable {
+ public:
+  /**
+   * Store a request in a free slot
+   *
+   * \param request The request and how to repeat it
+   * \return The token of the request, 0 if no slot is free
+   */
+  uint32_t open(Request request) {
+    for (Slot& slot : slots_) {
+      if (slot.token) {
+        continue;
+      }
+      slot.token = nextToken();
+      slot.retries = 0;
+      slot.request = std::move(request);
+      return slot.token;
+    }
+    return 0;
+  }
+
+  /**
+   * Get the request of an open transaction
+   *
+   * \param token The token of the request
+   * \return The request, nullptr if no transaction has the token
+   */
+  Request* find(uint32_t token) {
+    Slot* slot = findSlot(token);
+    return slot ? &slot->request : nullptr;
+  }
+
+  /**
+   * Give a request a new token to resend it
+   *
+   * \param token The token of the failed request
+   * \param max_retries Max resends per transaction
+   * \return The new token, 0 if no transaction has the token or it is out of
+   *         retries
+   */
+  uint32_t retry(uint32_t token, uint8_t max_retries) {
+    Slot* slot = findSlot(token);
+    if (!slot || slot->retries >= max_retries) {
+      return 0;
+    }
+    slot->retries++;
+    slot->token = nextToken();
+    return slot->token;
+  }
+
+  /**
+   * Close a transaction and free its slot
+   *
+   * \param token The token of the request
+   * \param request Set to the closed request if not null
+   * \return False if no transaction has the token
+   */
+  bool close(uint32_t token, Request* request = nullptr) {
+    Slot* slot = findSlot(token);
+    if (!slot) {
+      return false;
+    }
+    if (request) {
+      *request = std::move(slot->request);
+    }
+    *slot = Slot();
+    return true;
+  }
+
+  /// Number of open transactions
+  size_t size() const {
+    size_t count = 0;
+    for (const Slot& slot : slots_) {
+      count += slot.token != 0;
+    }
+    return count;
+  }
+
+ private:
+  struct Slot {
+    /// Token of the request sent to the driver. Zero if the slot is free
+    uint32_t token = 0;
+    uint8_t retries = 0;
+    Request request;
+  };
+
+  Slot* findSlot(uint32_t token) {
+    if (!token) {
+      return nullptr;
+    }
+    for (Slot& slot : slots_) {
+      if (slot.token == token) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Zero marks free slots and is skipped on wrap around
+  uint32_t nextToken() {
+    if (++last_token_ == 0) {
+      ++last_token_;
+    }
+    return last_token_;
+  }
+
+  std::array<Slot, kSize> slots_;
+  uint32_t last_token_ = 0;
+};
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
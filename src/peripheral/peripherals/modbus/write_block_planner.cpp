@@ -0,0 +1,28 @@
+#include "write_block_planner.h"
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+std::vector<WriteBlock> planWriteBlocks(const std::vector<uint16_t>& addresses,
+                                        const uint16_t max_size) {
+  std::vector<WriteBlock> blocks;
+  for (const uint16_t address : addresses) {
+    if (!blocks.empty()) {
+      WriteBlock& block = blocks.back();
+      if (block.size < max_size &&
+          uint32_t(block.address) + block.size == address) {
+        block.size++;
+        continue;
+      }
+    }
+    blocks.push_back({address, 1});
+  }
+  return blocks;
+}
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace modbus {
+
+/// Consecutive coils or registers written with one request
+struct WriteBlock {
+  uint16_t address;
+  uint16_t size;
+};
+
+/**
+ * Group the written addresses of a server into runs of consecutive addresses
+ *
+ * \param addresses The written coils or registers, sorted and unique
+ * \param max_size Max coils or registers of a block
+ * \return The blocks in the order of the addresses
+ */
+std::vector<WriteBlock> planWriteBlocks(const std::vector<uint16_t>& addresses,
+                                        const uint16_t max_size);
+
+}  // namespace modbus
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,32 @@
+#include "interrupt_flag.h"
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace pca9539 {
+
+void IRAM_ATTR InterruptFlag::onInterrupt(int64_t at_us) {
+  changed_at_us_.store(at_us, std::memory_order_relaxed);
+  is_changed_.store(true, std::memory_order_release);
+}
+
+bool InterruptFlag::shouldRead(int64_t now_us) {
+  // Clear before reading as the read releases the INT line
+  const bool is_changed =
+      is_changed_.exchange(false, std::memory_order_acquire);
+  if (!is_changed && last_read_us_ >= 0 &&
+      now_us - last_read_us_ <= kSafetyPollPeriodUs) {
+    return false;
+  }
+  last_read_us_ = now_us;
+  return true;
+}
+
+int64_t InterruptFlag::getChangedAt() const {
+  return changed_at_us_.load(std::memory_order_relaxed);
+}
+
+}  // namespace pca9539
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#else
+#define IRAM_ATTR
+#endif
+
+namespace inamata {
+namespace peripheral {
+namespace peripherals {
+namespace pca9539 {
+
+/**
+ * Decides when to read the inputs of an expander with an INT output
+ *
+ * The ISR flags a falling INT edge with onInterrupt. The inputs are then read
+ * once, which releases the INT line. Without an edge, the inputs are still read
+ * every kSafetyPollPeriodUs to recover from missed edges.
+ */
+class InterruptFlag {
+ public:
+  /// Read the inputs even without an INT edge to recover from missed edges
+  static constexpr int64_t kSafetyPollPeriodUs = 10 * 1000 * 1000;
+
+  /**
+   * Flags a change. Called by the ISR
+   *
+   * \param at_us esp_timer time of the falling INT edge
+   */
+  void IRAM_ATTR onInterrupt(int64_t at_us);
+
+  /**
+   * Whether the inputs have to be read
+   *
+   * Clears the change flag if so, as the following read releases the INT line.
+   *
+   * \param now_us Current esp_timer time
+   * \return True on the first call, after a change or if polling is due
+   */
+  bool shouldRead(int64_t now_us);
+
+  /**
+   * Time of the last falling INT edge
+   *
+   * \return esp_timer time of the edge, negative if none was flagged
+   */
+  int64_t getChangedAt() const;
+
+ private:
+  /// Set by the ISR, cleared before reading the inputs
+  std::atomic<bool> is_changed_{false};
+  /// Atomic as the 64-bit value is written by the ISR in two parts
+  std::atomic<int64_t> changed_at_us_{-1};
+  /// Time of the last read, negative before the first one
+  int64_t last_read_us_ = -1;
+};
+
+}  // namespace pca9539
+}  // namespace peripherals
+}  // namespace peripheral
+}  // namespace inamata
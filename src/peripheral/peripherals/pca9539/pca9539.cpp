@@ -1,6 +1,8 @@
 #ifndef MINIMAL_BUILD
 #include "pca9539.h"
 
+#include <esp_timer.h>
+
 #include "peripheral/peripheral_factory.h"
 #include "utils/error_store.h"
 
@@ -65,6 +67,56 @@ PCA9539::PCA9539(const JsonObjectConst& parameters)
   if (active_low_in.as<bool>()) {
     active_low_in_ = true;
   }
+
+  // Optionally use the INT output to only read the inputs on changes
+  JsonVariantConst interrupt = parameters[interrupt_key_];
+  if (!interrupt.isNull()) {
+    if (!interrupt.is<uint8_t>()) {
+      setInvalid(ErrorStore::genMissingProperty(
+          interrupt_key_, ErrorStore::KeyType::kUint32t, true));
+      return;
+    }
+    interrupt_pin_ = interrupt.as<uint8_t>();
+    pinMode(interrupt_pin_, INPUT_PULLUP);
+
+    // Banks sharing the INT line are flagged by the same ISR
+    auto chain = interrupt_chains_.find(interrupt_pin_);
+    if (chain != interrupt_chains_.end()) {
+      next_on_interrupt_ = chain->second;
+      detachInterrupt(interrupt_pin_);
+    }
+    interrupt_chains_[interrupt_pin_] = this;
+    attachInterruptArg(interrupt_pin_, handleInterrupt, this, FALLING);
+  }
+}
+
+PCA9539::~PCA9539() {
+  if (interrupt_pin_ < 0) {
+    return;
+  }
+
+  // Unlink from the chain of banks sharing the INT pin
+  auto chain = interrupt_chains_.find(interrupt_pin_);
+  if (chain == interrupt_chains_.end()) {
+    return;
+  }
+  detachInterrupt(interrupt_pin_);
+  if (chain->second == this) {
+    chain->second = next_on_interrupt_;
+  } else {
+    PCA9539* previous = chain->second;
+    while (previous->next_on_interrupt_ != this &&
+           previous->next_on_interrupt_ != nullptr) {
+      previous = previous->next_on_interrupt_;
+    }
+    previous->next_on_interrupt_ = next_on_interrupt_;
+  }
+  if (chain->second == nullptr) {
+    interrupt_chains_.erase(chain);
+  } else {
+    attachInterruptArg(interrupt_pin_, handleInterrupt, chain->second,
+                       FALLING);
+  }
 }
 
 const String& PCA9539::getType() const { return type(); }
@@ -77,7 +129,7 @@ const String& PCA9539::type() {
 capabilities::GetValues::Result PCA9539::getValues() {
   capabilities::GetValues::Result result;
   result.values.reserve(inputs_.size());
-  const uint16_t state = driver_.readGPIO();
+  const uint16_t state = readInputs();
   for (const IO& io : inputs_) {
     bool value = (state & (1 << io.pin)) != 0;
     if (active_low_in_) {
@@ -103,10 +155,34 @@ void PCA9539::setValue(utils::ValueUnit value_unit) {
 }
 
 uint16_t PCA9539::getState() {
-  const uint16_t state = driver_.readGPIO();
+  const uint16_t state = readInputs();
   return active_low_in_ ? ~state : state;
 }
 
+std::chrono::microseconds PCA9539::getChangeAge() const {
+  const int64_t changed_at_us = interrupt_flag_.getChangedAt();
+  if (interrupt_pin_ < 0 || changed_at_us < 0) {
+    return std::chrono::microseconds::zero();
+  }
+  return std::chrono::microseconds(esp_timer_get_time() - changed_at_us);
+}
+
+uint16_t PCA9539::readInputs() {
+  if (interrupt_pin_ < 0 ||
+      interrupt_flag_.shouldRead(esp_timer_get_time())) {
+    state_ = driver_.readGPIO();
+  }
+  return state_;
+}
+
+void IRAM_ATTR PCA9539::handleInterrupt(void* arg) {
+  const int64_t now_us = esp_timer_get_time();
+  for (PCA9539* bank = static_cast<PCA9539*>(arg); bank != nullptr;
+       bank = bank->next_on_interrupt_) {
+    bank->interrupt_flag_.onInterrupt(now_us);
+  }
+}
+
 std::shared_ptr<Peripheral> PCA9539::factory(
     const ServiceGetters& services, const JsonObjectConst& parameters) {
   return std::make_shared<PCA9539>(parameters);
@@ -119,6 +195,10 @@ bool PCA9539::capability_get_values_ =
 bool PCA9539::capability_set_value_ =
     capabilities::SetValue::registerType(type());
 
+std::map<uint8_t, PCA9539*> PCA9539::interrupt_chains_;
+
+const char* PCA9539::interrupt_key_ = "interrupt";
+
 }  // namespace pca9539
 }  // namespace peripherals
 }  // namespace peripheral
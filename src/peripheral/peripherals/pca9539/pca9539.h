@@ -3,11 +3,15 @@
 #include <ArduinoJson.h>
 #include <PCA9539.h>
 
+#include <chrono>
+#include <map>
+
 #include "managers/service_getters.h"
 #include "peripheral/capabilities/get_values.h"
 #include "peripheral/capabilities/set_value.h"
 #include "peripheral/peripheral.h"
 #include "peripheral/peripherals/i2c/i2c_abstract_peripheral.h"
+#include "peripheral/peripherals/pca9539/interrupt_flag.h"
 
 namespace inamata {
 namespace peripheral {
@@ -26,7 +30,7 @@ class PCA9539 : public peripherals::i2c::I2CAbstractPeripheral,
   };
 
   PCA9539(const JsonObjectConst& parameters);
-  virtual ~PCA9539() = default;
+  virtual ~PCA9539();
 
   // Type registration in the peripheral factory
   const String& getType() const final;
@@ -43,10 +47,21 @@ class PCA9539 : public peripherals::i2c::I2CAbstractPeripheral,
   /**
    * Gets the 16-bit input state
    *
+   * With an INT pin, the inputs are only read over I2C after the INT line
+   * flagged a change or the safety poll period has passed. Else the last read
+   * state is returned.
+   *
    * \return The 16-bit input state
    */
   uint16_t getState();
 
+  /**
+   * Time since the INT line last flagged a change
+   *
+   * \return Age of the last change, zero if no INT pin is used
+   */
+  std::chrono::microseconds getChangeAge() const;
+
  private:
   static std::shared_ptr<Peripheral> factory(const ServiceGetters& services,
                                              const JsonObjectConst& parameters);
@@ -54,6 +69,23 @@ class PCA9539 : public peripherals::i2c::I2CAbstractPeripheral,
   static bool capability_get_values_;
   static bool capability_set_value_;
 
+  /**
+   * Reads the raw input port if a change was flagged or polling is due
+   *
+   * \return The raw 16-bit input port state
+   */
+  uint16_t readInputs();
+
+  /**
+   * Flags a change on all banks sharing the INT line
+   *
+   * \param arg The first PCA9539 attached to the INT pin
+   */
+  static void IRAM_ATTR handleInterrupt(void* arg);
+
+  /// Banks sharing an INT pin, chained from the one attached to the pin
+  static std::map<uint8_t, PCA9539*> interrupt_chains_;
+
   static const uint8_t default_i2c_address_ = 0x74;
   uint8_t reset_pin_;
   ::PCA9539 driver_;
@@ -62,6 +94,15 @@ class PCA9539 : public peripherals::i2c::I2CAbstractPeripheral,
   std::vector<IO> outputs_;
   // Invert input states
   bool active_low_in_ = false;
+
+  /// Open-drain INT output of the PCA9539. Negative if not connected
+  int interrupt_pin_ = -1;
+  /// Next bank sharing the same INT pin
+  PCA9539* next_on_interrupt_ = nullptr;
+  /// Flagged by the ISR, decides when to read the inputs
+  InterruptFlag interrupt_flag_;
+  uint16_t state_ = 0;
+  static const char* interrupt_key_;
 };
 
 }  // namespace pca9539
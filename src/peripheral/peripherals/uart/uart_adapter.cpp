@@ -1,5 +1,9 @@
 #include "uart_adapter.h"
 
+#ifdef ESP32
+#include <RTUutils.h>
+#endif
+
 #include "peripheral/peripheral_factory.h"
 
 namespace inamata {
@@ -40,6 +44,7 @@ UARTAdapter::UARTAdapter(const ServiceGetters& services,
   if (!baud_rate.is<float>()) {
     setInvalid(ErrorStore::genMissingProperty(baud_rate_key_,
                                               ErrorStore::KeyType::kString));
+    return;
   }
 #ifdef ESP32
   setupESP32(rx_pin, tx_pin, config_chars.as<const char*>(),
@@ -65,7 +70,11 @@ const String& UARTAdapter::type() {
 
 HardwareSerial* UARTAdapter::getSerial() {
 #ifdef ESP32
-  return nullptr;
+  if (taken_variable_ == &serial2_taken) {
+    return &Serial2;
+  } else {
+    return nullptr;
+  }
 #else
   if (taken_variable_ == &uart0_taken) {
     return &Serial;
@@ -87,27 +96,47 @@ bool UARTAdapter::registered_ =
 
 #ifdef ESP32
 void UARTAdapter::setupESP32(int rx_pin, int tx_pin, const char* config_chars,
-                             int baud_rate) {}
+                             int baud_rate) {
+  const int config_bits = parseUARTConfig(config_chars);
+  if (config_bits < 0) {
+    setInvalid(config_error_);
+    return;
+  }
+
+  // Serial is the console and Serial1 is used by the modem / Modbus client
+  if (serial2_taken) {
+    setInvalid(serial_taken_error_);
+    return;
+  }
+  serial2_taken = true;
+  taken_variable_ = &serial2_taken;
+  // Buffer a full Modbus RTU frame for the Modbus server. The buffer sizes
+  // can only be set before the UART is started
+  RTUutils::prepareHardwareSerial(Serial2);
+  Serial2.begin(baud_rate, config_bits, rx_pin, tx_pin);
+}
 #endif
 
 int UARTAdapter::parseUARTConfig(const char* config_chars) {
-  int config_bits = 0;
+  // Arduino's SerialConfig sets this flag and packs the data bits in bits 2-3
+  // and the stop bits in bits 4-5
+  int config_bits = 0x8000000;
   if (!config_chars || strlen(config_chars) != 3) {
     config_bits = SERIAL_8N1;
   } else {
     const char data_bits = config_chars[0];
     switch (data_bits) {
       case '5':
-        config_bits |= UART_DATA_5_BITS;
+        config_bits |= UART_DATA_5_BITS << 2;
         break;
       case '6':
-        config_bits |= UART_DATA_6_BITS;
+        config_bits |= UART_DATA_6_BITS << 2;
         break;
       case '7':
-        config_bits |= UART_DATA_7_BITS;
+        config_bits |= UART_DATA_7_BITS << 2;
         break;
       case '8':
-        config_bits |= UART_DATA_8_BITS;
+        config_bits |= UART_DATA_8_BITS << 2;
         break;
       default:
         return -1;
@@ -129,10 +158,10 @@ int UARTAdapter::parseUARTConfig(const char* config_chars) {
     const char stop_bits = config_chars[2];
     switch (stop_bits) {
       case '1':
-        config_bits |= UART_STOP_BITS_1;
+        config_bits |= UART_STOP_BITS_1 << 4;
         break;
       case '2':
-        config_bits |= UART_STOP_BITS_2;
+        config_bits |= UART_STOP_BITS_2 << 4;
         break;
       default:
         return -1;
@@ -39,6 +39,12 @@ CheckConnectivity::CheckConnectivity(const ServiceGetters& services,
     setInvalid(services.web_socket_nullptr_error_);
     return;
   }
+#ifdef GSM_NETWORK
+  // Messages sent by other tasks would read the modem's SMS responses
+  web_socket_->setCanSendCallback([gsm_network = gsm_network_]() {
+    return !gsm_network->isSendingSms();
+  });
+#endif
   const bool success = initGsmWifiSwitch();
   if (!success) {
     return;
@@ -65,7 +71,14 @@ bool CheckConnectivity::OnTaskEnable() {
 
 bool CheckConnectivity::TaskCallback() {
   const auto now = std::chrono::steady_clock::now();
+  // Persist secrets changed by provisioning once changes have settled
+  services_.getStorage()->handleSecretsWriteBack();
   handleGsmWifiSwitch(now);
+#ifdef GSM_NETWORK
+  if (gsm_network_->isEnabled()) {
+    gsm_network_->handleSmsOutbox();
+  }
+#endif
   if (mode_ == Mode::ConnectWiFi) {
     WiFiNetwork::ConnectMode connect_mode = wifi_network_->connect();
     // Disable starting WiFi captive portal if the WebSocket connects once
@@ -88,7 +101,8 @@ bool CheckConnectivity::TaskCallback() {
     if (canGsmConnect()) {
       // Try connecting
       gsm_network_->handleConnection();
-      if (gsm_network_->isGprsConnected()) {
+      // The GSM client would read the modem's SMS responses
+      if (gsm_network_->isGprsConnected() && !gsm_network_->isSendingSms()) {
         handleClockSync(now);
         if (Services::is_time_synced_) {
           handleWebSocket();
@@ -229,6 +243,7 @@ void CheckConnectivity::enterConnectMode() {
       gsm_network_->disable();
       WebSocketsNetworkClient::Impl::enableWifi();
       Services::getOtaUpdater().useNetwork(OtaUpdater::Network::kWifi);
+      web_socket_->setLinkType(WebSocket::LinkType::kWifi);
       setMode(Mode::ConnectWiFi);
       break;
     case UseNetwork::kGsm:
@@ -236,6 +251,7 @@ void CheckConnectivity::enterConnectMode() {
       gsm_network_->enable();
       WebSocketsNetworkClient::Impl::enableGsm(&gsm_network_->modem_);
       Services::getOtaUpdater().useNetwork(OtaUpdater::Network::kGsm);
+      web_socket_->setLinkType(WebSocket::LinkType::kGsm);
       setMode(Mode::ConnectGsm);
       break;
     case UseNetwork::kNone:
@@ -14,11 +14,14 @@ namespace fixed {
 using namespace std::placeholders;
 
 Alarms::Alarms(const ServiceGetters& services, Scheduler& scheduler,
-               const JsonObjectConst& behavior_config)
+               const JsonObjectConst& behavior_config,
+               InputSampler& input_sampler)
     : BaseTask(scheduler, Input(nullptr, true)),
       gsm_network_(services.getGsmNetwork()),
       config_manager_(services.getConfigManager()),
-      web_socket_(services.getWebSocket()) {
+      logging_manager_(services.getLoggingManager()),
+      web_socket_(services.getWebSocket()),
+      input_sampler_(input_sampler) {
   if (!isValid()) {
     return;
   }
@@ -35,38 +38,12 @@ Alarms::Alarms(const ServiceGetters& services, Scheduler& scheduler,
     setInvalid(services.config_manager_nullptr_error_);
     return;
   }
+  if (logging_manager_ == nullptr) {
+    setInvalid(services.log_manager_nullptr_error_);
+    return;
+  }
 
   auto& peripheral_controller = Services::getPeripheralController();
-  input_bank_1_ =
-      std::dynamic_pointer_cast<PCA9539>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_io_1_id));
-  input_bank_2_ =
-      std::dynamic_pointer_cast<PCA9539>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_io_2_id));
-  input_bank_4_[0] =
-      std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_electric_control_circuit_fail_id));
-  input_bank_4_[1] =
-      std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_jockey_1_pump_run_id));
-  input_bank_4_[2] =
-      std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_jockey_2_pump_run_id));
-  input_bank_4_[3] =
-      std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_jockey_1_pump_fail_id));
-  input_bank_4_[4] =
-      std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_jockey_2_pump_fail_id));
-  input_bank_4_[5] =
-      std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_pumphouse_protection_alarm_id));
-  input_bank_4_[6] =
-      std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_annunciator_fault_id));
-  input_bank_4_[7] =
-      std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
-          peripheral::fixed::peripheral_pumphouse_flooding_alarm_id));
   maintenance_input_ =
       std::dynamic_pointer_cast<DigitalIn>(peripheral_controller.getPeripheral(
           peripheral::fixed::peripheral_maintenance_input_id));
@@ -83,25 +60,17 @@ Alarms::Alarms(const ServiceGetters& services, Scheduler& scheduler,
       std::dynamic_pointer_cast<DigitalOut>(peripheral_controller.getPeripheral(
           peripheral::fixed::peripheral_relay_2_id));
 
-  if (!input_bank_1_ || !input_bank_2_ || !input_bank_4_[0] ||
-      !input_bank_4_[1] || !input_bank_4_[2] || !input_bank_4_[3] ||
-      !input_bank_4_[4] || !input_bank_4_[5] || !input_bank_4_[6] ||
-      !input_bank_4_[7] || !maintenance_input_ || !maintenance_button_ ||
-      !status_led_ || !relay_1_ || !relay_2_) {
-    char buffer[54];
-    snprintf(buffer, sizeof(buffer),
-             "Missing peri: %d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d",
-             bool(input_bank_1_), bool(input_bank_2_), bool(input_bank_4_[0]),
-             bool(input_bank_4_[1]), bool(input_bank_4_[2]),
-             bool(input_bank_4_[3]), bool(input_bank_4_[4]),
-             bool(input_bank_4_[5]), bool(input_bank_4_[6]),
-             bool(input_bank_4_[7]), bool(maintenance_input_),
-             bool(maintenance_button_), bool(status_led_), bool(relay_1_),
-             bool(relay_2_));
+  if (!maintenance_input_ || !maintenance_button_ || !status_led_ ||
+      !relay_1_ || !relay_2_) {
+    char buffer[28];
+    snprintf(buffer, sizeof(buffer), "Missing peri: %d:%d:%d:%d:%d",
+             bool(maintenance_input_), bool(maintenance_button_),
+             bool(status_led_), bool(relay_1_), bool(relay_2_));
     setInvalid(buffer);
     return;
   }
 
+  buildInputLimits();
   resetLimits();
 
   if (!behavior_config.isNull()) {
@@ -129,21 +98,11 @@ bool Alarms::TaskCallback() {
   handleSmsReminders();
 
   if (!is_maintenance_mode_) {
-    auto result = input_bank_1_->getValues();
-    for (const auto& value : result.values) {
-      handleResult(value);
-    }
-    result = input_bank_2_->getValues();
-    for (const auto& value : result.values) {
-      handleResult(value);
-    }
-    for (const auto& digital_in : input_bank_4_) {
-      result = digital_in->getValues();
-      if (result.values.size() == 1) {
-        handleResult(result.values[0]);
-      } else {
-        TRACEF("Missing value: %s", result.error.toString().c_str());
-      }
+    // Use the inputs read by the input sampler earlier in this pass
+    const InputSampler::InputStates& states =
+        input_sampler_.getSnapshot().states;
+    for (size_t i = 0; i < states.size(); i++) {
+      handleResult(utils::ValueUnit(states[i], *InputSampler::dpts_[i]));
     }
   }
   return true;
@@ -178,147 +137,84 @@ void Alarms::resetLimits() {
   reminder_limits_.clear();
 }
 
+void Alarms::buildInputLimits() {
+  using namespace peripheral::fixed;
+
+  input_limits_ = {
+      // Digital alarms
+      {dpt_diesel_1_pump_run_id, {&limit_diesel_1_pump_run_}},
+      {dpt_diesel_2_pump_run_id, {&limit_diesel_2_pump_run_}},
+      {dpt_diesel_3_pump_run_id, {&limit_diesel_3_pump_run_}},
+      {dpt_diesel_4_pump_run_id, {&limit_diesel_4_pump_run_}},
+      {dpt_diesel_1_fire_alarm_id, {&limit_diesel_1_fire_alarm_}},
+      {dpt_diesel_2_fire_alarm_id, {&limit_diesel_2_fire_alarm_}},
+      {dpt_diesel_3_fire_alarm_id, {&limit_diesel_3_fire_alarm_}},
+      {dpt_diesel_4_fire_alarm_id, {&limit_diesel_4_fire_alarm_}},
+      {dpt_diesel_1_pump_fail_id, {&limit_diesel_1_pump_fail_}},
+      {dpt_diesel_2_pump_fail_id, {&limit_diesel_2_pump_fail_}},
+      {dpt_diesel_3_pump_fail_id, {&limit_diesel_3_pump_fail_}},
+      {dpt_diesel_4_pump_fail_id, {&limit_diesel_4_pump_fail_}},
+      {dpt_diesel_1_battery_charger_fail_id,
+       {&limit_diesel_1_battery_charger_fail_}},
+      {dpt_diesel_2_battery_charger_fail_id,
+       {&limit_diesel_2_battery_charger_fail_}},
+      {dpt_diesel_3_battery_charger_fail_id,
+       {&limit_diesel_3_battery_charger_fail_}},
+      {dpt_diesel_4_battery_charger_fail_id,
+       {&limit_diesel_4_battery_charger_fail_}},
+      {dpt_diesel_1_low_oil_level_fail_id,
+       {&limit_diesel_1_low_oil_level_fail_}},
+      {dpt_diesel_2_low_oil_level_fail_id,
+       {&limit_diesel_2_low_oil_level_fail_}},
+      {dpt_diesel_3_low_oil_level_fail_id,
+       {&limit_diesel_3_low_oil_level_fail_}},
+      {dpt_diesel_4_low_oil_level_fail_id,
+       {&limit_diesel_4_low_oil_level_fail_}},
+      {dpt_diesel_control_circuit_fail_id,
+       {&limit_diesel_control_circuit_fail_}},
+      {dpt_diesel_mains_fail_id, {&limit_diesel_mains_fail_}},
+      {dpt_diesel_pump_fail_id, {&limit_diesel_pump_fail_}},
+      {dpt_diesel_engine_overheat_fail_id,
+       {&limit_diesel_engine_overheat_fail_}},
+      {dpt_diesel_fuel_tank_low_id, {&limit_diesel_fuel_tank_low_}},
+      {dpt_electric_1_pump_run_id, {&limit_electric_1_pump_run_}},
+      {dpt_electric_2_pump_run_id, {&limit_electric_2_pump_run_}},
+      {dpt_electric_1_fire_alarm_id, {&limit_electric_1_fire_alarm_}},
+      {dpt_electric_2_fire_alarm_id, {&limit_electric_2_fire_alarm_}},
+      {dpt_electric_1_pump_fail_id, {&limit_electric_1_pump_fail_}},
+      {dpt_electric_2_pump_fail_id, {&limit_electric_2_pump_fail_}},
+      {dpt_electric_mains_fail_id, {&limit_electric_mains_fail_}},
+      {dpt_electric_control_circuit_fail_id,
+       {&limit_electric_control_circuit_fail_}},
+      {dpt_jockey_1_pump_fail_id, {&limit_jockey_1_pump_fail_}},
+      {dpt_jockey_2_pump_fail_id, {&limit_jockey_2_pump_fail_}},
+      {dpt_pumphouse_protection_alarm_id, {&limit_pumphouse_protection_alarm_}},
+      {dpt_annunciator_fault_id, {&limit_annunciator_fault_}},
+      {dpt_pumphouse_flooding_alarm_id, {&limit_pumphouse_flooding_alarm_}},
+      // Runtime alarms
+      {dpt_jockey_1_pump_run_id,
+       {nullptr, &limit_duration_jockey_1_pump_run_,
+        &limit_activation_jockey_1_pump_run_}},
+      {dpt_jockey_2_pump_run_id,
+       {nullptr, &limit_duration_jockey_2_pump_run_,
+        &limit_activation_jockey_2_pump_run_}},
+  };
+}
+
 void Alarms::handleResult(const utils::ValueUnit& value_unit) {
-  /// Digital alarms
-  if (peripheral::fixed::dpt_diesel_1_pump_run_id ==
-      value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_1_pump_run_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_2_pump_run_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_2_pump_run_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_3_pump_run_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_3_pump_run_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_4_pump_run_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_4_pump_run_, value_unit);
-  }
-
-  else if (peripheral::fixed::dpt_diesel_1_fire_alarm_id ==
-           value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_1_fire_alarm_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_2_fire_alarm_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_2_fire_alarm_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_3_fire_alarm_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_3_fire_alarm_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_4_fire_alarm_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_4_fire_alarm_, value_unit);
-  }
-
-  else if (peripheral::fixed::dpt_diesel_1_pump_fail_id ==
-           value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_1_pump_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_2_pump_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_2_pump_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_3_pump_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_3_pump_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_4_pump_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_4_pump_fail_, value_unit);
-  }
-
-  else if (peripheral::fixed::dpt_diesel_1_battery_charger_fail_id ==
-           value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_1_battery_charger_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_2_battery_charger_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_2_battery_charger_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_3_battery_charger_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_3_battery_charger_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_4_battery_charger_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_4_battery_charger_fail_, value_unit);
-  }
-
-  else if (peripheral::fixed::dpt_diesel_1_low_oil_level_fail_id ==
-           value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_1_low_oil_level_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_2_low_oil_level_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_2_low_oil_level_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_3_low_oil_level_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_3_low_oil_level_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_4_low_oil_level_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_4_low_oil_level_fail_, value_unit);
-  }
-
-  else if (peripheral::fixed::dpt_diesel_control_circuit_fail_id ==
-           value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_control_circuit_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_mains_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_mains_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_pump_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_pump_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_engine_overheat_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_engine_overheat_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_diesel_fuel_tank_low_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_diesel_fuel_tank_low_, value_unit);
-  }
-
-  else if (peripheral::fixed::dpt_electric_1_pump_run_id ==
-           value_unit.data_point_type) {
-    handleBoolLimit(limit_electric_1_pump_run_, value_unit);
-  } else if (peripheral::fixed::dpt_electric_2_pump_run_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_electric_2_pump_run_, value_unit);
-  } else if (peripheral::fixed::dpt_electric_1_fire_alarm_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_electric_1_fire_alarm_, value_unit);
-  } else if (peripheral::fixed::dpt_electric_2_fire_alarm_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_electric_2_fire_alarm_, value_unit);
-  } else if (peripheral::fixed::dpt_electric_1_pump_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_electric_1_pump_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_electric_2_pump_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_electric_2_pump_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_electric_mains_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_electric_mains_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_electric_control_circuit_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_electric_control_circuit_fail_, value_unit);
-  }
-
-  else if (peripheral::fixed::dpt_jockey_1_pump_fail_id ==
-           value_unit.data_point_type) {
-    handleBoolLimit(limit_jockey_1_pump_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_jockey_2_pump_fail_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_jockey_2_pump_fail_, value_unit);
-  } else if (peripheral::fixed::dpt_pumphouse_protection_alarm_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_pumphouse_protection_alarm_, value_unit);
-  } else if (peripheral::fixed::dpt_annunciator_fault_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_annunciator_fault_, value_unit);
-  } else if (peripheral::fixed::dpt_pumphouse_flooding_alarm_id ==
-             value_unit.data_point_type) {
-    handleBoolLimit(limit_pumphouse_flooding_alarm_, value_unit);
-  }
-
-  /// Runtime alarms
-  else if (peripheral::fixed::dpt_jockey_1_pump_run_id ==
-           value_unit.data_point_type) {
-    handleDurationLimit(limit_duration_jockey_1_pump_run_, value_unit);
-    handleActivationLimit(limit_activation_jockey_1_pump_run_, value_unit);
-  } else if (peripheral::fixed::dpt_jockey_2_pump_run_id ==
-             value_unit.data_point_type) {
-    handleDurationLimit(limit_duration_jockey_2_pump_run_, value_unit);
-    handleActivationLimit(limit_activation_jockey_2_pump_run_, value_unit);
+  const InputLimits* limits = input_limits_.find(value_unit.data_point_type);
+  if (!limits) {
+    return;
+  }
+
+  if (limits->bool_limit) {
+    handleBoolLimit(*limits->bool_limit, value_unit);
+  }
+  if (limits->duration_limit) {
+    handleDurationLimit(*limits->duration_limit, value_unit);
+  }
+  if (limits->activation_limit) {
+    handleActivationLimit(*limits->activation_limit, value_unit);
   }
 }
 
@@ -456,6 +352,11 @@ void Alarms::sendLimitEvent(BaseLimit* limit,
   }
   sendStartStopSms(limit, value_unit, type);
 
+  // Persist the buffered input logs leading up to the alarm
+  if (type == utils::LimitEvent::Type::kStart) {
+    logging_manager_->flush();
+  }
+
   // Don't send if the controller limit ID or FP ID was not set
   if (!limit->limit_id.isValid() || limit->fixed_peripheral_id == nullptr) {
     TRACEF("Limit event: %d : %s\r\n", int(type),
@@ -465,7 +366,7 @@ void Alarms::sendLimitEvent(BaseLimit* limit,
 
   JsonDocument limit_event;
   if (Services::is_time_synced_) {
-    limit_event[WebSocket::time_key_] = utils::getIsoTimestamp();
+    utils::setTimestamp(limit_event[WebSocket::time_key_]);
   }
   limit_event[WebSocket::limit_id_key_] = limit->limit_id.toString();
   limit_event[utils::ValueUnit::value_key] = value_unit.value;
@@ -516,7 +417,7 @@ void Alarms::sendStartStopSms(BaseLimit* limit,
           contact.group_data[kGroupDataManagementBit]) {
         Serial.println(contact.cleanPhoneNumber());
         Serial.println(text);
-        gsm_network_->modem_.sendSMS(contact.cleanPhoneNumber(), text);
+        gsm_network_->queueSms(contact.cleanPhoneNumber(), text);
       }
     }
   } else {
@@ -524,7 +425,7 @@ void Alarms::sendStartStopSms(BaseLimit* limit,
       if (contact.group_data[kGroupDataMaintenanceBit]) {
         Serial.println(contact.cleanPhoneNumber());
         Serial.println(text);
-        gsm_network_->modem_.sendSMS(contact.cleanPhoneNumber(), text);
+        gsm_network_->queueSms(contact.cleanPhoneNumber(), text);
       }
     }
   }
@@ -568,7 +469,7 @@ void Alarms::handleSmsReminders() {
               contact.group_data[kGroupDataManagementBit]) {
             Serial.println(contact.cleanPhoneNumber());
             Serial.println(text);
-            gsm_network_->modem_.sendSMS(contact.cleanPhoneNumber(), text);
+            gsm_network_->queueSms(contact.cleanPhoneNumber(), text);
           }
         }
       }
@@ -582,7 +483,7 @@ void Alarms::handleSmsReminders() {
               contact.group_data[kGroupDataManagementBit]) {
             Serial.println(contact.cleanPhoneNumber());
             Serial.println(text);
-            gsm_network_->modem_.sendSMS(contact.cleanPhoneNumber(), text);
+            gsm_network_->queueSms(contact.cleanPhoneNumber(), text);
           }
         }
       }
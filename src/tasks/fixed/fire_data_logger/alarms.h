@@ -1,12 +1,13 @@
 #pragma once
 
+#include "input_sampler.h"
 #include "managers/services.h"
 #include "peripheral/fixed.h"
 #include "peripheral/peripherals/digital_in/digital_in.h"
 #include "peripheral/peripherals/digital_out/digital_out.h"
 #include "peripheral/peripherals/neo_pixel/neo_pixel.h"
-#include "peripheral/peripherals/pca9539/pca9539.h"
 #include "utils/limit_event.h"
+#include "utils/sorted_table.h"
 
 namespace inamata {
 namespace tasks {
@@ -17,10 +18,9 @@ class Alarms : public BaseTask {
   using DigitalOut = peripheral::peripherals::digital_out::DigitalOut;
   using DigitalIn = peripheral::peripherals::digital_in::DigitalIn;
   using NeoPixel = peripheral::peripherals::neo_pixel::NeoPixel;
-  using PCA9539 = peripheral::peripherals::pca9539::PCA9539;
 
   Alarms(const ServiceGetters& services, Scheduler& scheduler,
-         const JsonObjectConst& behavior_config);
+         const JsonObjectConst& behavior_config, InputSampler& input_sampler);
   virtual ~Alarms() = default;
 
   const String& getType() const final;
@@ -111,11 +111,27 @@ class Alarms : public BaseTask {
     bool current_state_ = false;
   };
 
+  /**
+   * The limits checked for an input's data point type
+   */
+  struct InputLimits {
+    BoolLimit* bool_limit = nullptr;
+    DurationLimit* duration_limit = nullptr;
+    ActivationLimit* activation_limit = nullptr;
+  };
+
   void resetLimits();
 
+  /**
+   * Build the table of limits per data point type sorted by the DPT
+   */
+  void buildInputLimits();
+
   /**
    * Handle value from digital input
    *
+   * Looks up the input's limits with a binary search on the DPT.
+   *
    * \param values Measured floats and DPTs from IO expander and digital inputs
    */
   void handleResult(const utils::ValueUnit& value);
@@ -184,14 +200,12 @@ class Alarms : public BaseTask {
 
   std::shared_ptr<GsmNetwork> gsm_network_;
   std::shared_ptr<ConfigManager> config_manager_;
+  std::shared_ptr<LoggingManager> logging_manager_;
   // Testing safety to send only one SMS
   bool sent_sms_ = false;
   std::shared_ptr<WebSocket> web_socket_;
 
-  std::shared_ptr<PCA9539> input_bank_1_;
-  std::shared_ptr<PCA9539> input_bank_2_;
-  // All digital inputs connected directly to the ESP32
-  std::array<std::shared_ptr<DigitalIn>, 8> input_bank_4_;
+  InputSampler& input_sampler_;
 
   std::shared_ptr<DigitalOut> relay_1_;
   std::shared_ptr<DigitalOut> relay_2_;
@@ -341,6 +355,8 @@ class Alarms : public BaseTask {
       &limit_annunciator_fault_,
       &limit_pumphouse_flooding_alarm_,
   };
+  /// Limits of each input, sorted by the DPT. Built once on construction
+  utils::SortedTable<utils::UUID, InputLimits> input_limits_;
   /// Limits that should send reminders if not cleared by maintenance mode
   std::vector<BaseLimit*> reminder_limits_;
 
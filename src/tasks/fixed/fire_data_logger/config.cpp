@@ -5,6 +5,7 @@
 #include "alarms.h"
 #include "configuration.h"
 #include "heartbeat.h"
+#include "input_sampler.h"
 #include "log_inputs.h"
 #include "network_state.h"
 #include "telemetry.h"
@@ -25,7 +26,18 @@ bool startFixedTasks(const ServiceGetters& services, Scheduler& scheduler,
     return false;
   }
 
-  Alarms* alarms_task = new Alarms(services, scheduler, behavior_config);
+  // Created first so each scheduler pass samples the inputs before the tasks
+  // using them run
+  InputSampler* input_sampler_task = new InputSampler(scheduler);
+  if (!input_sampler_task->isValid()) {
+    Serial.println(input_sampler_task->getError().toString());
+    input_sampler_task->abort();
+    delete input_sampler_task;
+    return false;
+  }
+
+  Alarms* alarms_task =
+      new Alarms(services, scheduler, behavior_config, *input_sampler_task);
   if (!alarms_task->isValid()) {
     Serial.println(alarms_task->getError().toString());
     alarms_task->abort();
@@ -41,7 +53,8 @@ bool startFixedTasks(const ServiceGetters& services, Scheduler& scheduler,
     return false;
   }
 
-  Telemetry* telemetry_task = new Telemetry(services, scheduler);
+  Telemetry* telemetry_task =
+      new Telemetry(services, scheduler, *input_sampler_task);
   if (!telemetry_task->isValid()) {
     Serial.println(telemetry_task->getError().toString());
     telemetry_task->abort();
@@ -49,7 +62,8 @@ bool startFixedTasks(const ServiceGetters& services, Scheduler& scheduler,
     return false;
   }
 
-  LogInputs* log_inputs_task = new LogInputs(services, scheduler);
+  LogInputs* log_inputs_task =
+      new LogInputs(services, scheduler, *input_sampler_task);
   if (!log_inputs_task->isValid()) {
     Serial.println(log_inputs_task->getError().toString());
     log_inputs_task->abort();
@@ -0,0 +1,149 @@
+#ifdef DEVICE_TYPE_FIRE_DATA_LOGGER
+
+#include "input_sampler.h"
+
+namespace inamata {
+namespace tasks {
+namespace fixed {
+
+InputSampler::InputSampler(Scheduler& scheduler)
+    : BaseTask(scheduler, Input(nullptr, true)) {
+  if (!isValid()) {
+    return;
+  }
+
+  auto& peripheral_controller = Services::getPeripheralController();
+  input_bank_1_ =
+      std::dynamic_pointer_cast<PCA9539>(peripheral_controller.getPeripheral(
+          peripheral::fixed::peripheral_io_1_id));
+  input_bank_2_ =
+      std::dynamic_pointer_cast<PCA9539>(peripheral_controller.getPeripheral(
+          peripheral::fixed::peripheral_io_2_id));
+  bool missing_gpio_input = false;
+  for (size_t i = 0; i < gpio_inputs_.size(); i++) {
+    gpio_inputs_[i] = std::dynamic_pointer_cast<DigitalIn>(
+        peripheral_controller.getPeripheral(*gpio_peripheral_ids_[i]));
+    missing_gpio_input |= !gpio_inputs_[i];
+  }
+
+  if (!input_bank_1_ || !input_bank_2_ || missing_gpio_input) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "Missing peri: %d:%d:%d",
+             bool(input_bank_1_), bool(input_bank_2_), !missing_gpio_input);
+    setInvalid(buffer);
+    return;
+  }
+
+  // Take the first snapshot so it is valid when the other tasks start
+  sample();
+  snapshot_.changed.reset();
+
+  setIterations(TASK_FOREVER);
+  enable();
+}
+
+const String& InputSampler::getType() const { return type(); }
+
+const String& InputSampler::type() {
+  static const String name{"InputSampler"};
+  return name;
+}
+
+const InputSampler::Snapshot& InputSampler::getSnapshot() const {
+  return snapshot_;
+}
+
+void InputSampler::subscribe(Callback callback) {
+  callbacks_.push_back(callback);
+}
+
+const InputSampler::PCA9539& InputSampler::getInputBank(size_t index) const {
+  return index < 16 ? *input_bank_1_ : *input_bank_2_;
+}
+
+bool InputSampler::TaskCallback() {
+  Task::delay(std::chrono::milliseconds(default_interval_).count());
+
+  if (!sample()) {
+    return true;
+  }
+  for (const auto& callback : callbacks_) {
+    callback(snapshot_);
+  }
+  return true;
+}
+
+bool InputSampler::sample() {
+  uint16_t gpios = 0;
+  for (size_t i = 0; i < gpio_inputs_.size(); i++) {
+    gpios |= uint16_t(gpio_inputs_[i]->readState()) << i;
+  }
+  return snapshot_.update(
+      InputSnapshot::combine(input_bank_1_->getState(),
+                             input_bank_2_->getState(), gpios),
+      std::chrono::steady_clock::now());
+}
+
+const std::array<const utils::UUID*, InputSampler::kInputCount>
+    InputSampler::dpts_ = {
+        &peripheral::fixed::dpt_diesel_1_fire_alarm_id,
+        &peripheral::fixed::dpt_diesel_2_fire_alarm_id,
+        &peripheral::fixed::dpt_diesel_3_fire_alarm_id,
+        &peripheral::fixed::dpt_diesel_4_fire_alarm_id,
+        &peripheral::fixed::dpt_diesel_1_pump_run_id,
+        &peripheral::fixed::dpt_diesel_2_pump_run_id,
+        &peripheral::fixed::dpt_diesel_3_pump_run_id,
+        &peripheral::fixed::dpt_diesel_4_pump_run_id,
+        &peripheral::fixed::dpt_diesel_1_pump_fail_id,
+        &peripheral::fixed::dpt_diesel_2_pump_fail_id,
+        &peripheral::fixed::dpt_diesel_3_pump_fail_id,
+        &peripheral::fixed::dpt_diesel_4_pump_fail_id,
+        &peripheral::fixed::dpt_diesel_1_battery_charger_fail_id,
+        &peripheral::fixed::dpt_diesel_2_battery_charger_fail_id,
+        &peripheral::fixed::dpt_diesel_3_battery_charger_fail_id,
+        &peripheral::fixed::dpt_diesel_4_battery_charger_fail_id,
+        &peripheral::fixed::dpt_diesel_1_low_oil_level_fail_id,
+        &peripheral::fixed::dpt_diesel_2_low_oil_level_fail_id,
+        &peripheral::fixed::dpt_diesel_3_low_oil_level_fail_id,
+        &peripheral::fixed::dpt_diesel_4_low_oil_level_fail_id,
+        &peripheral::fixed::dpt_diesel_control_circuit_fail_id,
+        &peripheral::fixed::dpt_diesel_mains_fail_id,
+        &peripheral::fixed::dpt_diesel_pump_fail_id,
+        &peripheral::fixed::dpt_diesel_engine_overheat_fail_id,
+        &peripheral::fixed::dpt_diesel_fuel_tank_low_id,
+        &peripheral::fixed::dpt_electric_1_fire_alarm_id,
+        &peripheral::fixed::dpt_electric_2_fire_alarm_id,
+        &peripheral::fixed::dpt_electric_1_pump_run_id,
+        &peripheral::fixed::dpt_electric_2_pump_run_id,
+        &peripheral::fixed::dpt_electric_1_pump_fail_id,
+        &peripheral::fixed::dpt_electric_2_pump_fail_id,
+        &peripheral::fixed::dpt_electric_mains_fail_id,
+        &peripheral::fixed::dpt_electric_control_circuit_fail_id,
+        &peripheral::fixed::dpt_jockey_1_pump_run_id,
+        &peripheral::fixed::dpt_jockey_2_pump_run_id,
+        &peripheral::fixed::dpt_jockey_1_pump_fail_id,
+        &peripheral::fixed::dpt_jockey_2_pump_fail_id,
+        &peripheral::fixed::dpt_pumphouse_protection_alarm_id,
+        &peripheral::fixed::dpt_annunciator_fault_id,
+        &peripheral::fixed::dpt_pumphouse_flooding_alarm_id,
+        &peripheral::fixed::dpt_maintenance_input_id,
+};
+
+const std::array<const utils::UUID*, InputSampler::kInputCount - 32>
+    InputSampler::gpio_peripheral_ids_ = {
+        &peripheral::fixed::peripheral_electric_control_circuit_fail_id,
+        &peripheral::fixed::peripheral_jockey_1_pump_run_id,
+        &peripheral::fixed::peripheral_jockey_2_pump_run_id,
+        &peripheral::fixed::peripheral_jockey_1_pump_fail_id,
+        &peripheral::fixed::peripheral_jockey_2_pump_fail_id,
+        &peripheral::fixed::peripheral_pumphouse_protection_alarm_id,
+        &peripheral::fixed::peripheral_annunciator_fault_id,
+        &peripheral::fixed::peripheral_pumphouse_flooding_alarm_id,
+        &peripheral::fixed::peripheral_maintenance_input_id,
+};
+
+}  // namespace fixed
+}  // namespace tasks
+}  // namespace inamata
+
+#endif
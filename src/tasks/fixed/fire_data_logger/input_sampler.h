@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "managers/services.h"
+#include "peripheral/fixed.h"
+#include "peripheral/peripherals/digital_in/digital_in.h"
+#include "peripheral/peripherals/pca9539/pca9539.h"
+#include "tasks/fixed/fire_data_logger/input_snapshot.h"
+#include "utils/uuid.h"
+
+namespace inamata {
+namespace tasks {
+namespace fixed {
+
+/**
+ * Reads all fire data logger inputs once per cycle
+ *
+ * The Telemetry, LogInputs and Alarms tasks use the same snapshot instead of
+ * each reading the PCA9539 banks and GPIOs and diffing their own states.
+ */
+class InputSampler : public BaseTask {
+ public:
+  using DigitalIn = peripheral::peripherals::digital_in::DigitalIn;
+  using PCA9539 = peripheral::peripherals::pca9539::PCA9539;
+
+  static constexpr size_t kInputCount = InputSnapshot::kInputCount;
+  using InputStates = InputSnapshot::InputStates;
+  using Snapshot = InputSnapshot;
+
+  using Callback = std::function<void(const Snapshot& snapshot)>;
+
+  InputSampler(Scheduler& scheduler);
+  virtual ~InputSampler() = default;
+
+  const String& getType() const final;
+  static const String& type();
+
+  /**
+   * Get the latest snapshot of all inputs
+   *
+   * \return The latest snapshot
+   */
+  const Snapshot& getSnapshot() const;
+
+  /**
+   * Register a callback that is called when a snapshot has changed inputs
+   *
+   * \param callback Receives the snapshot with the changed inputs
+   */
+  void subscribe(Callback callback);
+
+  /**
+   * Get the PCA9539 bank of an input
+   *
+   * \param index Input index below 32
+   * \return The bank the input is connected to
+   */
+  const PCA9539& getInputBank(size_t index) const;
+
+  /// The data point type of each input index
+  static const std::array<const utils::UUID*, kInputCount> dpts_;
+  /// The peripheral of each GPIO input, starting at input index 32
+  static const std::array<const utils::UUID*, kInputCount - 32>
+      gpio_peripheral_ids_;
+
+ private:
+  bool TaskCallback() final;
+
+  /**
+   * Read all inputs into the snapshot and mark the changed inputs
+   *
+   * \return True if any input changed
+   */
+  bool sample();
+
+  std::shared_ptr<PCA9539> input_bank_1_;
+  std::shared_ptr<PCA9539> input_bank_2_;
+  std::array<std::shared_ptr<DigitalIn>, kInputCount - 32> gpio_inputs_;
+
+  Snapshot snapshot_;
+  std::vector<Callback> callbacks_;
+
+  /// Matches the Alarms task, the most frequent user of the snapshot. Input
+  /// changes reach all tasks within one pass without sampling more often
+  static constexpr std::chrono::milliseconds default_interval_{250};
+};
+
+}  // namespace fixed
+}  // namespace tasks
+}  // namespace inamata
@@ -0,0 +1,25 @@
+#include "input_snapshot.h"
+
+namespace inamata {
+namespace tasks {
+namespace fixed {
+
+InputSnapshot::InputStates InputSnapshot::combine(uint16_t bank_1,
+                                                  uint16_t bank_2,
+                                                  uint16_t gpios) {
+  const uint64_t gpio_mask = (uint64_t(1) << kGpioCount) - 1;
+  return InputStates(uint64_t(bank_1) | uint64_t(bank_2) << 16 |
+                     (uint64_t(gpios) & gpio_mask) << 32);
+}
+
+bool InputSnapshot::update(const InputStates& new_states,
+                           std::chrono::steady_clock::time_point now) {
+  changed = states ^ new_states;
+  states = new_states;
+  sampled_at = now;
+  return changed.any();
+}
+
+}  // namespace fixed
+}  // namespace tasks
+}  // namespace inamata
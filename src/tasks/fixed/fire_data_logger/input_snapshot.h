@@ -0,0 +1,55 @@
+#pragma once
+
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace inamata {
+namespace tasks {
+namespace fixed {
+
+/**
+ * States of all fire data logger inputs at one sample
+ *
+ * Input index i corresponds to the port I(i + 1):
+ *  - 0-15: PCA9539 1 pins 0-15
+ *  - 16-31: PCA9539 2 pins 0-15
+ *  - 32-40: GPIO inputs, the last being the maintenance input
+ */
+struct InputSnapshot {
+  static constexpr size_t kInputCount = 41;
+  static constexpr size_t kGpioCount = kInputCount - 32;
+  using InputStates = std::bitset<kInputCount>;
+
+  /**
+   * Combine the states of the PCA9539 banks and the GPIO inputs
+   *
+   * \param bank_1 The 16-bit state of the first PCA9539
+   * \param bank_2 The 16-bit state of the second PCA9539
+   * \param gpios The GPIO input states, bit i being input index 32 + i
+   * \return The states of all inputs
+   */
+  static InputStates combine(uint16_t bank_1, uint16_t bank_2,
+                             uint16_t gpios);
+
+  /**
+   * Replace the states and mark the inputs that changed
+   *
+   * \param new_states The sampled states of all inputs
+   * \param now Time of the sample
+   * \return True if any input changed
+   */
+  bool update(const InputStates& new_states,
+              std::chrono::steady_clock::time_point now);
+
+  /// Current state of all inputs
+  InputStates states;
+  /// Inputs that changed since the previous snapshot
+  InputStates changed;
+  std::chrono::steady_clock::time_point sampled_at;
+};
+
+}  // namespace fixed
+}  // namespace tasks
+}  // namespace inamata
@@ -2,12 +2,9 @@
 #include <array>
 #include <bitset>
 
+#include "input_sampler.h"
 #include "managers/services.h"
 #include "peripheral/fixed.h"
-#include "peripheral/peripherals/digital_in/digital_in.h"
-#include "peripheral/peripherals/digital_out/digital_out.h"
-#include "peripheral/peripherals/neo_pixel/neo_pixel.h"
-#include "peripheral/peripherals/pca9536d/pca9536d.h"
 #include "peripheral/peripherals/pca9539/pca9539.h"
 #include "utils/uuid.h"
 
@@ -15,14 +12,17 @@ namespace inamata {
 namespace tasks {
 namespace fixed {
 
-constexpr size_t kInputCount = 40;
-
 class Telemetry : public BaseTask {
  public:
-  using DigitalIn = peripheral::peripherals::digital_in::DigitalIn;
+  using InputStates = InputSampler::InputStates;
   using PCA9539 = peripheral::peripherals::pca9539::PCA9539;
 
-  Telemetry(const ServiceGetters& services, Scheduler& scheduler);
+  /// The inputs sent as telemetry, all except the maintenance input
+  static constexpr size_t kTelemetryInputCount =
+      InputSampler::kInputCount - 1;
+
+  Telemetry(const ServiceGetters& services, Scheduler& scheduler,
+            InputSampler& input_sampler);
   virtual ~Telemetry() = default;
 
   const String& getType() const final;
@@ -32,25 +32,34 @@ class Telemetry : public BaseTask {
 
  private:
   /**
-   * Handle value from digital input
+   * Send the inputs that changed in the input sampler's snapshot
+   *
+   * \param snapshot The latest state of all inputs
+   */
+  void handleSnapshot(const InputSampler::Snapshot& snapshot);
+
+  /**
+   * Send the states of the inputs set in diff
    *
-   * \param value Measured input value
    * \param current_states Current state of all inputs
+   * \param diff The inputs to send
+   * \param is_change Whether the inputs changed or are periodically sent
    */
-  void saveResult(const utils::ValueUnit& value,
-                  std::bitset<kInputCount>& current_states);
+  void sendTelemetry(const InputStates& current_states,
+                     const InputStates& diff, const bool is_change);
 
-  void sendTelemetry(const std::bitset<kInputCount>& current_states,
-                     const std::bitset<kInputCount>& diff);
+  /**
+   * Set the telemetry time to when the bank's INT line flagged the change
+   *
+   * \param input_bank The PCA9539 bank whose inputs changed
+   * \param telemetry The telemetry message to set the time on
+   */
+  static void setChangeTimestamp(const PCA9539& input_bank,
+                                 JsonObject telemetry);
 
   std::shared_ptr<WebSocket> web_socket_;
 
-  std::shared_ptr<PCA9539> input_bank_1_;
-  std::shared_ptr<PCA9539> input_bank_2_;
-  std::array<std::shared_ptr<DigitalIn>, 8> input_bank_3_;
-
-  std::bitset<kInputCount> previous_states_;
-  static const std::array<const utils::UUID*, kInputCount> dpts_;
+  InputSampler& input_sampler_;
 
   std::chrono::steady_clock::time_point last_full_send_ =
       std::chrono::steady_clock::time_point::min();
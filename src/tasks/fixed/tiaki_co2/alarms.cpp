@@ -196,7 +196,7 @@ void Alarms::sendLimitEvent(const utils::UUID& limit_id,
 
   JsonDocument limit_event;
   if (Services::is_time_synced_) {
-    limit_event[WebSocket::time_key_] = utils::getIsoTimestamp();
+    utils::setTimestamp(limit_event[WebSocket::time_key_]);
   }
   limit_event[WebSocket::limit_id_key_] = limit_id.toString();
   limit_event[utils::ValueUnit::value_key] = value_unit.value;
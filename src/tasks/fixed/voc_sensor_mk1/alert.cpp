@@ -244,7 +244,7 @@ void Alert::sendLimitEvent(const utils::UUID& limit_id,
 
   JsonDocument limit_event;
   if (Services::is_time_synced_) {
-    limit_event[WebSocket::time_key_] = utils::getIsoTimestamp();
+    utils::setTimestamp(limit_event[WebSocket::time_key_]);
   }
   limit_event[limit_id_key_] = limit_id.toString();
   limit_event[utils::ValueUnit::value_key] = value_unit.value;
@@ -1,5 +1,7 @@
 #include "system_monitor.h"
 
+#include "peripheral/peripherals/modbus/modbus_client_adapter.h"
+
 namespace inamata {
 namespace tasks {
 namespace system_monitor {
@@ -123,6 +125,10 @@ bool SystemMonitor::TaskCallback() {
         mobile_nsm = "UNKNOWN";
     }
     doc_out["mobile_nsm"] = mobile_nsm;
+    doc_out["sms_sent"] = gsm_network->sms_stats_.sent;
+    doc_out["sms_failed"] = gsm_network->sms_stats_.failed;
+    doc_out["sms_retries"] = gsm_network->sms_stats_.retries;
+    doc_out["sms_queued"] = gsm_network->getQueuedSmsCount();
   }
 #endif
 
@@ -132,6 +138,20 @@ bool SystemMonitor::TaskCallback() {
     doc_out["wifi_rssi"] = WiFi.RSSI();
   }
 
+  // Add the Modbus error counters if a Modbus client is in use
+  using peripheral::peripherals::modbus::ModbusClientAdapter;
+  const ModbusClientAdapter::Stats& modbus_stats =
+      ModbusClientAdapter::getStats();
+  if (modbus_stats.requests) {
+    doc_out["modbus_requests"] = modbus_stats.requests;
+    doc_out["modbus_timeouts"] = modbus_stats.timeouts;
+    doc_out["modbus_crc_errors"] = modbus_stats.crc_errors;
+    doc_out["modbus_retries"] = modbus_stats.retries;
+  }
+
+  // Add the WebSocket message stats since the last report
+  web_socket_->addStats(doc_out.as<JsonObject>());
+
   web_socket_->sendSystem(doc_out.as<JsonObject>());
   return true;
 }
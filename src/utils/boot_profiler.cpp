@@ -0,0 +1,23 @@
+#include "utils/boot_profiler.h"
+
+namespace inamata {
+namespace utils {
+
+void BootProfiler::mark(const char* stage) {
+  stages_.push_back({stage, millis()});
+}
+
+void BootProfiler::addProfile(JsonObject data) {
+  JsonObject stages = data[F("boot_stages_ms")].to<JsonObject>();
+  uint32_t previous_ms = 0;
+  for (const Stage& stage : stages_) {
+    stages[stage.name] = stage.finished_ms - previous_ms;
+    previous_ms = stage.finished_ms;
+  }
+  data[F("boot_total_ms")] = previous_ms;
+}
+
+std::vector<BootProfiler::Stage> BootProfiler::stages_;
+
+}  // namespace utils
+}  // namespace inamata
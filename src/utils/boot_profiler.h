@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <vector>
+
+namespace inamata {
+namespace utils {
+
+/**
+ * Records when each boot stage finished to find slow initialization steps
+ *
+ * Stages are marked in the order they finish. The durations are reported
+ * once in the first system message after connecting to the server.
+ */
+class BootProfiler {
+ public:
+  /**
+   * Mark the end of a boot stage
+   *
+   * \param stage Name of the stage. Has to be a string literal
+   */
+  static void mark(const char* stage);
+
+  /**
+   * Add the duration of each stage and the total boot time
+   *
+   * \param data The JSON object to add the boot profile to
+   */
+  static void addProfile(JsonObject data);
+
+ private:
+  struct Stage {
+    const char* name;
+    uint32_t finished_ms;
+  };
+
+  static std::vector<Stage> stages_;
+};
+
+}  // namespace utils
+}  // namespace inamata
@@ -1,28 +1,44 @@
 #include "utils/chrono.h"
 
+#include "utils/iso_timestamp.h"
+
 namespace inamata {
 namespace utils {
 
-String getIsoTimestamp() {
+namespace {
+TimestampFormat timestamp_format = TimestampFormat::kIso;
+}  // namespace
+
+String getIsoTimestamp(std::chrono::microseconds age) {
+  static IsoTimestampFormatter formatter;
   struct timeval tv;
-  // 2025-07-07T12:31:45.123456Z needs 28 chars (incl. null terminator)
-  char buffer[28];
+  char buffer[IsoTimestampFormatter::kSize];
 
   // Get current time with microseconds in UTC
   gettimeofday(&tv, NULL);
+  if (age > std::chrono::microseconds::zero()) {
+    const int64_t time_us =
+        static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec - age.count();
+    tv.tv_sec = time_us / 1000000;
+    tv.tv_usec = time_us % 1000000;
+  }
+
+  formatter.format(tv.tv_sec, static_cast<long>(tv.tv_usec), buffer);
+  return buffer;
+}
 
-  // Convert seconds to struct tm in UTC
-  struct tm* tm_info = gmtime(&tv.tv_sec);
-
-  // Format time up to seconds using strftime (ISO 8601 format)
-  strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", tm_info);
-
-  // Append microseconds and 'Z' for UTC
-  const size_t length = strlen(buffer);
-  snprintf(buffer + length, sizeof(buffer) - length, ".%06ldZ", tv.tv_usec);
+int64_t getEpochMs(std::chrono::microseconds age) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return static_cast<int64_t>(tv.tv_sec) * 1000 + tv.tv_usec / 1000 -
+         std::chrono::duration_cast<std::chrono::milliseconds>(age).count();
+}
 
-  return buffer;
+void setTimestampFormat(const TimestampFormat format) {
+  timestamp_format = format;
 }
 
+TimestampFormat getTimestampFormat() { return timestamp_format; }
+
 }  // namespace utils
 }  // namespace inamata
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
 
 #include <chrono>
 
@@ -22,9 +23,55 @@ constexpr inline std::chrono::duration<Rep, Period> chrono_abs(
  * Check that the time has been synced in Services::is_time_synced_. Else the
  * time returned is undefined behavior.
  *
+ * \param age How long ago the event occurred. Subtracted from the current time
  * \return An ISO-8601 timestamp
  */
-String getIsoTimestamp();
+String getIsoTimestamp(
+    std::chrono::microseconds age = std::chrono::microseconds::zero());
+
+/// Format used for timestamps in messages to the server
+enum class TimestampFormat {
+  /// ISO-8601 string with microsecond precision
+  kIso,
+  /// Integer milliseconds since the Unix epoch
+  kEpochMs,
+};
+
+/**
+ * Returns the milliseconds since the Unix epoch
+ *
+ * Same as getIsoTimestamp(), the time has to be synced first.
+ *
+ * \param age How long ago the event occurred. Subtracted from the current time
+ * \return Milliseconds since 1970-01-01T00:00:00Z
+ */
+int64_t getEpochMs(
+    std::chrono::microseconds age = std::chrono::microseconds::zero());
+
+/**
+ * Select the format of the timestamps set by setTimestamp()
+ *
+ * \param format ISO-8601 string or epoch milliseconds
+ */
+void setTimestampFormat(const TimestampFormat format);
+TimestampFormat getTimestampFormat();
+
+/**
+ * Set the current time in the selected timestamp format
+ *
+ * \param timestamp JSON variant or member proxy to set the timestamp on
+ * \param age How long ago the event occurred. Subtracted from the current time
+ */
+template <typename TVariant>
+void setTimestamp(
+    TVariant timestamp,
+    std::chrono::microseconds age = std::chrono::microseconds::zero()) {
+  if (getTimestampFormat() == TimestampFormat::kEpochMs) {
+    timestamp = getEpochMs(age);
+  } else {
+    timestamp = getIsoTimestamp(age);
+  }
+}
 
 }  // namespace utils
 }  // namespace inamata
\ No newline at end of file
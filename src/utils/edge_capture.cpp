@@ -0,0 +1,149 @@
+#include "utils/edge_capture.h"
+
+#include <algorithm>
+
+namespace inamata {
+namespace utils {
+
+void EdgeCapture::begin(bool level, bool active_low, int64_t debounce_us,
+                        int64_t now_us) {
+  active_low_ = active_low;
+  debounce_us_ = debounce_us;
+  head_ = 0;
+  tail_ = 0;
+  dropped_edges_ = 0;
+  accepted_level_ = level;
+  candidate_seq_ = 0;
+  has_candidate_ = false;
+  level_ = level;
+  level_since_us_ = now_us;
+  last_change_us_ = -1;
+  activations_ = 0;
+  on_duration_us_ = 0;
+  applied_candidate_at_us_ = -1;
+  handled_dropped_edges_ = 0;
+}
+
+void IRAM_ATTR EdgeCapture::onChange(int64_t at_us, bool level) {
+  candidate_seq_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  // The pending change held until this one, so it is a valid edge
+  bool accepted_level = accepted_level_.load(std::memory_order_relaxed);
+  if (has_candidate_ && at_us - candidate_.at_us >= debounce_us_) {
+    push(candidate_);
+    accepted_level = candidate_.level;
+    accepted_level_.store(accepted_level, std::memory_order_relaxed);
+  }
+
+  // Returning to the accepted level within the debounce time drops the change
+  has_candidate_ = level != accepted_level;
+  candidate_ = {.at_us = at_us, .level = level};
+  if (has_candidate_ && debounce_us_ <= 0) {
+    push(candidate_);
+    accepted_level_.store(level, std::memory_order_relaxed);
+    has_candidate_ = false;
+  }
+
+  candidate_seq_.fetch_add(1, std::memory_order_release);
+}
+
+void IRAM_ATTR EdgeCapture::push(const Edge& edge) {
+  const uint8_t head = head_.load(std::memory_order_relaxed);
+  const uint8_t tail = tail_.load(std::memory_order_acquire);
+  // The free running indices wrap at 256, a multiple of the buffer size
+  if (uint8_t(head - tail) == kBufferSize) {
+    dropped_edges_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  edges_[head % kBufferSize] = edge;
+  head_.store(head + 1, std::memory_order_release);
+}
+
+void EdgeCapture::update(int64_t now_us) {
+  const uint8_t head = head_.load(std::memory_order_acquire);
+  uint8_t tail = tail_.load(std::memory_order_relaxed);
+  for (; tail != head; tail++) {
+    const Edge& edge = edges_[tail % kBufferSize];
+    // Skip the edge if it was already applied as a held candidate
+    if (edge.at_us == applied_candidate_at_us_) {
+      applied_candidate_at_us_ = -1;
+      continue;
+    }
+    apply(edge);
+  }
+  tail_.store(tail, std::memory_order_release);
+
+  // Lost edges leave the state unknown. Resync it to the accepted level
+  const uint32_t dropped_edges =
+      dropped_edges_.load(std::memory_order_relaxed);
+  if (dropped_edges != handled_dropped_edges_) {
+    handled_dropped_edges_ = dropped_edges;
+    applied_candidate_at_us_ = -1;
+    const bool level = accepted_level_.load(std::memory_order_relaxed);
+    if (level != level_) {
+      if (level_ != active_low_) {
+        on_duration_us_ += std::max<int64_t>(0, now_us - level_since_us_);
+      }
+      level_ = level;
+      level_since_us_ = now_us;
+    }
+    return;
+  }
+
+  // Read a consistent copy of the pending change
+  uint32_t seq;
+  bool has_candidate;
+  Edge candidate;
+  do {
+    seq = candidate_seq_.load(std::memory_order_acquire);
+    has_candidate = has_candidate_;
+    candidate = candidate_;
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) ||
+           seq != candidate_seq_.load(std::memory_order_relaxed));
+
+  // Without a further pin change the ISR can not confirm a held level
+  if (has_candidate && candidate.level != level_ &&
+      now_us - candidate.at_us >= debounce_us_) {
+    apply(candidate);
+    applied_candidate_at_us_ = candidate.at_us;
+  }
+}
+
+EdgeCapture::Interval EdgeCapture::takeInterval(int64_t now_us) {
+  if (isActive()) {
+    on_duration_us_ += std::max<int64_t>(0, now_us - level_since_us_);
+    level_since_us_ = now_us;
+  }
+  const Interval interval = {.activations = activations_,
+                             .on_duration_us = on_duration_us_};
+  activations_ = 0;
+  on_duration_us_ = 0;
+  return interval;
+}
+
+bool EdgeCapture::isActive() const { return level_ != active_low_; }
+
+int64_t EdgeCapture::getLastChange() const { return last_change_us_; }
+
+uint32_t EdgeCapture::getDroppedEdges() const {
+  return dropped_edges_.load(std::memory_order_relaxed);
+}
+
+void EdgeCapture::apply(const Edge& edge) {
+  if (edge.level == level_) {
+    return;
+  }
+  if (isActive()) {
+    on_duration_us_ += std::max<int64_t>(0, edge.at_us - level_since_us_);
+  } else {
+    activations_++;
+  }
+  level_ = edge.level;
+  level_since_us_ = edge.at_us;
+  last_change_us_ = edge.at_us;
+}
+
+}  // namespace utils
+}  // namespace inamata
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#else
+#define IRAM_ATTR
+#endif
+
+namespace inamata {
+namespace utils {
+
+/**
+ * Debounces and timestamps the edges of a digital input
+ *
+ * The ISR reports every pin change with onChange. A change is only accepted
+ * once the new level held for the debounce time, so pulses shorter than it are
+ * rejected. Accepted edges are passed to the task through a single-producer,
+ * single-consumer lock-free ring buffer and evaluated by update.
+ *
+ * A level is confirmed by the ISR on the next pin change. If the pin does not
+ * change again, update confirms it as soon as it held for the debounce time.
+ */
+class EdgeCapture {
+ public:
+  /// Statistics collected since the last call to takeInterval
+  struct Interval {
+    /// Number of changes from inactive to active
+    uint32_t activations;
+    /// Time spent in the active state
+    int64_t on_duration_us;
+  };
+
+  /// Number of accepted edges buffered between the ISR and the task
+  static constexpr size_t kBufferSize = 64;
+
+  /**
+   * Reset the state before attaching the ISR
+   *
+   * \param level The current raw pin level
+   * \param active_low Whether the low level is the active state
+   * \param debounce_us Min time a level has to hold to be accepted
+   * \param now_us The current time
+   */
+  void begin(bool level, bool active_low, int64_t debounce_us, int64_t now_us);
+
+  /**
+   * Report a pin change. Called from the ISR
+   *
+   * \param at_us Time of the change
+   * \param level The raw pin level after the change
+   */
+  void IRAM_ATTR onChange(int64_t at_us, bool level);
+
+  /**
+   * Evaluate the buffered edges. Called from the task
+   *
+   * \param now_us The current time
+   */
+  void update(int64_t now_us);
+
+  /**
+   * Get and clear the statistics of the interval
+   *
+   * An ongoing activation is counted up to now and continues in the next
+   * interval.
+   *
+   * \param now_us The current time
+   * \return The activations and active time since the last call
+   */
+  Interval takeInterval(int64_t now_us);
+
+  /// Whether the debounced input is active
+  bool isActive() const;
+
+  /// Time of the last debounced change, negative if none
+  int64_t getLastChange() const;
+
+  /// Number of edges lost as the buffer was full
+  uint32_t getDroppedEdges() const;
+
+ private:
+  struct Edge {
+    int64_t at_us;
+    bool level;
+  };
+
+  /**
+   * Push an accepted edge or count it as dropped if the buffer is full
+   *
+   * \param edge The accepted edge
+   */
+  void IRAM_ATTR push(const Edge& edge);
+
+  /**
+   * Apply a debounced edge to the statistics
+   *
+   * \param edge The accepted edge
+   */
+  void apply(const Edge& edge);
+
+  bool active_low_ = false;
+  int64_t debounce_us_ = 0;
+
+  /// Accepted edges. The ISR writes at the head and the task reads the tail
+  std::array<Edge, kBufferSize> edges_;
+  std::atomic<uint8_t> head_{0};
+  std::atomic<uint8_t> tail_{0};
+  std::atomic<uint32_t> dropped_edges_{0};
+
+  /// ISR state: the level of the last accepted edge
+  std::atomic<bool> accepted_level_{false};
+  /// ISR state: a change waiting to hold for the debounce time. Guarded by a
+  /// sequence lock that is odd while the ISR writes it
+  std::atomic<uint32_t> candidate_seq_{0};
+  bool has_candidate_ = false;
+  Edge candidate_ = {};
+
+  /// Task state
+  bool level_ = false;
+  int64_t level_since_us_ = 0;
+  int64_t last_change_us_ = -1;
+  uint32_t activations_ = 0;
+  int64_t on_duration_us_ = 0;
+  /// A held candidate applied before the ISR accepted it
+  int64_t applied_candidate_at_us_ = -1;
+  uint32_t handled_dropped_edges_ = 0;
+};
+
+}  // namespace utils
+}  // namespace inamata
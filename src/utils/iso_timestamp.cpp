@@ -0,0 +1,24 @@
+#include "utils/iso_timestamp.h"
+
+#include <cstdio>
+
+namespace inamata {
+namespace utils {
+
+void IsoTimestampFormatter::format(time_t seconds, long microseconds,
+                                   char (&buffer)[kSize]) {
+  // Format time up to seconds using strftime (ISO 8601 format) on change
+  if (seconds != cached_second_) {
+    cached_second_ = seconds;
+    struct tm tm_info;
+    gmtime_r(&seconds, &tm_info);
+    strftime(cached_base_, sizeof(cached_base_), "%Y-%m-%dT%H:%M:%S",
+             &tm_info);
+  }
+
+  // Append microseconds and 'Z' for UTC
+  snprintf(buffer, kSize, "%s.%06ldZ", cached_base_, microseconds);
+}
+
+}  // namespace utils
+}  // namespace inamata
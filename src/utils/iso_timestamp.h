@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+
+namespace inamata {
+namespace utils {
+
+/**
+ * Formats ISO-8601 timestamps with microsecond precision
+ *
+ * Date and time up to seconds only change once per second. They are cached to
+ * avoid calling gmtime and strftime for every timestamp.
+ */
+class IsoTimestampFormatter {
+ public:
+  /// 2025-07-07T12:31:45.123456Z needs 28 chars (incl. null terminator)
+  static constexpr size_t kSize = 28;
+
+  /**
+   * Format a UTC time
+   *
+   * \param seconds Seconds since the Unix epoch
+   * \param microseconds Microseconds within the second
+   * \param buffer Set to the null-terminated timestamp
+   */
+  void format(time_t seconds, long microseconds, char (&buffer)[kSize]);
+
+ private:
+  time_t cached_second_ = -1;
+  /// 2025-07-07T12:31:45 needs 20 chars (incl. null terminator)
+  char cached_base_[20];
+};
+
+}  // namespace utils
+}  // namespace inamata
@@ -0,0 +1,55 @@
+#include "utils/latency_histogram.h"
+
+#include <cmath>
+
+namespace inamata {
+namespace utils {
+
+constexpr std::array<uint32_t, 12> LatencyHistogram::kBucketBoundsMs_;
+
+void LatencyHistogram::add(std::chrono::steady_clock::duration duration) {
+  const auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  if (duration_us > max_) {
+    max_ = duration_us;
+  }
+
+  // Find the first bucket whose upper bound includes the duration
+  size_t index = 0;
+  while (index < kBucketBoundsMs_.size() &&
+         duration_us > std::chrono::milliseconds(kBucketBoundsMs_[index])) {
+    index++;
+  }
+  buckets_[index]++;
+  count_++;
+}
+
+std::chrono::milliseconds LatencyHistogram::getPercentile(
+    float percentile) const {
+  if (count_ == 0) {
+    return std::chrono::milliseconds::zero();
+  }
+  const uint32_t rank = std::ceil(count_ * percentile / 100.0f);
+  uint32_t seen = 0;
+  for (size_t i = 0; i < kBucketBoundsMs_.size(); i++) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::chrono::milliseconds(kBucketBoundsMs_[i]);
+    }
+  }
+  // Falls into the unbounded bucket, the max is the best estimate
+  return std::chrono::duration_cast<std::chrono::milliseconds>(max_);
+}
+
+std::chrono::microseconds LatencyHistogram::getMax() const { return max_; }
+
+uint32_t LatencyHistogram::getCount() const { return count_; }
+
+void LatencyHistogram::reset() {
+  buckets_.fill(0);
+  count_ = 0;
+  max_ = std::chrono::microseconds::zero();
+}
+
+}  // namespace utils
+}  // namespace inamata
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace inamata {
+namespace utils {
+
+/**
+ * Fixed-size histogram of durations to estimate percentiles
+ *
+ * Durations are sorted into logarithmically spaced buckets. Percentiles are
+ * returned as the upper bound of the bucket they fall into, which is exact
+ * enough for health reporting while using constant memory.
+ */
+class LatencyHistogram {
+ public:
+  /**
+   * Add a duration to the histogram
+   *
+   * \param duration The measured duration
+   */
+  void add(std::chrono::steady_clock::duration duration);
+
+  /**
+   * Estimate a percentile of the recorded durations
+   *
+   * \param percentile Value between 0 and 100
+   * \return Upper bound of the percentile's bucket, zero if empty
+   */
+  std::chrono::milliseconds getPercentile(float percentile) const;
+
+  /**
+   * The longest recorded duration
+   *
+   * \return Longest duration since the last reset
+   */
+  std::chrono::microseconds getMax() const;
+
+  /**
+   * The number of recorded durations
+   *
+   * \return Count since the last reset
+   */
+  uint32_t getCount() const;
+
+  /**
+   * Clear all recorded durations
+   */
+  void reset();
+
+ private:
+  /// Upper bounds of the buckets in milliseconds. Last bucket is unbounded
+  static constexpr std::array<uint32_t, 12> kBucketBoundsMs_{
+      1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+
+  std::array<uint32_t, kBucketBoundsMs_.size() + 1> buckets_{};
+  uint32_t count_ = 0;
+  std::chrono::microseconds max_{0};
+};
+
+}  // namespace utils
+}  // namespace inamata
@@ -8,6 +8,7 @@
 #include "tasks/connectivity/connectivity.h"
 #include "tasks/fixed/config.h"
 #include "tasks/system_monitor/system_monitor.h"
+#include "utils/boot_profiler.h"
 
 namespace inamata {
 
@@ -78,6 +79,10 @@ bool loadWebsocket(Services& services, JsonObjectConst secrets) {
       .ws_url_path = ws_url_path.as<const char*>(),
       .ws_token = ws_token.as<const char*>(),
       .secure_url = secure_url};
+#ifdef RTC_MANAGER
+  config.log_export_callback = std::bind(
+      &LogExporter::handleCallback, &services.getLogExporter(), _1);
+#endif
   services.setWebSocket(std::make_shared<WebSocket>(config));
   return true;
 }
@@ -109,15 +114,21 @@ bool createSystemTasks(Services& services) {
 }
 
 bool loadLocalPeripherals(Services& services) {
+  std::shared_ptr<Storage> storage = services.getStorage();
+
+  // Prefer the snapshot of the last validated configs over the JSON records
   JsonDocument peripheral_doc;
-  ErrorResult error = services.getStorage()->loadPeripherals(peripheral_doc);
-  if (error.isError()) {
-    services.getStorage()->deletePeripherals();
-    // services.getStorage()->deleteTasks();
-    // services.getStorage()->deleteLacs();
+  const bool from_snapshot = storage->loadPeripheralSnapshot(peripheral_doc);
+  if (!from_snapshot) {
+    ErrorResult error = storage->loadPeripherals(peripheral_doc);
+    if (error.isError()) {
+      storage->deletePeripherals();
+      // storage->deleteTasks();
+      // storage->deleteLacs();
 
-    // Return true avoids boot loop, but delete stored peris, tasks and LACs
-    return true;
+      // Return true avoids boot loop, but delete stored peris, tasks and LACs
+      return true;
+    }
   }
 
   JsonArray peripherals = peripheral_doc.isNull()
@@ -131,18 +142,51 @@ bool loadLocalPeripherals(Services& services) {
     if (error.isError()) {
       // TODO: Save error and send to server
       Serial.println(error.toString());
-      services.getStorage()->deletePeripherals();
-      // services.getStorage()->deleteTasks();
-      // services.getStorage()->deleteLacs();
+      storage->deletePeripherals();
+      // storage->deleteTasks();
+      // storage->deleteLacs();
 
       // Return false to reboot after stored peris, tasks and LACs are deleted
       return false;
     }
   }
+
+  if (!from_snapshot) {
+    ErrorResult error = storage->storePeripheralSnapshot(peripherals);
+    if (error.isError()) {
+      TRACELN(error.toString());
+    }
+  }
+  return true;
+}
+
+bool addFixedPeripherals(Services& services, JsonArrayConst peripherals) {
+  for (JsonVariantConst peripheral : peripherals) {
+    ErrorResult error = services.getPeripheralController().add(peripheral);
+    if (error.isError()) {
+      TRACEF("Init fixed peri fail: %s\r\n", error.toString().c_str());
+      TRACEJSON(peripheral);
+      return false;
+    }
+  }
   return true;
 }
 
 bool loadFixedPeripherals(Services& services) {
+  std::shared_ptr<Storage> storage = services.getStorage();
+
+  // Use the snapshot to skip parsing the fixed JSON configs
+  JsonDocument snapshot_doc;
+  if (storage->loadPeripheralSnapshot(snapshot_doc)) {
+    if (addFixedPeripherals(services, snapshot_doc.as<JsonArrayConst>())) {
+      return true;
+    }
+    TRACELN("Fixed peri snapshot fail");
+    services.getPeripheralController().peripherals_.clear();
+    storage->deletePeripheralSnapshot();
+  }
+
+  JsonArray snapshot = snapshot_doc.to<JsonArray>();
   JsonDocument peripherals_doc;
   for (auto config : peripheral::fixed::configs) {
     if (!config) {
@@ -153,47 +197,77 @@ bool loadFixedPeripherals(Services& services) {
       TRACEF("Fixed peri JSON fail: %s\r\n", error.c_str());
       return false;
     }
-    for (auto peripheral : peripherals_doc.as<JsonArray>()) {
-      ErrorResult error = services.getPeripheralController().add(peripheral);
-      if (error.isError()) {
-        TRACEF("Init fixed peri fail: %s\r\n", error.toString().c_str());
-        TRACEJSON(peripheral);
-        return false;
-      }
+    JsonArrayConst peripherals = peripherals_doc.as<JsonArrayConst>();
+    if (!addFixedPeripherals(services, peripherals)) {
+      return false;
+    }
+    for (JsonVariantConst peripheral : peripherals) {
+      snapshot.add(peripheral);
     }
   }
 
+  ErrorResult error = storage->storePeripheralSnapshot(snapshot);
+  if (error.isError()) {
+    TRACELN(error.toString());
+  }
   return true;
 }
 
-bool setupNode(Services& services) {
+void setupSerial() {
   // Enable serial communication and prints
   Serial.begin(115200);
-  delay(2000);
+#if defined(ENABLE_TRACE) && defined(ARDUINO_USB_CDC_ON_BOOT) && \
+    ARDUINO_USB_CDC_ON_BOOT
+  // Debug builds wait for an attached USB serial monitor to not lose the
+  // boot logs. Release builds boot without waiting
+  const auto start = std::chrono::steady_clock::now();
+  while (!Serial &&
+         std::chrono::steady_clock::now() - start < kSerialConnectTimeout) {
+    delay(10);
+  }
+#endif
   Serial.print("Fimware version: ");
   Serial.println(WebSocket::firmware_version_);
+}
 
+bool setupServices(Services& services) {
   // Load and start subsystems that need secrets
   services.setStorage(std::make_shared<Storage>());
   services.getStorage()->openFS();
-  bool success;
-  {
-    JsonDocument secrets_doc;
-    services.getStorage()->loadSecrets(secrets_doc);
-    JsonObject secrets = secrets_doc.isNull() ? secrets_doc.to<JsonObject>()
-                                              : secrets_doc.as<JsonObject>();
-    success = loadNetwork(services, secrets);
-    if (!success) {
-      return false;
-    }
-    success = loadWebsocket(services, secrets);
-    if (!success) {
-      return false;
-    }
+  utils::BootProfiler::mark("storage");
+
+  JsonDocument secrets_doc;
+  services.getStorage()->loadSecrets(secrets_doc);
+  JsonObject secrets = secrets_doc.isNull() ? secrets_doc.to<JsonObject>()
+                                            : secrets_doc.as<JsonObject>();
+  bool success = loadNetwork(services, secrets);
+  if (!success) {
+    return false;
+  }
+  success = loadWebsocket(services, secrets);
+  if (!success) {
+    return false;
   }
 
   // Create the BLE server
   services.setBleServer(std::make_shared<BleServer>());
+  utils::BootProfiler::mark("services");
+  return true;
+}
+
+void startNetworkConnect(Services& services) {
+#ifndef GSM_NETWORK
+  // Start connecting to the last WiFi AP to let it associate while the
+  // peripherals and tasks are initialized. GSM devices select the network
+  // with a peripheral and start connecting in the connectivity task
+  if (services.getWebSocket()->isWsTokenSet()) {
+    services.getWifiNetwork()->connect();
+  }
+#endif
+}
+
+bool setupPeripherals(Services& services) {
+  bool success;
   if (peripheral::fixed::configs[0] != nullptr) {
     success = loadFixedPeripherals(services);
   } else {
@@ -206,7 +280,11 @@ bool setupNode(Services& services) {
 #ifdef RTC_MANAGER
   TimeManager::initRTC();
 #endif
+  utils::BootProfiler::mark("peripherals");
+  return true;
+}
 
+void setupLocalTasks(Services& services) {
 #ifdef CONFIGURATION_MANAGER
   services.setLoggingManager(std::make_shared<LoggingManager>());
   services.setConfigManager(std::make_shared<ConfigManager>());
@@ -229,11 +307,33 @@ bool setupNode(Services& services) {
     tasks::fixed::startFixedTasks(services.getGetters(),
                                   services.getScheduler(), behavior_config);
   }
+  utils::BootProfiler::mark("local_tasks");
+}
+
+bool setupNode(Services& services) {
+  setupSerial();
+  utils::BootProfiler::mark("serial");
+
+  bool success = setupServices(services);
+  if (!success) {
+    return false;
+  }
+
+  // Peripherals and local tasks do not depend on the network connection
+  startNetworkConnect(services);
+
+  success = setupPeripherals(services);
+  if (!success) {
+    return false;
+  }
+
+  setupLocalTasks(services);
 
   success = createSystemTasks(services);
   if (!success) {
     return false;
   }
+  utils::BootProfiler::mark("system_tasks");
 
   return true;
 }
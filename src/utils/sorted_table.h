@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace inamata {
+namespace utils {
+
+/**
+ * Lookup table sorted by its keys for binary searches
+ *
+ * Built once from unsorted entries. Keys are compared with operator< and
+ * operator==.
+ */
+template <typename Key, typename Value>
+class SortedTable {
+ public:
+  using Entry = std::pair<Key, Value>;
+
+  SortedTable() = default;
+
+  /**
+   * Sort the entries by their keys
+   *
+   * \param entries The key and value pairs. Keys have to be unique
+   */
+  SortedTable(std::initializer_list<Entry> entries) : entries_(entries) {
+    std::sort(entries_.begin(), entries_.end(),
+              [](const Entry& a, const Entry& b) { return a.first < b.first; });
+  }
+
+  /**
+   * Find the value of a key
+   *
+   * \param key The key to search for
+   * \return The value or nullptr if the key is not in the table
+   */
+  const Value* find(const Key& key) const {
+    const auto it = std::lower_bound(
+        entries_.begin(), entries_.end(), key,
+        [](const Entry& entry, const Key& key) { return entry.first < key; });
+    if (it == entries_.end() || !(it->first == key)) {
+      return nullptr;
+    }
+    return &it->second;
+  }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  std::vector<Entry> entries_;
+};
+
+}  // namespace utils
+}  // namespace inamata
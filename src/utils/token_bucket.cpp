@@ -0,0 +1,38 @@
+#include "utils/token_bucket.h"
+
+#include <algorithm>
+
+namespace inamata {
+namespace utils {
+
+TokenBucket::TokenBucket(float rate, float capacity)
+    : rate_(rate), capacity_(capacity), tokens_(capacity) {}
+
+void TokenBucket::configure(float rate, float capacity) {
+  rate_ = rate;
+  capacity_ = capacity;
+  tokens_ = capacity;
+  last_refill_ = Clock::time_point::min();
+}
+
+bool TokenBucket::hasTokens(float tokens, Clock::time_point now) {
+  refill(now);
+  return tokens_ >= std::min(tokens, capacity_);
+}
+
+void TokenBucket::consume(float tokens) { tokens_ -= tokens; }
+
+float TokenBucket::getTokens() const { return tokens_; }
+
+void TokenBucket::refill(Clock::time_point now) {
+  if (last_refill_ == Clock::time_point::min() || now < last_refill_) {
+    last_refill_ = now;
+    return;
+  }
+  const std::chrono::duration<float> elapsed = now - last_refill_;
+  last_refill_ = now;
+  tokens_ = std::min(capacity_, tokens_ + elapsed.count() * rate_);
+}
+
+}  // namespace utils
+}  // namespace inamata
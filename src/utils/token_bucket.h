@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+
+namespace inamata {
+namespace utils {
+
+/**
+ * Token bucket to limit the average rate and burst size of an operation
+ *
+ * Tokens refill at a constant rate up to the capacity. Consuming more tokens
+ * than available puts the bucket into debt, which has to be repaid before
+ * tokens are available again. This keeps the long-term rate exact even for
+ * requests larger than the capacity.
+ */
+class TokenBucket {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Create a full token bucket
+   *
+   * \param rate Tokens added per second
+   * \param capacity Maximum number of tokens (burst size)
+   */
+  TokenBucket(float rate = 0, float capacity = 0);
+
+  /**
+   * Change the rate and capacity and refill the bucket
+   *
+   * \param rate Tokens added per second
+   * \param capacity Maximum number of tokens (burst size)
+   */
+  void configure(float rate, float capacity);
+
+  /**
+   * Whether the requested tokens can be consumed
+   *
+   * Requests larger than the capacity are allowed once the bucket is full.
+   *
+   * \param tokens Number of tokens to be consumed
+   * \param now The current time to refill the bucket
+   * \return True if enough tokens are available
+   */
+  bool hasTokens(float tokens, Clock::time_point now = Clock::now());
+
+  /**
+   * Remove tokens from the bucket, may leave it in debt
+   *
+   * \param tokens Number of tokens to remove
+   */
+  void consume(float tokens);
+
+  /**
+   * The currently available tokens, negative if in debt
+   *
+   * \return Available tokens after the last refill
+   */
+  float getTokens() const;
+
+ private:
+  void refill(Clock::time_point now);
+
+  float rate_;
+  float capacity_;
+  float tokens_;
+  Clock::time_point last_refill_ = Clock::time_point::min();
+};
+
+}  // namespace utils
+}  // namespace inamata
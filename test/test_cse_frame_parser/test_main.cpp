@@ -0,0 +1,149 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "peripheral/peripherals/cse_frame_parser.h"
+
+using inamata::peripheral::peripherals::CseFrameParser;
+
+namespace {
+
+/// Frames as sent by a CSE7766 with a calibrated load, checksums set by
+/// makeFrame
+const uint8_t kRecordedFrames[][CseFrameParser::kFrameSize] = {
+    {0x55, 0x5A, 0x02, 0xE9, 0x50, 0x00, 0x03, 0x31, 0x00, 0x3E, 0x9E, 0x00,
+     0x3D, 0x43, 0x4C, 0x5C, 0x7A, 0x3C, 0x71, 0x00, 0x1F, 0x40, 0x33, 0x00},
+    {0x55, 0x5A, 0x02, 0xE9, 0x50, 0x00, 0x03, 0x30, 0x00, 0x3E, 0x9E, 0x00,
+     0x3D, 0x47, 0x4C, 0x5C, 0x7A, 0x3C, 0x69, 0x71, 0x1F, 0x40, 0x34, 0x00},
+    {0xF2, 0x5A, 0x02, 0xE9, 0x50, 0x00, 0x03, 0x2F, 0x00, 0x3E, 0x9E, 0x00,
+     0x3D, 0x4C, 0x4C, 0x5C, 0x7A, 0x3C, 0x62, 0x71, 0x1F, 0x40, 0x35, 0x00},
+};
+constexpr size_t kRecordedFrameCount =
+    sizeof(kRecordedFrames) / sizeof(kRecordedFrames[0]);
+
+std::vector<uint8_t> makeFrame(const uint8_t (&data)[24]) {
+  std::vector<uint8_t> frame(data, data + CseFrameParser::kFrameSize);
+  uint8_t checksum = 0;
+  for (size_t i = 2; i < CseFrameParser::kFrameSize - 1; i++) {
+    checksum += frame[i];
+  }
+  frame.back() = checksum;
+  return frame;
+}
+
+std::vector<uint8_t> makeStream(size_t repetitions) {
+  std::vector<uint8_t> stream;
+  for (size_t r = 0; r < repetitions; r++) {
+    for (const auto& data : kRecordedFrames) {
+      const std::vector<uint8_t> frame = makeFrame(data);
+      stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+  }
+  return stream;
+}
+
+/// Parse the stream in random chunks as received by the UART
+size_t parseInChunks(CseFrameParser& parser,
+                     const std::vector<uint8_t>& stream) {
+  size_t frame_count = 0;
+  size_t offset = 0;
+  while (offset < stream.size()) {
+    const size_t size =
+        std::min<size_t>(std::rand() % 40 + 1, stream.size() - offset);
+    frame_count += parser.parse(stream.data() + offset, size);
+    offset += size;
+  }
+  return frame_count;
+}
+
+}  // namespace
+
+void setUp() { std::srand(42); }
+
+void tearDown() {}
+
+void test_parses_frames_split_into_chunks() {
+  for (size_t run = 0; run < 20; run++) {
+    CseFrameParser parser;
+    const std::vector<uint8_t> stream = makeStream(10);
+    TEST_ASSERT_EQUAL(10 * kRecordedFrameCount, parseInChunks(parser, stream));
+    TEST_ASSERT_TRUE(parser.hasFrame());
+    const std::vector<uint8_t> last =
+        makeFrame(kRecordedFrames[kRecordedFrameCount - 1]);
+    TEST_ASSERT_EQUAL_MEMORY(last.data(), parser.getFrame(),
+                             CseFrameParser::kFrameSize);
+  }
+}
+
+void test_no_frame_before_first_valid_frame() {
+  CseFrameParser parser;
+  const std::vector<uint8_t> frame = makeFrame(kRecordedFrames[0]);
+  TEST_ASSERT_EQUAL(0, parser.parse(frame.data(), frame.size() - 1));
+  TEST_ASSERT_FALSE(parser.hasFrame());
+  TEST_ASSERT_EQUAL(1, parser.parse(&frame.back(), 1));
+  TEST_ASSERT_TRUE(parser.hasFrame());
+}
+
+void test_syncs_after_garbage() {
+  CseFrameParser parser;
+  // Starts mid-frame and includes a header byte without the second header
+  std::vector<uint8_t> stream = {0x12, 0x55, 0x00, 0x3E, 0xAA, 0x9E, 0x55};
+  const std::vector<uint8_t> frames = makeStream(2);
+  stream.insert(stream.end(), frames.begin(), frames.end());
+  TEST_ASSERT_EQUAL(2 * kRecordedFrameCount, parseInChunks(parser, stream));
+}
+
+void test_resyncs_within_corrupted_frame() {
+  CseFrameParser parser;
+  // A truncated frame is followed directly by a valid one. The truncated
+  // frame consumes the start of the valid one and fails its checksum
+  std::vector<uint8_t> stream = makeFrame(kRecordedFrames[0]);
+  stream.resize(10);
+  const std::vector<uint8_t> frames = makeStream(1);
+  stream.insert(stream.end(), frames.begin(), frames.end());
+  TEST_ASSERT_EQUAL(kRecordedFrameCount, parseInChunks(parser, stream));
+}
+
+void test_drops_frame_with_invalid_checksum() {
+  CseFrameParser parser;
+  std::vector<uint8_t> stream = makeStream(1);
+  // Flip a data bit of the second frame
+  stream[CseFrameParser::kFrameSize + 8] ^= 0x01;
+  TEST_ASSERT_EQUAL(kRecordedFrameCount - 1, parseInChunks(parser, stream));
+  const std::vector<uint8_t> last =
+      makeFrame(kRecordedFrames[kRecordedFrameCount - 1]);
+  TEST_ASSERT_EQUAL_MEMORY(last.data(), parser.getFrame(),
+                           CseFrameParser::kFrameSize);
+}
+
+void test_parses_big_endian_values() {
+  const uint8_t data[] = {0x02, 0xE9, 0x50};
+  TEST_ASSERT_EQUAL_UINT32(0x02E950, CseFrameParser::parse24bit(data));
+  TEST_ASSERT_EQUAL_UINT32(0x02E9, CseFrameParser::parse16bit(data));
+}
+
+void test_parses_buffered_backlog_quickly() {
+  // The UART buffer holds about 5 s of frames when polled infrequently
+  CseFrameParser parser;
+  const std::vector<uint8_t> stream = makeStream(100);
+  const auto start = std::chrono::steady_clock::now();
+  const size_t frame_count = parser.parse(stream.data(), stream.size());
+  const auto duration = std::chrono::steady_clock::now() - start;
+  TEST_ASSERT_EQUAL(100 * kRecordedFrameCount, frame_count);
+  TEST_ASSERT_TRUE(duration < std::chrono::milliseconds(1));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_parses_frames_split_into_chunks);
+  RUN_TEST(test_no_frame_before_first_valid_frame);
+  RUN_TEST(test_syncs_after_garbage);
+  RUN_TEST(test_resyncs_within_corrupted_frame);
+  RUN_TEST(test_drops_frame_with_invalid_checksum);
+  RUN_TEST(test_parses_big_endian_values);
+  RUN_TEST(test_parses_buffered_backlog_quickly);
+  return UNITY_END();
+}
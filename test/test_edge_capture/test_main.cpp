@@ -0,0 +1,124 @@
+#include <unity.h>
+
+#include "utils/edge_capture.h"
+
+using inamata::utils::EdgeCapture;
+
+namespace {
+
+constexpr int64_t kDebounceUs = 1000;
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_counts_debounced_activations() {
+  EdgeCapture capture;
+  capture.begin(false, false, kDebounceUs, 0);
+  capture.onChange(10000, true);
+  capture.onChange(20000, false);
+  capture.onChange(30000, true);
+  capture.onChange(35000, false);
+  capture.update(40000);
+  TEST_ASSERT_FALSE(capture.isActive());
+  TEST_ASSERT_EQUAL(35000, capture.getLastChange());
+  const EdgeCapture::Interval interval = capture.takeInterval(40000);
+  TEST_ASSERT_EQUAL_UINT32(2, interval.activations);
+  TEST_ASSERT_EQUAL(15000, interval.on_duration_us);
+}
+
+void test_rejects_short_pulses() {
+  EdgeCapture capture;
+  capture.begin(false, false, kDebounceUs, 0);
+  capture.onChange(10000, true);
+  capture.onChange(10500, false);
+  capture.update(20000);
+  TEST_ASSERT_FALSE(capture.isActive());
+  TEST_ASSERT_EQUAL_UINT32(0, capture.takeInterval(20000).activations);
+}
+
+void test_confirms_held_level_without_further_change() {
+  EdgeCapture capture;
+  capture.begin(false, false, kDebounceUs, 0);
+  capture.onChange(10000, true);
+  capture.update(10500);
+  TEST_ASSERT_FALSE(capture.isActive());
+  capture.update(11000);
+  TEST_ASSERT_TRUE(capture.isActive());
+  // The later ISR confirmation of the same edge is not counted twice
+  capture.onChange(20000, false);
+  capture.update(30000);
+  const EdgeCapture::Interval interval = capture.takeInterval(30000);
+  TEST_ASSERT_EQUAL_UINT32(1, interval.activations);
+  TEST_ASSERT_EQUAL(10000, interval.on_duration_us);
+}
+
+void test_splits_ongoing_activation_between_intervals() {
+  EdgeCapture capture;
+  capture.begin(true, false, kDebounceUs, 0);
+  TEST_ASSERT_TRUE(capture.isActive());
+  capture.update(5000);
+  TEST_ASSERT_EQUAL(5000, capture.takeInterval(5000).on_duration_us);
+  capture.onChange(8000, false);
+  capture.update(10000);
+  TEST_ASSERT_EQUAL(3000, capture.takeInterval(10000).on_duration_us);
+}
+
+void test_active_low() {
+  EdgeCapture capture;
+  capture.begin(true, true, kDebounceUs, 0);
+  TEST_ASSERT_FALSE(capture.isActive());
+  capture.onChange(10000, false);
+  capture.onChange(12000, true);
+  capture.update(20000);
+  const EdgeCapture::Interval interval = capture.takeInterval(20000);
+  TEST_ASSERT_EQUAL_UINT32(1, interval.activations);
+  TEST_ASSERT_EQUAL(2000, interval.on_duration_us);
+}
+
+void test_counts_dropped_edges_and_resyncs() {
+  EdgeCapture capture;
+  capture.begin(false, false, 0, 0);
+  // Without debouncing every change is an edge. Overflow the ring buffer
+  const size_t changes = EdgeCapture::kBufferSize + 11;
+  for (size_t i = 0; i < changes; i++) {
+    capture.onChange((i + 1) * 100, i % 2 == 0);
+  }
+  TEST_ASSERT_EQUAL_UINT32(changes - EdgeCapture::kBufferSize,
+                           capture.getDroppedEdges());
+  capture.update(100000);
+  // The last change was to the active level
+  TEST_ASSERT_TRUE(capture.isActive());
+}
+
+void test_ring_buffer_wraps() {
+  EdgeCapture capture;
+  capture.begin(false, false, 0, 0);
+  uint32_t activations = 0;
+  int64_t now_us = 0;
+  // The free running indices wrap several times
+  for (int round = 0; round < 20; round++) {
+    for (size_t i = 0; i < EdgeCapture::kBufferSize; i++) {
+      now_us += 100;
+      capture.onChange(now_us, i % 2 == 0);
+    }
+    capture.update(now_us);
+    activations += capture.takeInterval(now_us).activations;
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, capture.getDroppedEdges());
+  TEST_ASSERT_EQUAL_UINT32(20 * EdgeCapture::kBufferSize / 2, activations);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_counts_debounced_activations);
+  RUN_TEST(test_rejects_short_pulses);
+  RUN_TEST(test_confirms_held_level_without_further_change);
+  RUN_TEST(test_splits_ongoing_activation_between_intervals);
+  RUN_TEST(test_active_low);
+  RUN_TEST(test_counts_dropped_edges_and_resyncs);
+  RUN_TEST(test_ring_buffer_wraps);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "peripheral/peripherals/energy_integration.h"
+
+using inamata::peripheral::peripherals::EnergyAccumulator;
+using inamata::peripheral::peripherals::PulseEnergy;
+using inamata::peripheral::peripherals::TrapezoidEnergy;
+using std::chrono::milliseconds;
+
+namespace {
+
+using TimePoint = std::chrono::steady_clock::time_point;
+const TimePoint kStart = TimePoint() + std::chrono::hours(1);
+
+/// Typical power coefficient of a calibrated CSE7766
+constexpr uint32_t kPowerCoef = 5000000;
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_accumulator_carries_fractions() {
+  EnergyAccumulator energy;
+  for (int i = 0; i < 1000000; i++) {
+    energy.add(0.3);
+  }
+  // 300000 mJ counted in whole mJ without losing the fractions
+  TEST_ASSERT_INT_WITHIN(1, 300000, energy.getMj());
+  TEST_ASSERT_FLOAT_WITHIN(1e-9, 300000 / 3.6e9, energy.getKwh());
+}
+
+void test_accumulator_ignores_negative_energy() {
+  EnergyAccumulator energy;
+  energy.setMj(3600000000ull);
+  TEST_ASSERT_FALSE(energy.add(-500));
+  TEST_ASSERT_FALSE(energy.add(0));
+  TEST_ASSERT_FALSE(energy.add(NAN));
+  TEST_ASSERT_EQUAL_FLOAT(1.0, energy.getKwh());
+  TEST_ASSERT_TRUE(energy.add(1.5));
+  TEST_ASSERT_EQUAL(3600000001ull, energy.getMj());
+}
+
+void test_pulse_replay_at_constant_power() {
+  // 2kW for an hour with a frame every 50ms. A pulse is 5000 mJ, so the
+  // 16-bit count wraps about every 2.7 minutes
+  const double power_w = 2000;
+  const double pulse_mj = kPowerCoef / 1000.0;
+  PulseEnergy pulse_energy;
+  EnergyAccumulator energy;
+  const int frames = 3600 * 20;
+  for (int frame = 0; frame <= frames; frame++) {
+    const double elapsed_s = frame * 0.05;
+    const uint64_t pulses = std::floor(power_w * 1000 * elapsed_s / pulse_mj);
+    energy.add(pulse_energy.update(uint16_t(pulses), kPowerCoef));
+  }
+  // 2 kWh, exact to one pulse
+  TEST_ASSERT_FLOAT_WITHIN(pulse_mj / 3.6e9, 2.0, energy.getKwh());
+}
+
+void test_pulse_first_frame_counts_nothing() {
+  // The PF count of the chip starts at a random value on power up
+  PulseEnergy pulse_energy;
+  TEST_ASSERT_EQUAL_FLOAT(0, pulse_energy.update(40000, kPowerCoef));
+  TEST_ASSERT_EQUAL_FLOAT(3 * 5000, pulse_energy.update(40003, kPowerCoef));
+  // Wraps from 65535 to 0
+  pulse_energy.update(65534, kPowerCoef);
+  TEST_ASSERT_EQUAL_FLOAT(4 * 5000, pulse_energy.update(2, kPowerCoef));
+}
+
+void test_trapezoid_replay_of_power_ramp() {
+  // Power ramps from 0 to 3kW over an hour, a frame about every 400ms
+  TrapezoidEnergy trapezoid_energy;
+  EnergyAccumulator energy;
+  const milliseconds duration = std::chrono::hours(1);
+  for (milliseconds t{0}; t <= duration; t += milliseconds(400)) {
+    const float power = 3000.0 * t.count() / duration.count();
+    energy.add(trapezoid_energy.update(power, kStart + t));
+  }
+  // The integral of the ramp is 1.5 kWh, which the trapezoids hit exactly
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.5, energy.getKwh());
+}
+
+void test_trapezoid_replay_of_load_cycles() {
+  // A 1kW heater switching on and off every 10 min for 6 hours
+  TrapezoidEnergy trapezoid_energy;
+  EnergyAccumulator energy;
+  const milliseconds duration = std::chrono::hours(6);
+  for (milliseconds t{0}; t <= duration; t += milliseconds(500)) {
+    const bool is_on = (t.count() / 600000) % 2 == 0;
+    energy.add(trapezoid_energy.update(is_on ? 1000 : 0, kStart + t));
+  }
+  // 3 hours on. The trapezoids over the edges count half a frame too little
+  // when switching off and too much when switching on
+  const double edge_kwh = 1000 * 0.25 / 3.6e6;
+  TEST_ASSERT_FLOAT_WITHIN(edge_kwh, 3.0, energy.getKwh());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_accumulator_carries_fractions);
+  RUN_TEST(test_accumulator_ignores_negative_energy);
+  RUN_TEST(test_pulse_replay_at_constant_power);
+  RUN_TEST(test_pulse_first_frame_counts_nothing);
+  RUN_TEST(test_trapezoid_replay_of_power_ramp);
+  RUN_TEST(test_trapezoid_replay_of_load_cycles);
+  return UNITY_END();
+}
@@ -0,0 +1,201 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "peripheral/peripherals/pca9539/interrupt_flag.h"
+#include "tasks/fixed/fire_data_logger/input_snapshot.h"
+
+using inamata::peripheral::peripherals::pca9539::InterruptFlag;
+using inamata::tasks::fixed::InputSnapshot;
+using InputStates = InputSnapshot::InputStates;
+using std::chrono::steady_clock;
+
+namespace {
+
+/// Interval of the InputSampler
+constexpr int64_t kSampleIntervalUs = 250 * 1000;
+
+/// PCA9539 bank asserting INT while its pins differ from the last read port
+struct SimulatedBank {
+  uint16_t pins = 0;
+  uint16_t port = 0;
+  InterruptFlag flag;
+  uint16_t state = 0;
+
+  bool isInterrupting() const { return pins != port; }
+};
+
+/// Two PCA9539 banks on a shared INT line and the GPIO inputs
+struct SimulatedInputs {
+  std::array<SimulatedBank, 2> banks;
+  uint16_t gpios = 0;
+  bool is_int_high = true;
+
+  void updateIntLine(int64_t now_us) {
+    const bool is_low =
+        banks[0].isInterrupting() || banks[1].isInterrupting();
+    if (is_low && is_int_high) {
+      for (SimulatedBank& bank : banks) {
+        bank.flag.onInterrupt(now_us);
+      }
+    }
+    is_int_high = !is_low;
+  }
+
+  /// Toggle an input by its index like a field device
+  void toggle(size_t index, int64_t now_us) {
+    if (index < 32) {
+      banks[index / 16].pins ^= 1 << (index % 16);
+      updateIntLine(now_us);
+    } else {
+      gpios ^= 1 << (index - 32);
+    }
+  }
+
+  /// Read a bank like PCA9539::getState
+  uint16_t getState(size_t bank_index, int64_t now_us) {
+    SimulatedBank& bank = banks[bank_index];
+    if (bank.flag.shouldRead(now_us)) {
+      bank.port = bank.pins;
+      bank.state = bank.port;
+      updateIntLine(now_us);
+    }
+    return bank.state;
+  }
+
+  InputStates getLevels() const {
+    return InputSnapshot::combine(banks[0].pins, banks[1].pins, gpios);
+  }
+};
+
+/// Samples the inputs and notifies the subscribers like the InputSampler
+struct Sampler {
+  SimulatedInputs& inputs;
+  InputSnapshot snapshot;
+  std::vector<std::function<void(const InputSnapshot&)>> callbacks;
+
+  void sample(int64_t now_us) {
+    const InputStates states = InputSnapshot::combine(
+        inputs.getState(0, now_us), inputs.getState(1, now_us), inputs.gpios);
+    const steady_clock::time_point now{std::chrono::microseconds(now_us)};
+    if (!snapshot.update(states, now)) {
+      return;
+    }
+    for (const auto& callback : callbacks) {
+      callback(snapshot);
+    }
+  }
+};
+
+struct InputLog {
+  uint8_t input;
+  bool state;
+};
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_combine_maps_input_indices() {
+  const InputStates states = InputSnapshot::combine(0x0001, 0x8000, 0x0100);
+  TEST_ASSERT_EQUAL(3, states.count());
+  TEST_ASSERT_TRUE(states.test(0));
+  TEST_ASSERT_TRUE(states.test(31));
+  // The maintenance input
+  TEST_ASSERT_TRUE(states.test(40));
+
+  // Bits above the GPIO inputs are ignored
+  TEST_ASSERT_TRUE(InputSnapshot::combine(0, 0, 0xFE00).none());
+  TEST_ASSERT_EQUAL(InputSnapshot::kInputCount,
+                    InputSnapshot::combine(0xFFFF, 0xFFFF, 0xFFFF).count());
+}
+
+void test_update_marks_changed_inputs() {
+  InputSnapshot snapshot;
+  const steady_clock::time_point start{};
+  TEST_ASSERT_TRUE(
+      snapshot.update(InputSnapshot::combine(0x0003, 0, 0), start));
+  TEST_ASSERT_EQUAL(2, snapshot.changed.count());
+
+  const steady_clock::time_point later = start + std::chrono::seconds(1);
+  TEST_ASSERT_TRUE(
+      snapshot.update(InputSnapshot::combine(0x0001, 0, 0x0001), later));
+  TEST_ASSERT_EQUAL(2, snapshot.changed.count());
+  TEST_ASSERT_TRUE(snapshot.changed.test(1));
+  TEST_ASSERT_TRUE(snapshot.changed.test(32));
+  TEST_ASSERT_FALSE(snapshot.states.test(1));
+  TEST_ASSERT_TRUE(snapshot.sampled_at == later);
+
+  TEST_ASSERT_FALSE(
+      snapshot.update(InputSnapshot::combine(0x0001, 0, 0x0001), later));
+  TEST_ASSERT_TRUE(snapshot.changed.none());
+}
+
+void test_subscribers_get_each_change_once() {
+  SimulatedInputs inputs;
+  Sampler sampler{inputs};
+  std::vector<InputLog> log;
+  size_t empty_callbacks = 0;
+  sampler.callbacks.push_back([&log](const InputSnapshot& snapshot) {
+    for (uint8_t i = 0; i < snapshot.changed.size(); i++) {
+      if (snapshot.changed.test(i)) {
+        log.push_back({uint8_t(i + 1), snapshot.states.test(i)});
+      }
+    }
+  });
+  sampler.callbacks.push_back([&empty_callbacks](const InputSnapshot& s) {
+    empty_callbacks += s.changed.none();
+  });
+
+  // The first snapshot is taken without notifying the subscribers
+  sampler.snapshot.update(InputSnapshot::combine(inputs.getState(0, 0),
+                                                 inputs.getState(1, 0), 0),
+                          {});
+  sampler.snapshot.changed.reset();
+
+  srand(11);
+  size_t toggles = 0;
+  for (int64_t now_us = kSampleIntervalUs; now_us < 3600LL * 1000000;
+       now_us += kSampleIntervalUs) {
+    // Pulses shorter than the interval may toggle an input twice
+    while (rand() % 8 == 0) {
+      const int64_t at_us = now_us - 1 - rand() % (kSampleIntervalUs - 1);
+      inputs.toggle(rand() % InputSnapshot::kInputCount, at_us);
+      toggles++;
+    }
+    sampler.sample(now_us);
+  }
+  // Let the safety poll pick up changes hidden by the shared INT line
+  const int64_t end_us = 3600LL * 1000000 + InterruptFlag::kSafetyPollPeriodUs;
+  for (int64_t now_us = 3600LL * 1000000; now_us <= end_us + kSampleIntervalUs;
+       now_us += kSampleIntervalUs) {
+    sampler.sample(now_us);
+  }
+
+  TEST_ASSERT_TRUE(toggles > 1000);
+  TEST_ASSERT_EQUAL(0, empty_callbacks);
+  TEST_ASSERT_TRUE(sampler.snapshot.states == inputs.getLevels());
+
+  // Replaying the log gives the final states and each entry is a transition
+  InputStates replayed;
+  for (const InputLog& entry : log) {
+    TEST_ASSERT_TRUE(replayed.test(entry.input - 1) != entry.state);
+    replayed.set(entry.input - 1, entry.state);
+  }
+  TEST_ASSERT_TRUE(replayed == inputs.getLevels());
+  TEST_ASSERT_TRUE(log.size() <= toggles);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_combine_maps_input_indices);
+  RUN_TEST(test_update_marks_changed_inputs);
+  RUN_TEST(test_subscribers_get_each_change_once);
+  return UNITY_END();
+}
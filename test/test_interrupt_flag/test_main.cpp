@@ -0,0 +1,247 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "peripheral/peripherals/pca9539/interrupt_flag.h"
+
+using inamata::peripheral::peripherals::pca9539::InterruptFlag;
+
+namespace {
+
+/// Interval of the InputSampler reading the banks
+constexpr int64_t kSampleIntervalUs = 250 * 1000;
+
+/// Input port of a PCA9539 with its open-drain INT output
+struct SimulatedBank {
+  /// Levels at the input pins
+  uint16_t pins = 0;
+  /// Input port register, latched on every read
+  uint16_t port = 0;
+  size_t reads = 0;
+
+  /// INT is asserted while the pins differ from the last read port
+  bool isInterrupting() const { return pins != port; }
+
+  uint16_t read() {
+    reads++;
+    port = pins;
+    return port;
+  }
+};
+
+/// INT line with a pull-up shared by the open-drain outputs of the banks
+struct SimulatedIntLine {
+  std::vector<const SimulatedBank*> banks;
+  /// Flags of the banks chained to the ISR
+  std::vector<InterruptFlag*> flags;
+  bool is_high = true;
+  size_t falling_edges = 0;
+
+  /// Updates the line level and runs the ISR on a falling edge
+  void update(int64_t now_us) {
+    const bool is_low =
+        std::any_of(banks.begin(), banks.end(), [](const SimulatedBank* bank) {
+          return bank->isInterrupting();
+        });
+    if (is_low && is_high) {
+      falling_edges++;
+      for (InterruptFlag* flag : flags) {
+        flag->onInterrupt(now_us);
+      }
+    }
+    is_high = !is_low;
+  }
+};
+
+/// Reads a bank like PCA9539::readInputs
+struct BankReader {
+  SimulatedBank& bank;
+  SimulatedIntLine& line;
+  InterruptFlag flag;
+  uint16_t state = 0;
+
+  uint16_t getState(int64_t now_us) {
+    if (flag.shouldRead(now_us)) {
+      state = bank.read();
+      line.update(now_us);
+    }
+    return state;
+  }
+};
+
+void setPins(SimulatedBank& bank, SimulatedIntLine& line, uint16_t pins,
+             int64_t now_us) {
+  bank.pins = pins;
+  line.update(now_us);
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_reads_on_first_call() {
+  InterruptFlag flag;
+  TEST_ASSERT_EQUAL(-1, flag.getChangedAt());
+  TEST_ASSERT_TRUE(flag.shouldRead(0));
+  TEST_ASSERT_FALSE(flag.shouldRead(kSampleIntervalUs));
+}
+
+void test_reads_only_after_int_edge() {
+  SimulatedBank bank;
+  SimulatedIntLine line{{&bank}};
+  BankReader reader{bank, line};
+  line.flags = {&reader.flag};
+
+  int64_t now_us = 0;
+  for (; now_us < 9000000; now_us += kSampleIntervalUs) {
+    TEST_ASSERT_EQUAL_UINT16(0, reader.getState(now_us));
+  }
+  TEST_ASSERT_EQUAL(1, bank.reads);
+
+  setPins(bank, line, 0x0104, now_us - 1000);
+  TEST_ASSERT_EQUAL(1, line.falling_edges);
+  TEST_ASSERT_EQUAL(now_us - 1000, reader.flag.getChangedAt());
+  TEST_ASSERT_EQUAL_UINT16(0x0104, reader.getState(now_us));
+  TEST_ASSERT_EQUAL(2, bank.reads);
+  // The read released the INT line
+  TEST_ASSERT_TRUE(line.is_high);
+  TEST_ASSERT_EQUAL_UINT16(0x0104, reader.getState(now_us + kSampleIntervalUs));
+  TEST_ASSERT_EQUAL(2, bank.reads);
+}
+
+void test_safety_poll_without_edges() {
+  SimulatedBank bank;
+  SimulatedIntLine line{{&bank}};
+  BankReader reader{bank, line};
+  // The INT line is not connected, so changes are not flagged
+  int64_t now_us = 0;
+  reader.getState(now_us);
+  bank.pins = 0x8000;
+
+  const int64_t poll_by_us =
+      InterruptFlag::kSafetyPollPeriodUs + kSampleIntervalUs;
+  for (now_us += kSampleIntervalUs;
+       now_us <= poll_by_us && reader.getState(now_us) != 0x8000;
+       now_us += kSampleIntervalUs) {
+  }
+  TEST_ASSERT_EQUAL_UINT16(0x8000, reader.state);
+  TEST_ASSERT_EQUAL(2, bank.reads);
+  TEST_ASSERT_TRUE(now_us > InterruptFlag::kSafetyPollPeriodUs);
+  TEST_ASSERT_EQUAL(-1, reader.flag.getChangedAt());
+}
+
+void test_shared_int_line_flags_all_banks() {
+  SimulatedBank bank_1;
+  SimulatedBank bank_2;
+  SimulatedIntLine line{{&bank_1, &bank_2}};
+  BankReader reader_1{bank_1, line};
+  BankReader reader_2{bank_2, line};
+  line.flags = {&reader_1.flag, &reader_2.flag};
+  reader_1.getState(0);
+  reader_2.getState(0);
+
+  setPins(bank_2, line, 0x0001, 100000);
+  TEST_ASSERT_EQUAL(100000, reader_1.flag.getChangedAt());
+  TEST_ASSERT_EQUAL(100000, reader_2.flag.getChangedAt());
+  // The first bank is read as well, as the change could be on either one
+  TEST_ASSERT_EQUAL_UINT16(0, reader_1.getState(kSampleIntervalUs));
+  TEST_ASSERT_FALSE(line.is_high);
+  TEST_ASSERT_EQUAL_UINT16(0x0001, reader_2.getState(kSampleIntervalUs));
+  TEST_ASSERT_TRUE(line.is_high);
+  TEST_ASSERT_EQUAL(2, bank_1.reads);
+  TEST_ASSERT_EQUAL(2, bank_2.reads);
+}
+
+void test_change_hidden_by_other_bank_is_polled() {
+  SimulatedBank bank_1;
+  SimulatedBank bank_2;
+  SimulatedIntLine line{{&bank_1, &bank_2}};
+  BankReader reader_1{bank_1, line};
+  BankReader reader_2{bank_2, line};
+  line.flags = {&reader_1.flag, &reader_2.flag};
+  reader_1.getState(0);
+  reader_2.getState(0);
+
+  // Bank 2 is read first and changes while bank 1 still holds INT low, so
+  // there is no further falling edge for it
+  setPins(bank_1, line, 0x0010, 100000);
+  int64_t now_us = kSampleIntervalUs;
+  reader_2.getState(now_us);
+  setPins(bank_2, line, 0x0020, now_us + 10);
+  reader_1.getState(now_us + 20);
+  TEST_ASSERT_EQUAL(1, line.falling_edges);
+  TEST_ASSERT_FALSE(line.is_high);
+
+  const int64_t poll_by_us =
+      InterruptFlag::kSafetyPollPeriodUs + 2 * kSampleIntervalUs;
+  for (now_us += kSampleIntervalUs;
+       now_us <= poll_by_us && reader_2.getState(now_us) != 0x0020;
+       now_us += kSampleIntervalUs) {
+    TEST_ASSERT_EQUAL_UINT16(0x0010, reader_1.getState(now_us));
+  }
+  TEST_ASSERT_EQUAL_UINT16(0x0020, reader_2.state);
+  TEST_ASSERT_TRUE(line.is_high);
+}
+
+void test_random_changes_on_shared_line() {
+  SimulatedBank bank_1;
+  SimulatedBank bank_2;
+  SimulatedIntLine line{{&bank_1, &bank_2}};
+  BankReader reader_1{bank_1, line};
+  BankReader reader_2{bank_2, line};
+  line.flags = {&reader_1.flag, &reader_2.flag};
+
+  srand(7);
+  size_t samples = 0;
+  size_t changes = 0;
+  size_t delayed_samples = 0;
+  int64_t stale_since_us = -1;
+  int64_t max_stale_us = 0;
+  // One hour of pins toggling on average every 5 s
+  for (int64_t now_us = 0; now_us < 3600LL * 1000000;
+       now_us += kSampleIntervalUs) {
+    if (rand() % 20 == 0) {
+      SimulatedBank& bank = rand() % 2 ? bank_1 : bank_2;
+      const int64_t at_us = now_us - 1 - rand() % (kSampleIntervalUs - 1);
+      setPins(bank, line, bank.pins ^ (1 << (rand() % 16)), at_us);
+      changes++;
+    }
+
+    samples++;
+    const uint16_t state_1 = reader_1.getState(now_us);
+    const uint16_t state_2 = reader_2.getState(now_us);
+    if (state_1 == bank_1.pins && state_2 == bank_2.pins) {
+      stale_since_us = -1;
+      continue;
+    }
+    delayed_samples++;
+    if (stale_since_us < 0) {
+      stale_since_us = now_us;
+    }
+    max_stale_us = std::max(max_stale_us, now_us - stale_since_us);
+  }
+
+  TEST_ASSERT_TRUE(changes > 500);
+  // Changes hidden by the other bank are picked up by the safety poll
+  TEST_ASSERT_TRUE(max_stale_us <= InterruptFlag::kSafetyPollPeriodUs +
+                                       kSampleIntervalUs);
+  // Almost all changes are read in the sample after their INT edge
+  TEST_ASSERT_TRUE(delayed_samples < samples / 100);
+  // Polling would read both banks on every sample
+  TEST_ASSERT_TRUE(bank_1.reads + bank_2.reads < samples / 5);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_reads_on_first_call);
+  RUN_TEST(test_reads_only_after_int_edge);
+  RUN_TEST(test_safety_poll_without_edges);
+  RUN_TEST(test_shared_int_line_flags_all_banks);
+  RUN_TEST(test_change_hidden_by_other_bank_is_polled);
+  RUN_TEST(test_random_changes_on_shared_line);
+  return UNITY_END();
+}
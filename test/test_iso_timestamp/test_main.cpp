@@ -0,0 +1,67 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <ctime>
+
+#include "utils/iso_timestamp.h"
+
+using inamata::utils::IsoTimestampFormatter;
+
+namespace {
+
+/// Format without the cache to compare against
+void formatUncached(time_t seconds, long microseconds, char* buffer) {
+  struct tm tm_info;
+  gmtime_r(&seconds, &tm_info);
+  char base[20];
+  strftime(base, sizeof(base), "%Y-%m-%dT%H:%M:%S", &tm_info);
+  snprintf(buffer, IsoTimestampFormatter::kSize, "%s.%06ldZ", base,
+           microseconds);
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_formats_iso_8601() {
+  IsoTimestampFormatter formatter;
+  char buffer[IsoTimestampFormatter::kSize];
+  formatter.format(1751891505, 123456, buffer);
+  TEST_ASSERT_EQUAL_STRING("2025-07-07T12:31:45.123456Z", buffer);
+  formatter.format(0, 0, buffer);
+  TEST_ASSERT_EQUAL_STRING("1970-01-01T00:00:00.000000Z", buffer);
+}
+
+void test_matches_uncached_across_second_changes() {
+  IsoTimestampFormatter formatter;
+  char buffer[IsoTimestampFormatter::kSize];
+  char expected[IsoTimestampFormatter::kSize];
+  // Crosses a minute, hour, day and year boundary in 0.3 s steps
+  const time_t start = 1767225598;
+  for (long step = 0; step < 40; step++) {
+    const long total_us = step * 300000;
+    const time_t seconds = start + total_us / 1000000;
+    const long microseconds = total_us % 1000000;
+    formatter.format(seconds, microseconds, buffer);
+    formatUncached(seconds, microseconds, expected);
+    TEST_ASSERT_EQUAL_STRING(expected, buffer);
+  }
+}
+
+void test_updates_when_time_jumps_back() {
+  IsoTimestampFormatter formatter;
+  char buffer[IsoTimestampFormatter::kSize];
+  formatter.format(1751891505, 0, buffer);
+  formatter.format(1751891404, 5, buffer);
+  TEST_ASSERT_EQUAL_STRING("2025-07-07T12:30:04.000005Z", buffer);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_formats_iso_8601);
+  RUN_TEST(test_matches_uncached_across_second_changes);
+  RUN_TEST(test_updates_when_time_jumps_back);
+  return UNITY_END();
+}
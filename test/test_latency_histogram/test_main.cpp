@@ -0,0 +1,71 @@
+#include <unity.h>
+
+#include <chrono>
+
+#include "utils/latency_histogram.h"
+
+using inamata::utils::LatencyHistogram;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_empty_histogram() {
+  LatencyHistogram histogram;
+  TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+  TEST_ASSERT_EQUAL(0, histogram.getPercentile(50).count());
+  TEST_ASSERT_EQUAL(0, histogram.getMax().count());
+}
+
+void test_percentiles_use_bucket_bounds() {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 90; i++) {
+    histogram.add(microseconds(800));
+  }
+  for (int i = 0; i < 10; i++) {
+    histogram.add(milliseconds(30));
+  }
+  TEST_ASSERT_EQUAL_UINT32(100, histogram.getCount());
+  TEST_ASSERT_EQUAL(1, histogram.getPercentile(50).count());
+  TEST_ASSERT_EQUAL(1, histogram.getPercentile(90).count());
+  TEST_ASSERT_EQUAL(50, histogram.getPercentile(91).count());
+  TEST_ASSERT_EQUAL(50, histogram.getPercentile(99).count());
+  TEST_ASSERT_EQUAL(30000, histogram.getMax().count());
+}
+
+void test_bounds_are_inclusive() {
+  LatencyHistogram histogram;
+  histogram.add(milliseconds(2));
+  TEST_ASSERT_EQUAL(2, histogram.getPercentile(100).count());
+  histogram.reset();
+  histogram.add(milliseconds(2) + microseconds(1));
+  TEST_ASSERT_EQUAL(5, histogram.getPercentile(100).count());
+}
+
+void test_unbounded_bucket_uses_max() {
+  LatencyHistogram histogram;
+  histogram.add(milliseconds(1));
+  histogram.add(milliseconds(7500));
+  TEST_ASSERT_EQUAL(7500, histogram.getPercentile(99).count());
+}
+
+void test_reset_clears_all() {
+  LatencyHistogram histogram;
+  histogram.add(milliseconds(100));
+  histogram.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+  TEST_ASSERT_EQUAL(0, histogram.getPercentile(99).count());
+  TEST_ASSERT_EQUAL(0, histogram.getMax().count());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_histogram);
+  RUN_TEST(test_percentiles_use_bucket_bounds);
+  RUN_TEST(test_bounds_are_inclusive);
+  RUN_TEST(test_unbounded_bucket_uses_max);
+  RUN_TEST(test_reset_clears_all);
+  return UNITY_END();
+}
@@ -0,0 +1,203 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "managers/log_buffer.h"
+
+using inamata::LogBuffer;
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace {
+
+constexpr size_t kMaxBufferedLogs = 32;
+constexpr seconds kMaxBufferedLogAge{10};
+constexpr uint16_t kMaxLogEntries = 500;
+/// Interval of the LogInputs task calling handle
+constexpr milliseconds kTick{1000};
+
+struct Entry {
+  std::string date;
+  int file_num;
+  uint32_t time;
+  /// When the entry was added
+  Clock::time_point added_at;
+};
+
+/// Buffers and writes entries like the LoggingManager to files in RAM
+struct Logger {
+  LogBuffer<Entry> buffer{kMaxBufferedLogs, kMaxBufferedLogAge};
+  int file_num = 1;
+  uint16_t log_count = 0;
+  /// Log times per date/file number
+  std::map<std::string, std::vector<uint32_t>> files;
+  size_t file_opens = 0;
+  Clock::duration max_delay{};
+
+  void addLog(const std::string& date, uint32_t time, Clock::time_point now,
+              bool force_flush = false) {
+    const bool is_full = buffer.add({date, file_num, time, now}, now);
+    if (++log_count >= kMaxLogEntries) {
+      file_num++;
+      log_count = 0;
+    }
+    if (force_flush || is_full) {
+      flush(now);
+    }
+  }
+
+  void handle(Clock::time_point now) {
+    if (buffer.isExpired(now)) {
+      flush(now);
+    }
+  }
+
+  void flush(Clock::time_point now) {
+    buffer.flush(
+        [](const Entry& a, const Entry& b) {
+          return a.date == b.date && a.file_num == b.file_num;
+        },
+        [this, now](LogBuffer<Entry>::Iterator first,
+                    LogBuffer<Entry>::Iterator last) {
+          file_opens++;
+          std::vector<uint32_t>& file =
+              files[first->date + "/" + std::to_string(first->file_num)];
+          for (auto it = first; it != last; it++) {
+            file.push_back(it->time);
+            max_delay = std::max(max_delay, now - it->added_at);
+          }
+        });
+  }
+
+  size_t countRecords() const {
+    size_t count = 0;
+    for (const auto& file : files) {
+      count += file.second.size();
+    }
+    return count;
+  }
+};
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_burst_is_written_in_batches() {
+  Logger logger;
+  const Clock::time_point start{};
+  // 100 input changes within one tick
+  for (uint32_t i = 0; i < 100; i++) {
+    logger.addLog("20240501", i, start + milliseconds(i));
+  }
+  TEST_ASSERT_EQUAL(3, logger.file_opens);
+  TEST_ASSERT_EQUAL(96, logger.countRecords());
+  TEST_ASSERT_EQUAL(4, logger.buffer.size());
+
+  logger.handle(start + kMaxBufferedLogAge);
+  TEST_ASSERT_EQUAL(96, logger.countRecords());
+  logger.handle(start + kMaxBufferedLogAge + kTick);
+  TEST_ASSERT_EQUAL(4, logger.file_opens);
+  TEST_ASSERT_EQUAL(100, logger.files["20240501/1"].size());
+  TEST_ASSERT_EQUAL(0, logger.buffer.size());
+}
+
+void test_age_counts_from_oldest_entry() {
+  Logger logger;
+  const Clock::time_point start{};
+  logger.addLog("20240501", 1, start);
+  logger.addLog("20240501", 2, start + seconds(9));
+  logger.handle(start + seconds(10));
+  TEST_ASSERT_EQUAL(0, logger.countRecords());
+  logger.handle(start + seconds(11));
+  TEST_ASSERT_EQUAL(2, logger.countRecords());
+
+  // The next entry starts a new age
+  logger.addLog("20240501", 3, start + seconds(12));
+  logger.handle(start + seconds(20));
+  TEST_ASSERT_EQUAL(2, logger.countRecords());
+  logger.handle(start + seconds(23));
+  TEST_ASSERT_EQUAL(3, logger.countRecords());
+  TEST_ASSERT_FALSE(logger.buffer.isExpired(start + seconds(60)));
+}
+
+void test_runs_split_at_rotation_and_day() {
+  Logger logger;
+  logger.log_count = kMaxLogEntries - 10;
+  const Clock::time_point start{};
+  for (uint32_t i = 0; i < 20; i++) {
+    logger.addLog("20240501", i, start);
+  }
+  // Entries after midnight go to the next day's directory
+  for (uint32_t i = 20; i < 25; i++) {
+    logger.addLog("20240502", i, start);
+  }
+  logger.flush(start);
+
+  TEST_ASSERT_EQUAL(3, logger.file_opens);
+  TEST_ASSERT_EQUAL(10, logger.files["20240501/1"].size());
+  TEST_ASSERT_EQUAL(10, logger.files["20240501/2"].size());
+  TEST_ASSERT_EQUAL(5, logger.files["20240502/2"].size());
+  TEST_ASSERT_EQUAL_UINT32(10, logger.files["20240501/2"].front());
+}
+
+void test_forced_flush_writes_immediately() {
+  Logger logger;
+  const Clock::time_point start{};
+  logger.addLog("20240501", 1, start);
+  // Like an alarm starting or a restart
+  logger.addLog("20240501", 2, start, true);
+  TEST_ASSERT_EQUAL(1, logger.file_opens);
+  TEST_ASSERT_EQUAL(2, logger.countRecords());
+  TEST_ASSERT_EQUAL(0, logger.buffer.size());
+}
+
+void test_day_of_input_changes() {
+  Logger logger;
+  const Clock::time_point start{};
+  srand(3);
+  uint32_t logged = 0;
+  std::vector<uint32_t> expected;
+  for (uint32_t tick = 0; tick < 86400; tick++) {
+    const Clock::time_point now = start + tick * kTick;
+    logger.handle(now);
+    // Mostly quiet with occasional bursts of input changes
+    const int changes = rand() % 50 == 0 ? rand() % 80 : rand() % 30 == 0;
+    for (int i = 0; i < changes; i++) {
+      expected.push_back(logged);
+      logger.addLog("20240501", logged++, now + milliseconds(i));
+    }
+  }
+  logger.flush(start + 86400 * kTick);
+
+  // All records are written once and in order, at most 500 per file
+  std::vector<uint32_t> written;
+  for (int file_num = 1; file_num <= logger.file_num; file_num++) {
+    const std::vector<uint32_t>& file =
+        logger.files["20240501/" + std::to_string(file_num)];
+    TEST_ASSERT_TRUE(file.size() <= kMaxLogEntries);
+    written.insert(written.end(), file.begin(), file.end());
+  }
+  TEST_ASSERT_TRUE(written == expected);
+  TEST_ASSERT_TRUE(logged > 10000);
+  // Within a tick of the max age
+  TEST_ASSERT_TRUE(logger.max_delay <= kMaxBufferedLogAge + kTick);
+  // Instead of one open per record
+  TEST_ASSERT_TRUE(logger.file_opens < logged / 8);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_burst_is_written_in_batches);
+  RUN_TEST(test_age_counts_from_oldest_entry);
+  RUN_TEST(test_runs_split_at_rotation_and_day);
+  RUN_TEST(test_forced_flush_writes_immediately);
+  RUN_TEST(test_day_of_input_changes);
+  return UNITY_END();
+}
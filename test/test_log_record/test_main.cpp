@@ -0,0 +1,269 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "managers/log_record.h"
+
+using inamata::firstLogPosition;
+using inamata::filterLogRecords;
+using inamata::HourIndex;
+using inamata::kNoRecord;
+using inamata::LogPosition;
+using inamata::LogRecord;
+
+namespace {
+
+/// 2024-05-01T00:00:00Z
+constexpr uint32_t kDayStart = 1714521600;
+constexpr uint16_t kRecordsPerFile = 500;
+constexpr size_t kChunkRecords = 32;
+
+HourIndex emptyHourIndex() {
+  HourIndex hour_index;
+  hour_index.fill({kNoRecord, kNoRecord});
+  return hour_index;
+}
+
+/// Log files of a day with the hour index as written by the logging manager
+struct DayLog {
+  std::vector<LogRecord> records;
+  HourIndex hour_index = emptyHourIndex();
+
+  void add(uint32_t time, uint8_t input) {
+    const uint8_t hour = (time - kDayStart) / 3600;
+    LogPosition& position = hour_index[hour];
+    if (position.file_num == kNoRecord) {
+      position = {uint16_t(records.size() / kRecordsPerFile + 1),
+                  uint16_t(records.size() % kRecordsPerFile)};
+    }
+    records.push_back({time, input, 1, LogRecord::Type::kInput, 0});
+  }
+
+  /// Read like LoggingManager::readDayLogs in chunks of the read buffer size
+  bool read(LogPosition& position, uint32_t start, uint32_t end,
+            const inamata::LogRecordCallback& callback,
+            size_t& records_read) const {
+    while (true) {
+      const size_t file_start = (position.file_num - 1) * kRecordsPerFile;
+      const size_t file_end =
+          std::min(file_start + kRecordsPerFile, records.size());
+      for (size_t index = file_start + position.record; index < file_end;
+           index += kChunkRecords) {
+        const size_t count = std::min(kChunkRecords, file_end - index);
+        records_read += count;
+        if (!filterLogRecords(&records[index], count, start, end, callback,
+                              position)) {
+          return false;
+        }
+      }
+      if (file_end >= records.size()) {
+        return true;
+      }
+      position = {uint16_t(position.file_num + 1), 0};
+    }
+  }
+
+  /// Query like LoggingManager::queryLogs
+  std::vector<LogRecord> query(uint32_t start, uint32_t end,
+                               size_t& records_read) const {
+    std::vector<LogRecord> result;
+    records_read = 0;
+    LogPosition position =
+        firstLogPosition(hour_index, (start - kDayStart) / 3600);
+    if (position.file_num == kNoRecord) {
+      return result;
+    }
+    read(position, start, end,
+         [&result](const LogRecord& record) {
+           result.push_back(record);
+           return true;
+         },
+         records_read);
+    return result;
+  }
+
+  std::vector<LogRecord> scan(uint32_t start, uint32_t end) const {
+    std::vector<LogRecord> result;
+    for (const LogRecord& record : records) {
+      if (record.time >= start && record.time <= end) {
+        result.push_back(record);
+      }
+    }
+    return result;
+  }
+};
+
+void assertRecords(const std::vector<LogRecord>& expected,
+                   const std::vector<LogRecord>& actual) {
+  TEST_ASSERT_EQUAL(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    TEST_ASSERT_EQUAL_MEMORY(&expected[i], &actual[i], sizeof(LogRecord));
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_record_encoding() {
+  const LogRecord record{0x664D1A2B, 48, 1, LogRecord::Type::kInput, 0};
+  uint8_t bytes[sizeof(LogRecord)];
+  memcpy(bytes, &record, sizeof(record));
+
+  // Little endian time followed by input, state, type and reserved
+  const uint8_t expected[] = {0x2B, 0x1A, 0x4D, 0x66, 48, 1, 1, 0};
+  TEST_ASSERT_EQUAL_MEMORY(expected, bytes, sizeof(expected));
+
+  LogRecord decoded;
+  memcpy(&decoded, bytes, sizeof(decoded));
+  TEST_ASSERT_EQUAL_UINT32(record.time, decoded.time);
+  TEST_ASSERT_EQUAL(48, decoded.input);
+  TEST_ASSERT_EQUAL(1, decoded.state);
+  TEST_ASSERT_TRUE(decoded.type == LogRecord::Type::kInput);
+}
+
+void test_first_position_without_records() {
+  const LogPosition position = firstLogPosition(emptyHourIndex(), 0);
+  TEST_ASSERT_EQUAL(kNoRecord, position.file_num);
+}
+
+void test_first_position_is_lowest_from_first_hour() {
+  HourIndex hour_index = emptyHourIndex();
+  hour_index[2] = {1, 10};
+  hour_index[9] = {3, 0};
+  // Logged before the clock was set back to 09:00
+  hour_index[14] = {1, 400};
+  hour_index[15] = {2, 5};
+
+  LogPosition position = firstLogPosition(hour_index, 9);
+  TEST_ASSERT_EQUAL(1, position.file_num);
+  TEST_ASSERT_EQUAL(400, position.record);
+
+  position = firstLogPosition(hour_index, 0);
+  TEST_ASSERT_EQUAL(1, position.file_num);
+  TEST_ASSERT_EQUAL(10, position.record);
+
+  position = firstLogPosition(hour_index, 16);
+  TEST_ASSERT_EQUAL(kNoRecord, position.file_num);
+}
+
+void test_filter_skips_out_of_range_records() {
+  const std::vector<LogRecord> records = {
+      {100, 1, 1, LogRecord::Type::kInput, 0},
+      {50, 2, 1, LogRecord::Type::kInput, 0},
+      {200, 3, 1, LogRecord::Type::kInput, 0},
+      {101, 4, 1, LogRecord::Type::kInput, 0},
+  };
+  std::vector<uint8_t> inputs;
+  LogPosition position{1, 0};
+  const bool completed = filterLogRecords(
+      records.data(), records.size(), 100, 150,
+      [&inputs](const LogRecord& record) {
+        inputs.push_back(record.input);
+        return true;
+      },
+      position);
+  TEST_ASSERT_TRUE(completed);
+  TEST_ASSERT_EQUAL(4, position.record);
+  TEST_ASSERT_EQUAL(2, inputs.size());
+  TEST_ASSERT_EQUAL(1, inputs[0]);
+  TEST_ASSERT_EQUAL(4, inputs[1]);
+}
+
+void test_filter_stops_on_callback() {
+  const std::vector<LogRecord> records(10, {100, 1, 1,
+                                            LogRecord::Type::kInput, 0});
+  size_t calls = 0;
+  LogPosition position{1, 5};
+  const bool completed = filterLogRecords(
+      records.data(), records.size(), 0, 1000,
+      [&calls](const LogRecord& record) { return ++calls < 3; }, position);
+  TEST_ASSERT_FALSE(completed);
+  TEST_ASSERT_EQUAL(3, calls);
+  // Continues after the last passed record
+  TEST_ASSERT_EQUAL(8, position.record);
+}
+
+void test_range_query_over_100k_records() {
+  DayLog day;
+  // The first records were logged with the clock ahead at 14:00
+  for (uint32_t i = 0; i < 1000; i++) {
+    day.add(kDayStart + 14 * 3600 + i, i % 48 + 1);
+  }
+  for (uint32_t i = 0; i < 99000; i++) {
+    day.add(kDayStart + uint64_t(i) * 86400 / 99000, i % 48 + 1);
+  }
+
+  const uint32_t start = kDayStart + 10 * 3600;
+  const uint32_t end = kDayStart + 15 * 3600 - 1;
+  size_t records_read = 0;
+  const std::vector<LogRecord> result = day.query(start, end, records_read);
+  assertRecords(day.scan(start, end), result);
+  // 1000 clock jump records plus 5 h of ~0.87 s intervals
+  TEST_ASSERT_EQUAL(1000 + 20625, result.size());
+  // Starts at the clock jump records and not at 10:00
+  TEST_ASSERT_EQUAL_UINT32(kDayStart + 14 * 3600, result.front().time);
+  TEST_ASSERT_EQUAL(100000, records_read);
+
+  // Without a clock jump in the later hours, the index skips the earlier ones
+  const uint32_t late_start = kDayStart + 20 * 3600;
+  const std::vector<LogRecord> late_result =
+      day.query(late_start, kDayStart + 86399, records_read);
+  assertRecords(day.scan(late_start, kDayStart + 86399), late_result);
+  TEST_ASSERT_EQUAL(16500, late_result.size());
+  TEST_ASSERT_EQUAL(16500, records_read);
+}
+
+void test_chunked_export_continues_at_cursor() {
+  // 250 kB of records, 8 per second with every 50th logged out of order
+  DayLog day;
+  for (uint32_t i = 0; i < 32000; i++) {
+    const uint32_t time = kDayStart + 3600 + i / 8;
+    day.add(i % 50 == 49 ? time - 600 : time, i % 48 + 1);
+  }
+  const uint32_t start = kDayStart + 3600;
+  const uint32_t end = kDayStart + 86399;
+
+  // Export in chunks like the LogExporter while new records are logged
+  std::vector<LogRecord> exported;
+  std::vector<LogRecord> chunk;
+  LogPosition cursor = firstLogPosition(day.hour_index, 1);
+  size_t records_read = 0;
+  size_t chunks = 0;
+  bool is_done = false;
+  while (!is_done) {
+    chunk.clear();
+    is_done = day.read(cursor, start, end,
+                       [&chunk](const LogRecord& record) {
+                         chunk.push_back(record);
+                         return chunk.size() < 64;
+                       },
+                       records_read);
+    exported.insert(exported.end(), chunk.begin(), chunk.end());
+    if (++chunks % 100 == 0 && !is_done) {
+      day.add(kDayStart + 7200 + chunks, 1);
+    }
+  }
+
+  assertRecords(day.scan(start, end), exported);
+  // Without the out of order records before the start and with the new ones
+  TEST_ASSERT_EQUAL(32000 - 96 + 4, exported.size());
+  // Every record is read once plus the rest of the stopped read buffers
+  TEST_ASSERT_TRUE(records_read <= day.records.size() + chunks * kChunkRecords);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_record_encoding);
+  RUN_TEST(test_first_position_without_records);
+  RUN_TEST(test_first_position_is_lowest_from_first_hour);
+  RUN_TEST(test_filter_skips_out_of_range_records);
+  RUN_TEST(test_filter_stops_on_callback);
+  RUN_TEST(test_range_query_over_100k_records);
+  RUN_TEST(test_chunked_export_continues_at_cursor);
+  return UNITY_END();
+}
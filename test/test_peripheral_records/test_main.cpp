@@ -0,0 +1,241 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "managers/peripheral_records.h"
+
+using inamata::getPeripheralRecordName;
+using inamata::nextPeripheralSequence;
+using inamata::parsePeripheralRecordName;
+using inamata::PeripheralRecord;
+using inamata::PeripheralRecordFiles;
+using inamata::replacePeripheralRecords;
+using inamata::sortPeripheralRecords;
+
+namespace {
+
+/// Record directory in RAM that can fail writes and lose power
+struct FakeRecordDir {
+  /// Record file names and their contents
+  std::map<std::string, std::string> files;
+  /// Contents written for the peripherals passed to the replace
+  std::vector<std::string> contents;
+  /// Operations in the order they were done
+  std::vector<std::string> operations;
+  /// Fail the write with this number, counting from 1
+  size_t fail_write = 0;
+  /// Number of operations until the power is lost
+  size_t power_budget = SIZE_MAX;
+  size_t writes = 0;
+
+  bool hasPower() {
+    if (power_budget == 0) {
+      return false;
+    }
+    power_budget--;
+    return true;
+  }
+
+  PeripheralRecordFiles getFiles() {
+    return {
+        .write =
+            [this](const PeripheralRecord& record, size_t index) {
+              if (++writes == fail_write || !hasPower()) {
+                return false;
+              }
+              operations.push_back("write " + record.id);
+              files[getPeripheralRecordName(record)] = contents[index];
+              return true;
+            },
+        .remove =
+            [this](const PeripheralRecord& record) {
+              if (!hasPower()) {
+                return;
+              }
+              operations.push_back("remove " + record.id);
+              files.erase(getPeripheralRecordName(record));
+            },
+        .rename =
+            [this](const PeripheralRecord& from, const PeripheralRecord& to) {
+              if (!hasPower()) {
+                return;
+              }
+              auto file = files.find(getPeripheralRecordName(from));
+              if (file != files.end()) {
+                files[getPeripheralRecordName(to)] = file->second;
+                files.erase(file);
+              }
+            },
+    };
+  }
+
+  /// List the records like Storage::listPeripheralRecords
+  std::vector<PeripheralRecord> list() {
+    std::vector<PeripheralRecord> records;
+    PeripheralRecord record;
+    for (const auto& file : files) {
+      if (parsePeripheralRecordName(file.first.c_str(), record)) {
+        records.push_back(record);
+      }
+    }
+    sortPeripheralRecords(records, getFiles());
+    return records;
+  }
+
+  /// Load the peripheral contents in the stored order after a reboot
+  std::vector<std::string> load() {
+    power_budget = SIZE_MAX;
+    std::vector<std::string> loaded;
+    for (const PeripheralRecord& record : list()) {
+      loaded.push_back(files[getPeripheralRecordName(record)]);
+    }
+    return loaded;
+  }
+
+  /// Replace all records with peripherals of the IDs at the version
+  bool store(const std::vector<std::string>& ids, int version) {
+    contents.clear();
+    for (const std::string& id : ids) {
+      contents.push_back(id + "@" + std::to_string(version));
+    }
+    std::vector<PeripheralRecord> records = list();
+    return replacePeripheralRecords(records, ids, getFiles());
+  }
+};
+
+void assertLoaded(const std::vector<std::string>& expected,
+                  const std::vector<std::string>& loaded) {
+  TEST_ASSERT_EQUAL(expected.size(), loaded.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    TEST_ASSERT_EQUAL_STRING(expected[i].c_str(), loaded[i].c_str());
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_record_name_round_trip() {
+  const PeripheralRecord record{0x01AF, "dbe8fd5e-3ec0-4d4c-9f76"};
+  const std::string name = getPeripheralRecordName(record);
+  TEST_ASSERT_EQUAL_STRING("01af_dbe8fd5e-3ec0-4d4c-9f76", name.c_str());
+
+  PeripheralRecord parsed;
+  TEST_ASSERT_TRUE(parsePeripheralRecordName(name.c_str(), parsed));
+  TEST_ASSERT_EQUAL_UINT16(record.sequence, parsed.sequence);
+  TEST_ASSERT_EQUAL_STRING(record.id.c_str(), parsed.id.c_str());
+
+  TEST_ASSERT_FALSE(parsePeripheralRecordName("peripherals.json", parsed));
+  TEST_ASSERT_FALSE(parsePeripheralRecordName("_id", parsed));
+  TEST_ASSERT_FALSE(parsePeripheralRecordName("10000_id", parsed));
+}
+
+void test_sort_keeps_newest_record() {
+  FakeRecordDir dir;
+  dir.files = {{"0003_b", "b@2"}, {"0000_a", "a@1"}, {"0001_b", "b@1"},
+               {"0002_c", "c@1"}};
+  const std::vector<PeripheralRecord> records = dir.list();
+  TEST_ASSERT_EQUAL(3, records.size());
+  TEST_ASSERT_EQUAL_STRING("a", records[0].id.c_str());
+  TEST_ASSERT_EQUAL_STRING("c", records[1].id.c_str());
+  TEST_ASSERT_EQUAL_STRING("b", records[2].id.c_str());
+  // The older record is removed from the file system
+  TEST_ASSERT_EQUAL(3, dir.files.size());
+  TEST_ASSERT_EQUAL(0, dir.files.count("0001_b"));
+}
+
+void test_replace_writes_before_removing() {
+  FakeRecordDir dir;
+  TEST_ASSERT_TRUE(dir.store({"a", "b", "c"}, 1));
+  dir.operations.clear();
+
+  TEST_ASSERT_TRUE(dir.store({"c", "d"}, 2));
+  const std::vector<std::string> expected_operations = {
+      "write c", "write d", "remove a", "remove b", "remove c"};
+  assertLoaded(expected_operations, dir.operations);
+  // Loaded in the passed order, not the one first stored in
+  assertLoaded({"c@2", "d@2"}, dir.load());
+}
+
+void test_failed_write_keeps_old_records() {
+  FakeRecordDir dir;
+  TEST_ASSERT_TRUE(dir.store({"a", "b", "c"}, 1));
+
+  dir.fail_write = dir.writes + 3;
+  TEST_ASSERT_FALSE(dir.store({"b", "d", "e", "f"}, 2));
+  assertLoaded({"a@1", "b@1", "c@1"}, dir.load());
+  TEST_ASSERT_EQUAL(3, dir.files.size());
+}
+
+void test_power_loss_keeps_all_peripherals() {
+  const std::vector<std::string> old_ids = {"a", "b", "c", "d"};
+  const std::vector<std::string> new_ids = {"d", "e", "b", "f", "g"};
+  // Writes of the new records and removals of the old ones
+  const size_t operation_count = new_ids.size() + old_ids.size();
+
+  for (size_t budget = 0; budget <= operation_count; budget++) {
+    FakeRecordDir dir;
+    TEST_ASSERT_TRUE(dir.store(old_ids, 1));
+    dir.power_budget = budget;
+    dir.store(new_ids, 2);
+
+    // Every old peripheral or its new version and every written new one
+    // survive, each once
+    const std::vector<std::string> loaded = dir.load();
+    const size_t written = std::min(budget, new_ids.size());
+    std::map<std::string, std::string> loaded_versions;
+    for (const std::string& content : loaded) {
+      const std::string id = content.substr(0, content.find('@'));
+      TEST_ASSERT_EQUAL(0, loaded_versions.count(id));
+      loaded_versions[id] = content;
+    }
+    for (size_t i = 0; i < written; i++) {
+      TEST_ASSERT_EQUAL_STRING((new_ids[i] + "@2").c_str(),
+                               loaded_versions[new_ids[i]].c_str());
+    }
+    if (budget < new_ids.size()) {
+      for (const std::string& id : old_ids) {
+        TEST_ASSERT_EQUAL(1, loaded_versions.count(id));
+      }
+    }
+    if (budget == operation_count) {
+      assertLoaded({"d@2", "e@2", "b@2", "f@2", "g@2"}, loaded);
+    }
+  }
+}
+
+void test_sequence_overflow_renumbers_records() {
+  FakeRecordDir dir;
+  dir.files = {{"fffa_a", "a@1"}, {"fff0_b", "b@1"}, {"fffc_c", "c@1"}};
+  std::vector<PeripheralRecord> records = dir.list();
+  const uint16_t sequence = nextPeripheralSequence(records, 3, dir.getFiles());
+  TEST_ASSERT_EQUAL_UINT16(3, sequence);
+  TEST_ASSERT_EQUAL(1, dir.files.count("0000_b"));
+  TEST_ASSERT_EQUAL(1, dir.files.count("0001_a"));
+  TEST_ASSERT_EQUAL(1, dir.files.count("0002_c"));
+  assertLoaded({"b@1", "a@1", "c@1"}, dir.load());
+
+  // Without an overflow, the sequence continues
+  records = dir.list();
+  TEST_ASSERT_EQUAL_UINT16(3, nextPeripheralSequence(records, 100,
+                                                     dir.getFiles()));
+  TEST_ASSERT_TRUE(dir.store({"a", "b"}, 2));
+  TEST_ASSERT_EQUAL(1, dir.files.count("0003_a"));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_record_name_round_trip);
+  RUN_TEST(test_sort_keeps_newest_record);
+  RUN_TEST(test_replace_writes_before_removing);
+  RUN_TEST(test_failed_write_keeps_old_records);
+  RUN_TEST(test_power_loss_keeps_all_peripherals);
+  RUN_TEST(test_sequence_overflow_renumbers_records);
+  return UNITY_END();
+}
@@ -0,0 +1,82 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "peripheral/peripherals/modbus/read_block_planner.h"
+
+using inamata::peripheral::peripherals::modbus::planReadBlocks;
+using inamata::peripheral::peripherals::modbus::ReadRange;
+
+namespace {
+
+using Blocks = std::vector<std::vector<size_t>>;
+
+void assertBlocks(const Blocks& expected, const Blocks& actual) {
+  TEST_ASSERT_EQUAL(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    TEST_ASSERT_EQUAL(expected[i].size(), actual[i].size());
+    for (size_t j = 0; j < expected[i].size(); j++) {
+      TEST_ASSERT_EQUAL(expected[i][j], actual[i][j]);
+    }
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_no_reads() { assertBlocks({}, planReadBlocks({}, 10, 125)); }
+
+void test_merges_adjacent_reads_sorted_by_address() {
+  const std::vector<ReadRange> reads = {{1, 4, 2}, {1, 0, 2}, {1, 2, 2}};
+  assertBlocks({{1, 2, 0}}, planReadBlocks(reads, 0, 125));
+}
+
+void test_merges_within_gap() {
+  const std::vector<ReadRange> reads = {{1, 0, 2}, {1, 5, 1}, {1, 9, 1}};
+  // 3 registers between the first two, 3 between the last two
+  assertBlocks({{0, 1, 2}}, planReadBlocks(reads, 3, 125));
+  assertBlocks({{0}, {1}, {2}}, planReadBlocks(reads, 2, 125));
+}
+
+void test_merges_overlapping_reads() {
+  const std::vector<ReadRange> reads = {{1, 0, 10}, {1, 2, 2}, {1, 8, 4}};
+  assertBlocks({{0, 1, 2}}, planReadBlocks(reads, 0, 125));
+}
+
+void test_splits_at_max_size() {
+  const std::vector<ReadRange> reads = {{1, 0, 100}, {1, 100, 25},
+                                        {1, 125, 1}};
+  assertBlocks({{0, 1}, {2}}, planReadBlocks(reads, 0, 125));
+}
+
+void test_keeps_servers_apart() {
+  const std::vector<ReadRange> reads = {{2, 0, 1}, {1, 1, 1}, {1, 0, 1},
+                                        {2, 1, 1}};
+  assertBlocks({{2, 1}, {0, 3}}, planReadBlocks(reads, 10, 125));
+}
+
+void test_keeps_order_of_equal_reads() {
+  const std::vector<ReadRange> reads = {{1, 3, 1}, {1, 3, 1}, {1, 3, 1}};
+  assertBlocks({{0, 1, 2}}, planReadBlocks(reads, 0, 125));
+}
+
+void test_handles_end_of_address_space() {
+  const std::vector<ReadRange> reads = {{1, 0xFFFE, 2}, {1, 0xFFF0, 2}};
+  assertBlocks({{1, 0}}, planReadBlocks(reads, 20, 125));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_reads);
+  RUN_TEST(test_merges_adjacent_reads_sorted_by_address);
+  RUN_TEST(test_merges_within_gap);
+  RUN_TEST(test_merges_overlapping_reads);
+  RUN_TEST(test_splits_at_max_size);
+  RUN_TEST(test_keeps_servers_apart);
+  RUN_TEST(test_keeps_order_of_equal_reads);
+  RUN_TEST(test_handles_end_of_address_space);
+  return UNITY_END();
+}
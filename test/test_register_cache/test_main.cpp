@@ -0,0 +1,115 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "peripheral/peripherals/modbus/register_cache.h"
+
+using inamata::peripheral::peripherals::modbus::RegisterCache;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using TimePoint = std::chrono::steady_clock::time_point;
+
+namespace {
+
+const TimePoint kStart = TimePoint() + std::chrono::hours(1);
+
+/// A task polling the Tiaki remote sensor block on its own cadence
+struct Poller {
+  std::chrono::milliseconds interval;
+  TimePoint next_poll;
+};
+
+/**
+ * Poll a block of 4 registers like ModbusClientInput for 10 minutes
+ *
+ * \return The number of bus reads
+ */
+int countReads(std::vector<Poller> pollers, milliseconds max_age) {
+  RegisterCache cache(4);
+  int reads = 0;
+  for (TimePoint now = kStart; now < kStart + std::chrono::minutes(10);
+       now += milliseconds(100)) {
+    for (Poller& poller : pollers) {
+      if (now < poller.next_poll) {
+        continue;
+      }
+      poller.next_poll = now + poller.interval;
+      bool is_fresh = true;
+      for (uint16_t offset = 0; offset < cache.size(); offset++) {
+        is_fresh &= cache.isFresh(offset, max_age, now);
+      }
+      if (is_fresh) {
+        continue;
+      }
+      reads++;
+      for (uint16_t offset = 0; offset < cache.size(); offset++) {
+        cache.store(offset, offset, now);
+      }
+    }
+  }
+  return reads;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_unread_registers_are_not_fresh() {
+  RegisterCache cache(2);
+  uint16_t value = 7;
+  TEST_ASSERT_FALSE(cache.get(0, value));
+  TEST_ASSERT_EQUAL(7, value);
+  TEST_ASSERT_FALSE(cache.isFresh(0, seconds(4), kStart));
+
+  cache.store(0, 400, kStart);
+  TEST_ASSERT_TRUE(cache.get(0, value));
+  TEST_ASSERT_EQUAL(400, value);
+  TEST_ASSERT_FALSE(cache.get(1, value));
+  // Out of the block
+  cache.store(2, 1, kStart);
+  TEST_ASSERT_FALSE(cache.get(2, value));
+  TEST_ASSERT_FALSE(cache.isFresh(2, seconds(4), kStart));
+}
+
+void test_registers_age_out() {
+  RegisterCache cache(1);
+  cache.store(0, 400, kStart);
+  TEST_ASSERT_TRUE(cache.isFresh(0, seconds(4), kStart));
+  TEST_ASSERT_TRUE(cache.isFresh(0, seconds(4), kStart + milliseconds(3999)));
+  TEST_ASSERT_FALSE(cache.isFresh(0, seconds(4), kStart + seconds(4)));
+  // A zero max age always reads
+  TEST_ASSERT_FALSE(cache.isFresh(0, milliseconds(0), kStart));
+
+  // A new read makes it fresh again and the stale value is still returned
+  uint16_t value;
+  TEST_ASSERT_TRUE(cache.get(0, value));
+  cache.store(0, 500, kStart + seconds(5));
+  TEST_ASSERT_TRUE(cache.isFresh(0, seconds(4), kStart + seconds(8)));
+  TEST_ASSERT_TRUE(cache.get(0, value));
+  TEST_ASSERT_EQUAL(500, value);
+}
+
+void test_pollers_share_reads() {
+  // Alarms, AntiCondensation, PollRemoteSensor and UserInput
+  const std::vector<Poller> pollers = {{seconds(5), kStart},
+                                       {seconds(10), kStart},
+                                       {seconds(30), kStart},
+                                       {seconds(60), kStart}};
+
+  // Without caching every poll reads the bus
+  TEST_ASSERT_EQUAL(120 + 60 + 20 + 10, countReads(pollers, milliseconds(0)));
+  // With the Tiaki max age of 4s the alarm polls serve the slower pollers
+  TEST_ASSERT_EQUAL(120, countReads(pollers, seconds(4)));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_unread_registers_are_not_fresh);
+  RUN_TEST(test_registers_age_out);
+  RUN_TEST(test_pollers_share_reads);
+  return UNITY_END();
+}
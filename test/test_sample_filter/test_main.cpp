@@ -0,0 +1,96 @@
+#include <unity.h>
+
+#include <cmath>
+
+#include "peripheral/peripherals/analog_in/sample_filter.h"
+
+using inamata::peripheral::peripherals::analog_in::SampleFilter;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_passes_samples_without_filters() {
+  SampleFilter filter;
+  TEST_ASSERT_FALSE(filter.isFiltering());
+  TEST_ASSERT_TRUE(std::isnan(filter.get()));
+  TEST_ASSERT_EQUAL_FLOAT(3, filter.add(3));
+  TEST_ASSERT_EQUAL_FLOAT(7, filter.add(7));
+  TEST_ASSERT_EQUAL_FLOAT(7, filter.get());
+}
+
+void test_median_removes_spikes() {
+  SampleFilter filter;
+  filter.setMedianWindow(3);
+  TEST_ASSERT_TRUE(filter.isFiltering());
+  filter.add(10);
+  filter.add(11);
+  TEST_ASSERT_EQUAL_FLOAT(11, filter.add(1000));
+  TEST_ASSERT_EQUAL_FLOAT(12, filter.add(12));
+  TEST_ASSERT_EQUAL_FLOAT(13, filter.add(13));
+}
+
+void test_median_of_one_is_disabled() {
+  SampleFilter filter;
+  filter.setMedianWindow(1);
+  TEST_ASSERT_FALSE(filter.isFiltering());
+  TEST_ASSERT_EQUAL_FLOAT(1000, filter.add(1000));
+}
+
+void test_median_window_is_limited() {
+  SampleFilter filter;
+  filter.setMedianWindow(255);
+  for (int i = 0; i < 8; i++) {
+    filter.add(1);
+  }
+  for (int i = 0; i < 7; i++) {
+    filter.add(1000);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(1000, filter.add(1000));
+  // The oldest samples dropped out of the 15 sample window
+  TEST_ASSERT_EQUAL_FLOAT(1000, filter.add(1));
+}
+
+void test_ema_starts_at_first_sample() {
+  SampleFilter filter;
+  // Window of 3 gives an alpha of 0.5
+  filter.setSmoothing(SampleFilter::Smoothing::kEma, 3);
+  TEST_ASSERT_TRUE(filter.isFiltering());
+  TEST_ASSERT_EQUAL_FLOAT(8, filter.add(8));
+  TEST_ASSERT_EQUAL_FLOAT(12, filter.add(16));
+  TEST_ASSERT_EQUAL_FLOAT(14, filter.add(16));
+}
+
+void test_boxcar_averages_window() {
+  SampleFilter filter;
+  filter.setSmoothing(SampleFilter::Smoothing::kBoxcar, 4);
+  TEST_ASSERT_EQUAL_FLOAT(4, filter.add(4));
+  TEST_ASSERT_EQUAL_FLOAT(6, filter.add(8));
+  filter.add(0);
+  TEST_ASSERT_EQUAL_FLOAT(4, filter.add(4));
+  // The first sample leaves the window
+  TEST_ASSERT_EQUAL_FLOAT(5, filter.add(8));
+}
+
+void test_median_before_smoothing() {
+  SampleFilter filter;
+  filter.setMedianWindow(3);
+  filter.setSmoothing(SampleFilter::Smoothing::kBoxcar, 2);
+  filter.add(10);
+  filter.add(10);
+  // The spike is removed by the median and does not reach the boxcar
+  TEST_ASSERT_EQUAL_FLOAT(10, filter.add(1000));
+  TEST_ASSERT_EQUAL_FLOAT(15, filter.add(20));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_passes_samples_without_filters);
+  RUN_TEST(test_median_removes_spikes);
+  RUN_TEST(test_median_of_one_is_disabled);
+  RUN_TEST(test_median_window_is_limited);
+  RUN_TEST(test_ema_starts_at_first_sample);
+  RUN_TEST(test_boxcar_averages_window);
+  RUN_TEST(test_median_before_smoothing);
+  return UNITY_END();
+}
@@ -0,0 +1,181 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "peripheral/peripherals/ads1x15/scan_schedule.h"
+
+using inamata::peripheral::peripherals::ads1x15::ScanSchedule;
+
+namespace {
+
+// Register values from Adafruit_ADS1X15.h
+constexpr uint16_t kMux0 = 0x4000;
+constexpr uint16_t kMux1 = 0x5000;
+constexpr uint16_t kMux2 = 0x6000;
+constexpr uint16_t kGainOne = 0x0200;
+constexpr uint16_t kGainTwo = 0x0400;
+
+/// ADS1115 with the config and conversion registers of the continuous mode
+struct Ads1115Model {
+  /// Input voltage per single ended mux value
+  std::map<uint16_t, float> inputs;
+  /// Mux and PGA bits of the config register
+  uint16_t config = 0;
+  int16_t conversion = 0;
+  /// Mux values in the order their conversions were started
+  std::vector<uint16_t> started;
+
+  static float fullScale(uint16_t gain) {
+    switch (gain) {
+      case kGainOne:
+        return 4.096;
+      case kGainTwo:
+        return 2.048;
+    }
+    return 6.144;
+  }
+
+  /// Like setGain and startADCReading of the driver
+  void start(uint16_t channel, uint16_t gain) {
+    config = channel | gain;
+    started.push_back(channel);
+  }
+
+  /// Finish a conversion with the settings of the config register
+  void convert() {
+    const float full_scale = fullScale(config & 0x0E00);
+    const float counts = inputs[config & 0x7000] / full_scale * 32768;
+    conversion = std::max(-32768.0f, std::min(32767.0f, std::round(counts)));
+  }
+
+  /// Like getLastConversionResults and computeVolts of the driver
+  float read() const {
+    return conversion * fullScale(config & 0x0E00) / 32768;
+  }
+};
+
+struct ScanFixture {
+  Ads1115Model adc;
+  ScanSchedule schedule;
+  std::chrono::steady_clock::time_point now;
+
+  /// Run the scan task once after a conversion finished
+  void step() {
+    now += std::chrono::milliseconds(10);
+    adc.convert();
+    schedule.step([this]() { return adc.read(); },
+                  [this](uint16_t channel, uint16_t gain) {
+                    adc.start(channel, gain);
+                  },
+                  now);
+  }
+
+  float voltage(uint16_t channel, uint16_t gain) const {
+    return schedule.get(channel, gain)->voltage;
+  }
+};
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_pairs_are_converted_round_robin() {
+  ScanFixture scan;
+  scan.adc.inputs = {{kMux0, 0.5}, {kMux1, 1.5}, {kMux2, 3.3}};
+  TEST_ASSERT_TRUE(scan.schedule.add(kMux0, kGainOne));
+  TEST_ASSERT_TRUE(scan.schedule.add(kMux1, kGainTwo));
+  TEST_ASSERT_TRUE(scan.schedule.add(kMux2, kGainOne));
+
+  for (int i = 0; i < 7; i++) {
+    scan.step();
+  }
+  const std::vector<uint16_t> expected = {kMux0, kMux1, kMux2, kMux0,
+                                          kMux1, kMux2, kMux0};
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(expected.data(), scan.adc.started.data(),
+                                 expected.size());
+  TEST_ASSERT_EQUAL(expected.size(), scan.adc.started.size());
+
+  // Each value was converted with its own channel and gain
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 0.5, scan.voltage(kMux0, kGainOne));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1.5, scan.voltage(kMux1, kGainTwo));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 3.3, scan.voltage(kMux2, kGainOne));
+
+  // The last read pair was read one step ago, the others two and three
+  const auto age = [&scan](uint16_t channel, uint16_t gain) {
+    return scan.now - scan.schedule.get(channel, gain)->read_at;
+  };
+  TEST_ASSERT_TRUE(age(kMux2, kGainOne) == std::chrono::milliseconds(0));
+  TEST_ASSERT_TRUE(age(kMux1, kGainTwo) == std::chrono::milliseconds(10));
+  TEST_ASSERT_TRUE(age(kMux0, kGainOne) == std::chrono::milliseconds(20));
+}
+
+void test_single_pair_keeps_converting() {
+  ScanFixture scan;
+  scan.adc.inputs = {{kMux0, 1.0}};
+  scan.schedule.add(kMux0, kGainOne);
+  TEST_ASSERT_TRUE(std::isnan(scan.voltage(kMux0, kGainOne)));
+
+  for (int i = 0; i < 3; i++) {
+    scan.step();
+  }
+  scan.adc.inputs[kMux0] = 2.0;
+  scan.step();
+
+  // Started once and read on every following step
+  TEST_ASSERT_EQUAL(1, scan.adc.started.size());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 2.0, scan.voltage(kMux0, kGainOne));
+  TEST_ASSERT_TRUE(scan.schedule.get(kMux0, kGainOne)->read_at == scan.now);
+}
+
+void test_removal_discards_active_conversion() {
+  ScanFixture scan;
+  scan.adc.inputs = {{kMux0, 0.5}, {kMux1, 1.5}, {kMux2, 3.3}};
+  scan.schedule.add(kMux0, kGainOne);
+  scan.schedule.add(kMux1, kGainOne);
+  scan.schedule.add(kMux2, kGainOne);
+  scan.step();
+  scan.step();
+  TEST_ASSERT_EQUAL_UINT16(kMux1, scan.adc.started.back());
+
+  // The conversion of mux 1 must not be stored as the next pair's value
+  TEST_ASSERT_FALSE(scan.schedule.remove(kMux0, kGainOne));
+  scan.step();
+  TEST_ASSERT_TRUE(std::isnan(scan.voltage(kMux1, kGainOne)));
+  TEST_ASSERT_TRUE(std::isnan(scan.voltage(kMux2, kGainOne)));
+  TEST_ASSERT_EQUAL_UINT16(kMux1, scan.adc.started.back());
+
+  scan.step();
+  scan.step();
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1.5, scan.voltage(kMux1, kGainOne));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 3.3, scan.voltage(kMux2, kGainOne));
+}
+
+void test_shared_pairs_count_users() {
+  ScanSchedule schedule;
+  TEST_ASSERT_NULL(schedule.get(kMux0, kGainOne));
+  TEST_ASSERT_TRUE(schedule.add(kMux0, kGainOne));
+  TEST_ASSERT_FALSE(schedule.add(kMux0, kGainOne));
+  TEST_ASSERT_TRUE(schedule.add(kMux0, kGainTwo));
+
+  TEST_ASSERT_FALSE(schedule.remove(kMux0, kGainOne));
+  TEST_ASSERT_NOT_NULL(schedule.get(kMux0, kGainOne));
+  TEST_ASSERT_FALSE(schedule.remove(kMux0, kGainOne));
+  TEST_ASSERT_NULL(schedule.get(kMux0, kGainOne));
+  TEST_ASSERT_TRUE(schedule.remove(kMux0, kGainTwo));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_pairs_are_converted_round_robin);
+  RUN_TEST(test_single_pair_keeps_converting);
+  RUN_TEST(test_removal_discards_active_conversion);
+  RUN_TEST(test_shared_pairs_count_users);
+  return UNITY_END();
+}
@@ -0,0 +1,126 @@
+#include <unity.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "utils/sorted_table.h"
+
+using inamata::utils::SortedTable;
+
+namespace {
+
+/// Compared like utils::UUID by its bytes
+struct Dpt {
+  std::array<uint8_t, 16> buffer{0};
+
+  bool operator<(const Dpt& rhs) const { return buffer < rhs.buffer; }
+  bool operator==(const Dpt& rhs) const { return buffer == rhs.buffer; }
+};
+
+struct Limit {
+  int id;
+};
+
+/// The limits of an input like Alarms::InputLimits
+struct InputLimits {
+  Limit* bool_limit = nullptr;
+  Limit* duration_limit = nullptr;
+};
+
+/// UUID v4 like DPT with pseudo random bytes
+Dpt makeDpt(uint32_t seed) {
+  Dpt dpt;
+  uint32_t state = seed * 2654435761u + 1;
+  for (uint8_t& byte : dpt.buffer) {
+    state = state * 1664525u + 1013904223u;
+    byte = state >> 24;
+  }
+  dpt.buffer[6] = (dpt.buffer[6] & 0x0F) | 0x40;
+  return dpt;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_finds_every_dpt() {
+  // As many inputs as the fire data logger alarms
+  std::array<Limit, 40> limits;
+  std::vector<Dpt> dpts;
+  for (size_t i = 0; i < limits.size(); i++) {
+    limits[i].id = i;
+    dpts.push_back(makeDpt(i));
+  }
+
+  // Built from an unsorted list like Alarms::buildInputLimits
+  SortedTable<Dpt, InputLimits> table = {
+      {dpts[0], {&limits[0]}},   {dpts[1], {&limits[1]}},
+      {dpts[2], {&limits[2]}},   {dpts[3], {&limits[3]}},
+      {dpts[4], {&limits[4]}},   {dpts[5], {&limits[5]}},
+      {dpts[6], {&limits[6]}},   {dpts[7], {&limits[7]}},
+      {dpts[8], {&limits[8]}},   {dpts[9], {&limits[9]}},
+      {dpts[10], {&limits[10]}}, {dpts[11], {&limits[11]}},
+      {dpts[12], {&limits[12]}}, {dpts[13], {&limits[13]}},
+      {dpts[14], {&limits[14]}}, {dpts[15], {&limits[15]}},
+      {dpts[16], {&limits[16]}}, {dpts[17], {&limits[17]}},
+      {dpts[18], {&limits[18]}}, {dpts[19], {&limits[19]}},
+      {dpts[20], {&limits[20]}}, {dpts[21], {&limits[21]}},
+      {dpts[22], {&limits[22]}}, {dpts[23], {&limits[23]}},
+      {dpts[24], {&limits[24]}}, {dpts[25], {&limits[25]}},
+      {dpts[26], {&limits[26]}}, {dpts[27], {&limits[27]}},
+      {dpts[28], {&limits[28]}}, {dpts[29], {&limits[29]}},
+      {dpts[30], {&limits[30]}}, {dpts[31], {&limits[31]}},
+      {dpts[32], {&limits[32]}}, {dpts[33], {&limits[33]}},
+      {dpts[34], {&limits[34]}}, {dpts[35], {&limits[35]}},
+      {dpts[36], {&limits[36]}}, {dpts[37], {&limits[37]}},
+      {dpts[38], {nullptr, &limits[38]}},
+      {dpts[39], {nullptr, &limits[39]}},
+  };
+  TEST_ASSERT_EQUAL(40, table.size());
+
+  for (size_t i = 0; i < dpts.size(); i++) {
+    const InputLimits* input_limits = table.find(dpts[i]);
+    TEST_ASSERT_TRUE(input_limits != nullptr);
+    const Limit* limit = i < 38 ? input_limits->bool_limit
+                                : input_limits->duration_limit;
+    TEST_ASSERT_TRUE(limit != nullptr);
+    TEST_ASSERT_EQUAL(i, limit->id);
+  }
+}
+
+void test_unknown_dpt_is_not_found() {
+  Limit limit{1};
+  const Dpt low = makeDpt(1);
+  const Dpt high = makeDpt(2);
+  const SortedTable<Dpt, InputLimits> table = {{high, {&limit}},
+                                               {low, {&limit}}};
+
+  // Before, between and after the table's keys
+  Dpt before;
+  Dpt between = low < high ? low : high;
+  between.buffer[15]++;
+  Dpt after;
+  after.buffer.fill(0xFF);
+  TEST_ASSERT_TRUE(table.find(before) == nullptr);
+  TEST_ASSERT_TRUE(table.find(between) == nullptr);
+  TEST_ASSERT_TRUE(table.find(after) == nullptr);
+  TEST_ASSERT_TRUE(table.find(low) != nullptr);
+  TEST_ASSERT_TRUE(table.find(high) != nullptr);
+}
+
+void test_empty_table() {
+  const SortedTable<Dpt, InputLimits> table;
+  TEST_ASSERT_EQUAL(0, table.size());
+  TEST_ASSERT_TRUE(table.find(makeDpt(1)) == nullptr);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_finds_every_dpt);
+  RUN_TEST(test_unknown_dpt_is_not_found);
+  RUN_TEST(test_empty_table);
+  return UNITY_END();
+}
@@ -0,0 +1,96 @@
+#include <unity.h>
+
+#include <chrono>
+
+#include "utils/token_bucket.h"
+
+using inamata::utils::TokenBucket;
+using std::chrono::milliseconds;
+
+namespace {
+
+const TokenBucket::Clock::time_point kStart =
+    TokenBucket::Clock::time_point() + std::chrono::hours(1);
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_starts_full() {
+  TokenBucket bucket(10, 5);
+  TEST_ASSERT_TRUE(bucket.hasTokens(5, kStart));
+  bucket.consume(0.5);
+  TEST_ASSERT_FALSE(bucket.hasTokens(5, kStart));
+}
+
+void test_refills_at_rate() {
+  TokenBucket bucket(10, 5);
+  TEST_ASSERT_TRUE(bucket.hasTokens(5, kStart));
+  bucket.consume(5);
+  TEST_ASSERT_FALSE(bucket.hasTokens(1, kStart + milliseconds(50)));
+  TEST_ASSERT_TRUE(bucket.hasTokens(1, kStart + milliseconds(100)));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1, bucket.getTokens());
+}
+
+void test_caps_at_capacity() {
+  TokenBucket bucket(10, 5);
+  TEST_ASSERT_TRUE(bucket.hasTokens(1, kStart));
+  TEST_ASSERT_TRUE(bucket.hasTokens(1, kStart + std::chrono::seconds(10)));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 5, bucket.getTokens());
+}
+
+void test_large_request_leaves_debt() {
+  TokenBucket bucket(10, 5);
+  // Larger than the capacity, but allowed as the bucket is full
+  TEST_ASSERT_TRUE(bucket.hasTokens(20, kStart));
+  bucket.consume(20);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, -15, bucket.getTokens());
+  // The debt is repaid before tokens are available again
+  TEST_ASSERT_FALSE(bucket.hasTokens(1, kStart + milliseconds(1500)));
+  TEST_ASSERT_TRUE(bucket.hasTokens(1, kStart + milliseconds(1600)));
+}
+
+void test_keeps_long_term_rate() {
+  TokenBucket bucket(10, 1);
+  TEST_ASSERT_TRUE(bucket.hasTokens(1, kStart));
+  int consumed = 0;
+  for (int ms = 0; ms <= 10000; ms++) {
+    if (bucket.hasTokens(1, kStart + milliseconds(ms))) {
+      bucket.consume(1);
+      consumed++;
+    }
+  }
+  // One full bucket plus 10 tokens per second
+  TEST_ASSERT_INT_WITHIN(1, 101, consumed);
+}
+
+void test_ignores_time_going_backwards() {
+  TokenBucket bucket(10, 5);
+  TEST_ASSERT_TRUE(bucket.hasTokens(5, kStart));
+  bucket.consume(5);
+  TEST_ASSERT_FALSE(bucket.hasTokens(1, kStart - std::chrono::seconds(10)));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 0, bucket.getTokens());
+}
+
+void test_configure_refills() {
+  TokenBucket bucket(10, 5);
+  TEST_ASSERT_TRUE(bucket.hasTokens(5, kStart));
+  bucket.consume(5);
+  bucket.configure(1, 2);
+  TEST_ASSERT_TRUE(bucket.hasTokens(2, kStart));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 2, bucket.getTokens());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_starts_full);
+  RUN_TEST(test_refills_at_rate);
+  RUN_TEST(test_caps_at_capacity);
+  RUN_TEST(test_large_request_leaves_debt);
+  RUN_TEST(test_keeps_long_term_rate);
+  RUN_TEST(test_ignores_time_going_backwards);
+  RUN_TEST(test_configure_refills);
+  return UNITY_END();
+}
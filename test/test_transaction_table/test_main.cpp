@@ -0,0 +1,254 @@
+#include <unity.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "peripheral/peripherals/modbus/transaction_table.h"
+
+using inamata::peripheral::peripherals::modbus::TransactionTable;
+
+namespace {
+
+enum class Error { kSuccess, kTimeout, kCrcError };
+
+/// What happens to a request frame on the bus
+enum class Fault { kNone, kDrop, kDelay, kCorrupt };
+
+struct Request {
+  int id = -1;
+  std::function<void(Error error)> callback;
+};
+
+constexpr size_t kTableSize = 16;
+constexpr uint8_t kMaxRetries = 1;
+
+/**
+ * Client and server on a simulated RTU bus
+ *
+ * The client handles responses like ModbusClientAdapter. The driver sends
+ * one queued frame at a time and reports a timeout if the server's response
+ * does not arrive in time.
+ */
+struct SimulatedBus {
+  TransactionTable<Request, kTableSize> transactions;
+  /// Frames queued by the driver, by token
+  std::deque<uint32_t> driver_queue;
+  /// Responses that arrive after the driver reported a timeout
+  std::vector<uint32_t> late_responses;
+  std::function<Fault(int id)> fault;
+  uint32_t timeouts = 0;
+  uint32_t crc_errors = 0;
+  uint32_t retries = 0;
+
+  /// Like ModbusClientAdapter::sendRequest
+  bool send(Request request) {
+    const uint32_t token = transactions.open(std::move(request));
+    if (!token) {
+      return false;
+    }
+    driver_queue.push_back(token);
+    return true;
+  }
+
+  /// Like ModbusClientAdapter::modbusResponseHandler
+  void respond(uint32_t token, Error error) {
+    if (!transactions.find(token)) {
+      return;
+    }
+    if (error == Error::kTimeout) {
+      timeouts++;
+    } else if (error == Error::kCrcError) {
+      crc_errors++;
+    }
+    const bool is_retryable =
+        error == Error::kTimeout || error == Error::kCrcError;
+    const uint32_t retry_token =
+        is_retryable ? transactions.retry(token, kMaxRetries) : 0;
+    if (retry_token) {
+      retries++;
+      driver_queue.push_back(retry_token);
+      return;
+    }
+    Request finished;
+    transactions.close(token, &finished);
+    finished.callback(error);
+  }
+
+  /// Send the next frame and pass the response or error to the client
+  void transfer() {
+    const uint32_t token = driver_queue.front();
+    driver_queue.pop_front();
+    const std::vector<uint32_t> late = std::move(late_responses);
+    late_responses.clear();
+
+    switch (fault(transactions.find(token)->id)) {
+      case Fault::kNone:
+        respond(token, Error::kSuccess);
+        break;
+      case Fault::kDrop:
+        respond(token, Error::kTimeout);
+        break;
+      case Fault::kDelay:
+        respond(token, Error::kTimeout);
+        late_responses.push_back(token);
+        break;
+      case Fault::kCorrupt:
+        respond(token, Error::kCrcError);
+        break;
+    }
+    for (const uint32_t late_token : late) {
+      respond(late_token, Error::kSuccess);
+    }
+  }
+};
+
+/// Faults of the attempts of each request, then no faults
+Fault scriptedFault(std::vector<std::deque<Fault>>& script, int id) {
+  if (script[id].empty()) {
+    return Fault::kNone;
+  }
+  const Fault fault = script[id].front();
+  script[id].pop_front();
+  return fault;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_lost_and_corrupted_frames_are_resent_once() {
+  std::vector<std::deque<Fault>> script = {
+      {},
+      {Fault::kDrop},
+      {Fault::kCorrupt, Fault::kCorrupt},
+      {Fault::kDelay},
+      {Fault::kDrop, Fault::kDelay},
+  };
+  SimulatedBus bus;
+  bus.fault = [&script](int id) { return scriptedFault(script, id); };
+
+  std::vector<std::vector<Error>> results(script.size());
+  for (size_t id = 0; id < script.size(); id++) {
+    bus.send({int(id), [&results, id](Error error) {
+                results[id].push_back(error);
+              }});
+  }
+  while (!bus.driver_queue.empty()) {
+    bus.transfer();
+  }
+
+  const Error expected[] = {Error::kSuccess, Error::kSuccess,
+                            Error::kCrcError, Error::kSuccess,
+                            Error::kTimeout};
+  for (size_t id = 0; id < script.size(); id++) {
+    TEST_ASSERT_EQUAL(1, results[id].size());
+    TEST_ASSERT_TRUE(expected[id] == results[id].front());
+  }
+  TEST_ASSERT_EQUAL(4, bus.timeouts);
+  TEST_ASSERT_EQUAL(2, bus.crc_errors);
+  TEST_ASSERT_EQUAL(4, bus.retries);
+  TEST_ASSERT_EQUAL(0, bus.transactions.size());
+}
+
+void test_full_table_rejects_requests() {
+  TransactionTable<Request, kTableSize> transactions;
+  std::vector<uint32_t> tokens;
+  for (size_t i = 0; i < kTableSize; i++) {
+    tokens.push_back(transactions.open({int(i), nullptr}));
+    TEST_ASSERT_TRUE(tokens.back() != 0);
+  }
+  TEST_ASSERT_EQUAL(0, transactions.open({99, nullptr}));
+
+  // A freed slot is reused with a new token
+  Request closed;
+  TEST_ASSERT_TRUE(transactions.close(tokens[3], &closed));
+  TEST_ASSERT_EQUAL(3, closed.id);
+  TEST_ASSERT_FALSE(transactions.close(tokens[3]));
+  const uint32_t token = transactions.open({99, nullptr});
+  TEST_ASSERT_TRUE(token > tokens.back());
+  TEST_ASSERT_EQUAL(99, transactions.find(token)->id);
+  TEST_ASSERT_TRUE(transactions.find(tokens[3]) == nullptr);
+  TEST_ASSERT_TRUE(transactions.find(0) == nullptr);
+}
+
+void test_retry_replaces_the_token() {
+  TransactionTable<Request, kTableSize> transactions;
+  const uint32_t token = transactions.open({1, nullptr});
+  const uint32_t retry_token = transactions.retry(token, kMaxRetries);
+  TEST_ASSERT_TRUE(retry_token != 0 && retry_token != token);
+  TEST_ASSERT_TRUE(transactions.find(token) == nullptr);
+  TEST_ASSERT_EQUAL(1, transactions.find(retry_token)->id);
+  TEST_ASSERT_EQUAL(0, transactions.retry(retry_token, kMaxRetries));
+  TEST_ASSERT_EQUAL(0, transactions.retry(token, kMaxRetries));
+  TEST_ASSERT_EQUAL(1, transactions.size());
+}
+
+void test_random_faults_close_every_transaction() {
+  constexpr int kRequests = 2000;
+  uint32_t state = 12345;
+  std::vector<int> attempts(kRequests, 0);
+  std::vector<int> faults(kRequests, 0);
+  SimulatedBus bus;
+  bus.fault = [&](int id) {
+    attempts[id]++;
+    state = state * 1664525u + 1013904223u;
+    // 10% each of dropped, delayed and corrupted frames
+    const uint32_t roll = (state >> 16) % 10;
+    const Fault fault = roll == 0   ? Fault::kDrop
+                        : roll == 1 ? Fault::kDelay
+                        : roll == 2 ? Fault::kCorrupt
+                                    : Fault::kNone;
+    faults[id] += fault != Fault::kNone;
+    return fault;
+  };
+
+  std::vector<int> calls(kRequests, 0);
+  std::vector<Error> results(kRequests, Error::kSuccess);
+  int next_id = 0;
+  int rejected = 0;
+  while (next_id < kRequests || !bus.driver_queue.empty()) {
+    // Several tasks add requests before the driver sends the next frame
+    for (int i = 0; i < 3 && next_id < kRequests; i++) {
+      const int id = next_id;
+      const bool sent = bus.send({id, [&calls, &results, id](Error error) {
+                                    calls[id]++;
+                                    results[id] = error;
+                                  }});
+      if (!sent) {
+        rejected++;
+        break;
+      }
+      next_id++;
+    }
+    TEST_ASSERT_TRUE(bus.transactions.size() <= kTableSize);
+    if (!bus.driver_queue.empty()) {
+      bus.transfer();
+    }
+  }
+
+  TEST_ASSERT_EQUAL(0, bus.transactions.size());
+  TEST_ASSERT_TRUE(rejected > 0);
+  for (int id = 0; id < kRequests; id++) {
+    TEST_ASSERT_EQUAL(1, calls[id]);
+    TEST_ASSERT_TRUE(attempts[id] <= 1 + kMaxRetries);
+    // Only fails if the retry failed as well
+    TEST_ASSERT_EQUAL(faults[id] == 1 + kMaxRetries,
+                      results[id] != Error::kSuccess);
+  }
+  TEST_ASSERT_EQUAL(bus.timeouts + bus.crc_errors,
+                    std::accumulate(faults.begin(), faults.end(), 0));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lost_and_corrupted_frames_are_resent_once);
+  RUN_TEST(test_full_table_rejects_requests);
+  RUN_TEST(test_retry_replaces_the_token);
+  RUN_TEST(test_random_faults_close_every_transaction);
+  return UNITY_END();
+}
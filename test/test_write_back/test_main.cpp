@@ -0,0 +1,146 @@
+#include <unity.h>
+
+#include <map>
+#include <string>
+
+#include "managers/write_back.h"
+
+using inamata::WriteBack;
+using Clock = WriteBack::Clock;
+using std::chrono::milliseconds;
+
+namespace {
+
+constexpr milliseconds kDelay{2000};
+
+/// Secrets cached in RAM and written back to a file system in RAM
+struct FakeSecrets {
+  std::string cache;
+  std::map<std::string, std::string> files;
+  WriteBack write_back{kDelay};
+  size_t writes = 0;
+  /// Fail the write with this number, counting from 1
+  size_t fail_write = 0;
+  /// Lose the power while writing the temporary file
+  bool is_power_lost = false;
+
+  void save(const std::string& secrets, Clock::time_point now) {
+    cache = secrets;
+    write_back.markDirty(now);
+  }
+
+  bool handle(Clock::time_point now, bool force = false) {
+    return write_back.handle(
+        now, force,
+        [this]() {
+          if (++writes == fail_write) {
+            return false;
+          }
+          if (is_power_lost) {
+            files["secrets.tmp"] = cache.substr(0, cache.size() / 2);
+            return false;
+          }
+          files["secrets.tmp"] = cache;
+          return true;
+        },
+        [this]() {
+          auto tmp = files.find("secrets.tmp");
+          if (tmp == files.end()) {
+            return false;
+          }
+          files["secrets.json"] = tmp->second;
+          files.erase(tmp);
+          return true;
+        });
+  }
+};
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_writes_once_after_changes_stop() {
+  FakeSecrets secrets;
+  const Clock::time_point start{};
+  // Provisioning saves the WiFi AP, the server URL and the auth token
+  secrets.save("ap", start);
+  TEST_ASSERT_TRUE(secrets.handle(start + milliseconds(100)));
+  secrets.save("ap,url", start + milliseconds(150));
+  secrets.save("ap,url,token", start + milliseconds(300));
+  TEST_ASSERT_TRUE(secrets.handle(start + milliseconds(2100)));
+  TEST_ASSERT_EQUAL(0, secrets.writes);
+  TEST_ASSERT_TRUE(secrets.write_back.isDirty());
+
+  TEST_ASSERT_TRUE(secrets.handle(start + milliseconds(2300)));
+  TEST_ASSERT_EQUAL(1, secrets.writes);
+  TEST_ASSERT_FALSE(secrets.write_back.isDirty());
+  TEST_ASSERT_EQUAL_STRING("ap,url,token",
+                           secrets.files["secrets.json"].c_str());
+  TEST_ASSERT_EQUAL(0, secrets.files.count("secrets.tmp"));
+
+  // Nothing is written without a change
+  TEST_ASSERT_TRUE(secrets.handle(start + milliseconds(10000)));
+  TEST_ASSERT_EQUAL(1, secrets.writes);
+}
+
+void test_force_writes_without_delay() {
+  FakeSecrets secrets;
+  const Clock::time_point start{};
+  secrets.save("token", start);
+  // Like the shutdown handler on a restart right after the change
+  TEST_ASSERT_TRUE(secrets.handle(start + milliseconds(10), true));
+  TEST_ASSERT_EQUAL_STRING("token", secrets.files["secrets.json"].c_str());
+  TEST_ASSERT_TRUE(secrets.handle(start + milliseconds(20), true));
+  TEST_ASSERT_EQUAL(1, secrets.writes);
+}
+
+void test_failed_write_is_retried() {
+  FakeSecrets secrets;
+  const Clock::time_point start{};
+  secrets.files["secrets.json"] = "old";
+  secrets.fail_write = 1;
+  secrets.save("new", start);
+  TEST_ASSERT_FALSE(secrets.handle(start + kDelay));
+  TEST_ASSERT_TRUE(secrets.write_back.isDirty());
+  TEST_ASSERT_EQUAL_STRING("old", secrets.files["secrets.json"].c_str());
+
+  TEST_ASSERT_TRUE(secrets.handle(start + kDelay + milliseconds(250)));
+  TEST_ASSERT_EQUAL_STRING("new", secrets.files["secrets.json"].c_str());
+}
+
+void test_power_loss_keeps_previous_secrets() {
+  FakeSecrets secrets;
+  const Clock::time_point start{};
+  secrets.files["secrets.json"] = "ap,url,token";
+  secrets.save("ap,url,new-token", start);
+  secrets.is_power_lost = true;
+  TEST_ASSERT_FALSE(secrets.handle(start, true));
+
+  // The partial temporary file does not replace the secrets
+  TEST_ASSERT_EQUAL_STRING("ap,url,token",
+                           secrets.files["secrets.json"].c_str());
+  TEST_ASSERT_EQUAL_STRING("ap,url,n", secrets.files["secrets.tmp"].c_str());
+}
+
+void test_discard_drops_pending_write() {
+  FakeSecrets secrets;
+  const Clock::time_point start{};
+  secrets.save("token", start);
+  // A factory reset wiped the file system before the restart
+  secrets.write_back.discard();
+  TEST_ASSERT_TRUE(secrets.handle(start + kDelay, true));
+  TEST_ASSERT_EQUAL(0, secrets.writes);
+  TEST_ASSERT_TRUE(secrets.files.empty());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_writes_once_after_changes_stop);
+  RUN_TEST(test_force_writes_without_delay);
+  RUN_TEST(test_failed_write_is_retried);
+  RUN_TEST(test_power_loss_keeps_previous_secrets);
+  RUN_TEST(test_discard_drops_pending_write);
+  return UNITY_END();
+}
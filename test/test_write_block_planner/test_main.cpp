@@ -0,0 +1,89 @@
+#include <unity.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "peripheral/peripherals/modbus/write_block_planner.h"
+
+using inamata::peripheral::peripherals::modbus::planWriteBlocks;
+using inamata::peripheral::peripherals::modbus::WriteBlock;
+
+namespace {
+
+/// Max registers of a write multiple registers request
+constexpr uint16_t kMaxWriteRegisters = 123;
+/// Max coils of a write multiple coils request
+constexpr uint16_t kMaxWriteCoils = 1968;
+
+void assertBlocks(const std::vector<WriteBlock>& expected,
+                  const std::vector<WriteBlock>& actual) {
+  TEST_ASSERT_EQUAL(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    TEST_ASSERT_EQUAL(expected[i].address, actual[i].address);
+    TEST_ASSERT_EQUAL(expected[i].size, actual[i].size);
+  }
+}
+
+std::vector<uint16_t> addressRange(uint16_t first, uint32_t count) {
+  std::vector<uint16_t> addresses;
+  for (uint32_t i = 0; i < count; i++) {
+    addresses.push_back(first + i);
+  }
+  return addresses;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_no_writes() {
+  assertBlocks({}, planWriteBlocks({}, kMaxWriteRegisters));
+}
+
+void test_single_write() {
+  assertBlocks({{7, 1}}, planWriteBlocks({7}, kMaxWriteRegisters));
+}
+
+void test_combines_consecutive_writes() {
+  // Four relay outputs of a board and a separate one
+  const std::vector<uint16_t> addresses = {0, 1, 2, 3, 10};
+  assertBlocks({{0, 4}, {10, 1}},
+               planWriteBlocks(addresses, kMaxWriteRegisters));
+}
+
+void test_gaps_split_blocks() {
+  const std::vector<uint16_t> addresses = {2, 4, 5, 7};
+  assertBlocks({{2, 1}, {4, 2}, {7, 1}},
+               planWriteBlocks(addresses, kMaxWriteRegisters));
+}
+
+void test_splits_at_max_registers() {
+  const std::vector<uint16_t> addresses = addressRange(100, 250);
+  assertBlocks({{100, 123}, {223, 123}, {346, 4}},
+               planWriteBlocks(addresses, kMaxWriteRegisters));
+}
+
+void test_splits_at_max_coils() {
+  const std::vector<uint16_t> addresses = addressRange(0, 2000);
+  assertBlocks({{0, 1968}, {1968, 32}},
+               planWriteBlocks(addresses, kMaxWriteCoils));
+}
+
+void test_last_address() {
+  const std::vector<uint16_t> addresses = {0xFFFE, 0xFFFF};
+  assertBlocks({{0xFFFE, 2}}, planWriteBlocks(addresses, kMaxWriteRegisters));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_writes);
+  RUN_TEST(test_single_write);
+  RUN_TEST(test_combines_consecutive_writes);
+  RUN_TEST(test_gaps_split_blocks);
+  RUN_TEST(test_splits_at_max_registers);
+  RUN_TEST(test_splits_at_max_coils);
+  RUN_TEST(test_last_address);
+  return UNITY_END();
+}